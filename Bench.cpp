@@ -0,0 +1,282 @@
+//talgov44@gmail.com
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Baron.hpp"
+#include "GamePool.hpp"
+#include "GameState.hpp"
+#include "Instrument.hpp"
+#include "PerfCounters.hpp"
+
+using namespace coup;
+using namespace std;
+
+// Every heap allocation in the process is counted by the hook in
+// src/Instrument.cpp, which the Makefile turns on for this binary with
+// -DCOUP_COUNT_ALLOCATIONS, so the harness can report allocations per
+// operation. Instrumented builds also count them per engine entry point.
+
+namespace
+{
+    // Games stepped per sample. Each sample restores every game to the
+    // benchmark's start state, untimed, then times one operation on each.
+    const size_t GAMES_PER_SAMPLE = 32;
+
+    // Back-to-back clock reads used to estimate the cost of one timing.
+    const size_t CLOCK_CALIBRATION_READS = 10000;
+
+    /**
+     * @brief One operation to measure.
+     *
+     * Seat 0 plays `actor` and seat 1 plays `other`; any further seats are
+     * plain players. setup() runs once on a fresh game to reach the start
+     * state, which is then captured and restored before every sample.
+     */
+    struct Benchmark
+    {
+        const char *name;
+        Role actor;
+        Role other;
+        size_t min_players;
+        void (*setup)(PooledGame &table);
+        void (*run)(PooledGame &table);
+    };
+
+    volatile size_t sink = 0; // Keeps string results alive so the calls are not optimised away.
+
+    Player &seat(PooledGame &table, size_t i)
+    {
+        return table.players[i];
+    }
+
+    void no_setup(PooledGame &) {}
+
+    const Benchmark BENCHMARKS[] = {
+        {"gather", Role::Player, Role::Player, 2, no_setup, [](PooledGame &t)
+         { seat(t, 0).gather(); }},
+        {"tax", Role::Player, Role::Player, 2, no_setup, [](PooledGame &t)
+         { seat(t, 0).tax(); }},
+        {"bribe", Role::Player, Role::Player, 2, [](PooledGame &t)
+         { seat(t, 0).addCoins(4); }, [](PooledGame &t)
+         { seat(t, 0).bribe(); }},
+        {"arrest", Role::Player, Role::Player, 2, [](PooledGame &t)
+         { seat(t, 1).addCoins(1); }, [](PooledGame &t)
+         { seat(t, 0).arrest(seat(t, 1)); }},
+        {"sanction", Role::Player, Role::Player, 2, [](PooledGame &t)
+         { seat(t, 0).addCoins(3); }, [](PooledGame &t)
+         { seat(t, 0).sanction(seat(t, 1)); }},
+        {"coup", Role::Player, Role::Player, 2, [](PooledGame &t)
+         { seat(t, 0).addCoins(7); }, [](PooledGame &t)
+         { seat(t, 0).coup(seat(t, 1)); }},
+        {"invest", Role::Baron, Role::Player, 2, [](PooledGame &t)
+         { seat(t, 0).addCoins(3); }, [](PooledGame &t)
+         { static_cast<Baron &>(seat(t, 0)).invest(); }},
+        {"undo[Governor]", Role::Player, Role::Governor, 2, [](PooledGame &t)
+         { seat(t, 0).tax(); }, [](PooledGame &t)
+         { seat(t, 1).undo(seat(t, 0)); }},
+        {"undo[Judge]", Role::Player, Role::Judge, 2, [](PooledGame &t)
+         {
+             seat(t, 0).addCoins(4);
+             seat(t, 0).bribe();
+         },
+         [](PooledGame &t)
+         { seat(t, 1).undo(seat(t, 0)); }},
+        {"undo[Spy]", Role::Player, Role::Spy, 2, [](PooledGame &t)
+         {
+             seat(t, 1).addCoins(1);
+             seat(t, 0).arrest(seat(t, 1));
+         },
+         [](PooledGame &t)
+         { seat(t, 1).undo(seat(t, 0)); }},
+        {"undo[General]", Role::Player, Role::General, 3, [](PooledGame &t)
+         {
+             seat(t, 0).addCoins(7);
+             seat(t, 1).addCoins(5);
+             seat(t, 0).coup(seat(t, 2));
+         },
+         [](PooledGame &t)
+         { seat(t, 1).undo(seat(t, 2)); }},
+        {"Game::turn", Role::Player, Role::Player, 2, [](PooledGame &t)
+         { t.game.turn(); }, [](PooledGame &t)
+         { sink += t.game.turn().size(); }},
+        {"Game::players", Role::Player, Role::Player, 2, no_setup, [](PooledGame &t)
+         { sink += t.game.players().size(); }},
+        {"Game::winner", Role::Player, Role::Player, 2, [](PooledGame &t)
+         {
+             t.game.turn();
+             for (size_t i = 1; i < t.players.size(); ++i)
+             {
+                 seat(t, i).eliminate();
+             }
+         },
+         [](PooledGame &t)
+         { sink += t.game.winner().size(); }},
+    };
+
+    struct Result
+    {
+        double median;
+        double p99;
+        double allocations;
+        PerfSample events; // Summed over every timed operation.
+        size_t operations;
+    };
+
+    double percentile(vector<double> &sorted, double p)
+    {
+        const size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+
+    /**
+     * @brief Median cost, in nanoseconds, of the two clock reads around one operation.
+     *
+     * Subtracted from every single-operation time so the median and p99
+     * report the operation rather than the clock.
+     */
+    double clock_overhead()
+    {
+        vector<double> reads;
+        reads.reserve(CLOCK_CALIBRATION_READS);
+        for (size_t i = 0; i < CLOCK_CALIBRATION_READS; ++i)
+        {
+            const auto begin = chrono::steady_clock::now();
+            const auto end = chrono::steady_clock::now();
+            reads.push_back(chrono::duration<double, nano>(end - begin).count());
+        }
+        sort(reads.begin(), reads.end());
+        return percentile(reads, 0.5);
+    }
+
+    Result measure(const Benchmark &bench, size_t players, size_t samples, double overhead, const PerfCounters &perf)
+    {
+        vector<Role> lineup(players, Role::Player);
+        lineup[0] = bench.actor;
+        lineup[1] = bench.other;
+
+        GamePool pool;
+        unique_ptr<PooledGame> start = pool.acquire(lineup);
+        bench.setup(*start);
+        const GameState state = GameState::capture(start->game);
+
+        vector<unique_ptr<PooledGame>> tables;
+        for (size_t i = 0; i < GAMES_PER_SAMPLE; ++i)
+        {
+            tables.push_back(pool.acquire(lineup));
+        }
+
+        vector<double> ns_per_op;
+        ns_per_op.reserve(samples * GAMES_PER_SAMPLE);
+        size_t allocated = 0;
+        PerfSample events;
+        const size_t warmup = samples / 10;
+        for (size_t s = 0; s < warmup + samples; ++s)
+        {
+            for (unique_ptr<PooledGame> &table : tables)
+            {
+                state.restore(table->game);
+            }
+            const size_t allocations_before = total_allocations();
+            const PerfSample events_before = perf.read();
+            double timed[GAMES_PER_SAMPLE];
+            for (size_t g = 0; g < GAMES_PER_SAMPLE; ++g)
+            {
+                const auto begin = chrono::steady_clock::now();
+                bench.run(*tables[g]);
+                const auto end = chrono::steady_clock::now();
+                timed[g] = chrono::duration<double, nano>(end - begin).count();
+            }
+            const PerfSample batch = perf.since(events_before);
+            if (s < warmup)
+            {
+                continue;
+            }
+            allocated += total_allocations() - allocations_before;
+            events += batch;
+            for (double ns : timed)
+            {
+                ns_per_op.push_back(max(0.0, ns - overhead));
+            }
+        }
+
+        sort(ns_per_op.begin(), ns_per_op.end());
+        Result result;
+        result.median = percentile(ns_per_op, 0.5);
+        result.p99 = percentile(ns_per_op, 0.99);
+        result.operations = samples * GAMES_PER_SAMPLE;
+        result.allocations = static_cast<double>(allocated) / static_cast<double>(result.operations);
+        result.events = events;
+        return result;
+    }
+}
+
+// Usage: ./Bench [samples] [name filter]
+// Times every operation on its own, minus the calibrated cost of the clock
+// reads, for every benchmark at 2 to 6 players; prints one row per pair.
+// Instrumented builds also print the allocations of each engine entry point.
+// Where Linux perf events are allowed, hardware counts per op are added.
+int main(int argc, char *argv[])
+{
+    const size_t samples = argc > 1 ? stoul(argv[1]) : 2000;
+    const string filter = argc > 2 ? argv[2] : "";
+    const PerfCounters perf;
+    const double overhead = clock_overhead();
+
+    if (!perf.available())
+    {
+        cout << "perf counters unavailable: " << perf.error() << "\n";
+    }
+    cout << "clock overhead: " << fixed << setprecision(1) << overhead << " ns (subtracted)\n";
+    cout << left << setw(16) << "benchmark" << right << setw(8) << "players"
+         << setw(12) << "median ns" << setw(12) << "p99 ns" << setw(12) << "allocs/op";
+    if (perf.available())
+    {
+        cout << setw(12) << "cycles/op" << setw(12) << "instrs/op" << setw(12) << "cmiss/op" << setw(12) << "bmiss/op";
+    }
+    cout << "\n";
+    cout << fixed << setprecision(1);
+    for (const Benchmark &bench : BENCHMARKS)
+    {
+        if (string(bench.name).find(filter) == string::npos)
+        {
+            continue;
+        }
+        for (size_t players = max<size_t>(2, bench.min_players); players <= GameState::MAX_PLAYERS; ++players)
+        {
+            const Result result = measure(bench, players, samples, overhead, perf);
+            cout << left << setw(16) << bench.name << right << setw(8) << players
+                 << setw(12) << result.median << setw(12) << result.p99
+                 << setw(12) << setprecision(2) << result.allocations << setprecision(1);
+            if (perf.available())
+            {
+                const double n = static_cast<double>(result.operations);
+                cout << setw(12) << result.events.cycles / n << setw(12) << result.events.instructions / n
+                     << setw(12) << setprecision(3) << result.events.cache_misses / n
+                     << setw(12) << result.events.branch_misses / n << setprecision(1);
+            }
+            cout << "\n";
+        }
+    }
+
+    if (allocation_tracking_enabled())
+    {
+        cout << "\n"
+             << left << setw(16) << "entry point" << right << setw(14) << "calls"
+             << setw(12) << "allocs/call" << setw(12) << "bytes/call" << "\n";
+        for (size_t i = 0; i < ENTRY_POINT_COUNT; ++i)
+        {
+            const EntryPoint point = static_cast<EntryPoint>(i);
+            const AllocationStats stats = allocation_stats(point);
+            const double bytes = stats.calls == 0 ? 0.0 : static_cast<double>(stats.bytes) / stats.calls;
+            cout << left << setw(16) << to_string(point) << right << setw(14) << stats.calls
+                 << setw(12) << setprecision(2) << stats.per_call() << setw(12) << setprecision(1) << bytes << "\n";
+        }
+    }
+    return 0;
+}
@@ -1,6 +1,7 @@
 //talgov44@gmail.com
 
 #include <SFML/Graphics.hpp>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -14,6 +15,7 @@
 #include "Merchant.hpp"
 #include "Spy.hpp"
 #include "Baron.hpp"
+#include "Trace.hpp"
 
 using namespace coup;
 using namespace std;
@@ -151,171 +153,189 @@ int main()
     {
 
         // --- Event Handling ---
-        sf::Event event;
-        while (window.pollEvent(event))
         {
-            if (event.type == sf::Event::Closed)
+            COUP_TRACE_SPAN("Demo::events");
+            sf::Event event;
+            while (window.pollEvent(event))
             {
-                window.close();
-            }
-            if (!is_game_over && event.type == sf::Event::MouseButtonPressed)
-            {
-                if (event.mouseButton.button == sf::Mouse::Left)
+                if (event.type == sf::Event::Closed)
+                {
+                    window.close();
+                }
+#ifdef COUP_TRACE
+                // T writes the spans recorded so far, engine and GUI, as a Chrome trace.
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::T)
                 {
+                    ofstream trace_file("coup_trace.json");
+                    write_chrome_trace(trace_file);
+                    message_text.setString("Trace written to coup_trace.json");
+                }
+#endif
+                if (!is_game_over && event.type == sf::Event::MouseButtonPressed)
+                {
+                    if (event.mouseButton.button == sf::Mouse::Left)
+                    {
 
-                    sf::Vector2f mousePos = window.mapPixelToCoords({event.mouseButton.x, event.mouseButton.y});
+                        sf::Vector2f mousePos = window.mapPixelToCoords({event.mouseButton.x, event.mouseButton.y});
 
-                    // Reset message on new action
-                    message_text.setString("");
+                        // Reset message on new action
+                        message_text.setString("");
 
-                    // Check for player panel clicks to select a target
-                    for (const auto &panel : player_panels)
-                    {
-                        if (panel.isClicked(mousePos) && panel.player_ref != current_player && panel.player_ref->isActive())
+                        // Check for player panel clicks to select a target
+                        for (const auto &panel : player_panels)
                         {
-                            selected_target = panel.player_ref;
-                            break;
+                            if (panel.isClicked(mousePos) && panel.player_ref != current_player && panel.player_ref->isActive())
+                            {
+                                selected_target = panel.player_ref;
+                                break;
+                            }
                         }
-                    }
 
-                    // Check for button clicks
-                    try
-                    {
-                        if (buttons.at("gather").isClicked(mousePos))
-                        {
-                            current_player->gather();
-                        }
-                        else if (buttons.at("tax").isClicked(mousePos))
-                        {
-                            current_player->tax();
-                        }
-                        else if (buttons.at("bribe").isClicked(mousePos))
+                        // Check for button clicks
+                        try
                         {
-                            current_player->bribe();
-                            message_text.setString("Bribe paid. Perform another action.");
-                        }
-                        else if (buttons.at("invest").isClicked(mousePos))
-                        {
-                            if (auto *baron = dynamic_cast<Baron *>(current_player))
+                            if (buttons.at("gather").isClicked(mousePos))
                             {
-                                baron->invest();
+                                current_player->gather();
                             }
-                        }
-                        else if (selected_target)
-                        { // Actions that require a target
-                            if (buttons.at("coup").isClicked(mousePos))
+                            else if (buttons.at("tax").isClicked(mousePos))
                             {
-                                current_player->coup(*selected_target);
-                                selected_target = nullptr;
+                                current_player->tax();
                             }
-                            else if (buttons.at("arrest").isClicked(mousePos))
+                            else if (buttons.at("bribe").isClicked(mousePos))
                             {
-                                current_player->arrest(*selected_target);
-                                selected_target = nullptr;
+                                current_player->bribe();
+                                message_text.setString("Bribe paid. Perform another action.");
                             }
-                            else if (buttons.at("sanction").isClicked(mousePos))
+                            else if (buttons.at("invest").isClicked(mousePos))
                             {
-                                current_player->sanction(*selected_target);
-                                selected_target = nullptr;
+                                if (auto *baron = dynamic_cast<Baron *>(current_player))
+                                {
+                                    baron->invest();
+                                }
+                            }
+                            else if (selected_target)
+                            { // Actions that require a target
+                                if (buttons.at("coup").isClicked(mousePos))
+                                {
+                                    current_player->coup(*selected_target);
+                                    selected_target = nullptr;
+                                }
+                                else if (buttons.at("arrest").isClicked(mousePos))
+                                {
+                                    current_player->arrest(*selected_target);
+                                    selected_target = nullptr;
+                                }
+                                else if (buttons.at("sanction").isClicked(mousePos))
+                                {
+                                    current_player->sanction(*selected_target);
+                                    selected_target = nullptr;
+                                }
                             }
                         }
-                    }
-                    catch (const std::exception &e)
-                    {
-                        message_text.setString(e.what());
-                    }
+                        catch (const std::exception &e)
+                        {
+                            message_text.setString(e.what());
+                        }
 
-                    try
-                    {
-                        string current_turn_name = game.turn();
-                        current_player = player_map.at(current_turn_name);
-                        turn_text.setString("Turn: " + current_turn_name);
-                    }
-                    catch (const exception &e)
-                    {
-                        is_game_over = true;
-                        turn_text.setString("Game Over! Winner: " + game.winner());
+                        try
+                        {
+                            string current_turn_name = game.turn();
+                            current_player = player_map.at(current_turn_name);
+                            turn_text.setString("Turn: " + current_turn_name);
+                        }
+                        catch (const exception &e)
+                        {
+                            is_game_over = true;
+                            turn_text.setString("Game Over! Winner: " + game.winner());
+                        }
                     }
                 }
             }
         }
 
         // --- Update GUI Elements ---
-        // Disable all buttons by default
-        for (auto &pair : buttons)
         {
-            pair.second.enabled = false;
-            pair.second.shape.setFillColor(sf::Color(100, 100, 100));
-        }
-
-        if (current_player && !is_game_over)
-        {
-            // Enable buttons based on game state
-            buttons["gather"].enabled = current_player->coins() < 10;
-            buttons["tax"].enabled = current_player->coins() < 10;
-            buttons["bribe"].enabled = current_player->coins() >= 4 && current_player->coins() < 10;
-
-            bool can_target = selected_target != nullptr;
-            buttons["arrest"].enabled = can_target && current_player->coins() < 10;
-            buttons["sanction"].enabled = can_target && current_player->coins() >= 3 && current_player->coins() < 10;
-            buttons["coup"].enabled = can_target && current_player->coins() >= 7;
-
-            if (auto *baron = dynamic_cast<Baron *>(current_player))
+            COUP_TRACE_SPAN("Demo::update");
+            // Disable all buttons by default
+            for (auto &pair : buttons)
             {
-                buttons["invest"].enabled = baron->coins() >= 3 && baron->coins() < 10;
+                pair.second.enabled = false;
+                pair.second.shape.setFillColor(sf::Color(100, 100, 100));
             }
 
-            // Recolor enabled buttons
-            for (auto &pair : buttons)
+            if (current_player && !is_game_over)
             {
-                if (pair.second.enabled)
+                // Enable buttons based on the actions the game reports as legal
+                LegalActions legal = game.legal_actions(*current_player);
+                buttons["gather"].enabled = legal.can(ActionType::Gather);
+                buttons["tax"].enabled = legal.can(ActionType::Tax);
+                buttons["bribe"].enabled = legal.can(ActionType::Bribe);
+                buttons["invest"].enabled = legal.can(ActionType::Invest);
+
+                if (selected_target != nullptr)
+                {
+                    size_t target_seat = game.seat_of(*selected_target);
+                    buttons["arrest"].enabled = legal.can(ActionType::Arrest, target_seat);
+                    buttons["sanction"].enabled = legal.can(ActionType::Sanction, target_seat);
+                    buttons["coup"].enabled = legal.can(ActionType::Coup, target_seat);
+                }
+
+                // Recolor enabled buttons
+                for (auto &pair : buttons)
                 {
-                    pair.second.shape.setFillColor(sf::Color(0, 150, 0));
+                    if (pair.second.enabled)
+                    {
+                        pair.second.shape.setFillColor(sf::Color(0, 150, 0));
+                    }
                 }
             }
         }
 
         // --- Drawing ---
-        window.clear(sf::Color(20, 40, 60));
-        window.draw(title);
-        window.draw(turn_text);
-
-        // Draw Player Panels
-        for (auto &panel : player_panels)
         {
-            Player *p = panel.player_ref;
-            panel.text.setString(p->getName() + " (" + p->role() + ") | Coins: " + to_string(p->coins()));
-            panel.text.setPosition(panel.shape.getPosition().x + 15, panel.shape.getPosition().y + 10);
-
-            panel.shape.setOutlineThickness(2);
-            panel.shape.setOutlineColor(sf::Color::White);
+            COUP_TRACE_SPAN("Demo::draw");
+            window.clear(sf::Color(20, 40, 60));
+            window.draw(title);
+            window.draw(turn_text);
 
-            if (!p->isActive())
-            {
-                panel.shape.setFillColor(sf::Color(80, 20, 20));
-            }
-            else if (p == current_player)
+            // Draw Player Panels
+            for (auto &panel : player_panels)
             {
-                panel.shape.setFillColor(sf::Color(50, 80, 120));
+                Player *p = panel.player_ref;
+                panel.text.setString(p->getName() + " (" + p->role() + ") | Coins: " + to_string(p->coins()));
+                panel.text.setPosition(panel.shape.getPosition().x + 15, panel.shape.getPosition().y + 10);
+
+                panel.shape.setOutlineThickness(2);
+                panel.shape.setOutlineColor(sf::Color::White);
+
+                if (!p->isActive())
+                {
+                    panel.shape.setFillColor(sf::Color(80, 20, 20));
+                }
+                else if (p == current_player)
+                {
+                    panel.shape.setFillColor(sf::Color(50, 80, 120));
+                }
+                else if (p == selected_target)
+                {
+                    panel.shape.setFillColor(sf::Color(120, 110, 50));
+                } // Highlight selected target
+                else
+                {
+                    panel.shape.setFillColor(sf::Color(50, 50, 50));
+                }
+
+                panel.draw(window);
             }
-            else if (p == selected_target)
-            {
-                panel.shape.setFillColor(sf::Color(120, 110, 50));
-            } // Highlight selected target
-            else
+
+            for (auto &[key, val] : buttons)
             {
-                panel.shape.setFillColor(sf::Color(50, 50, 50));
+                val.draw(window);
             }
-
-            panel.draw(window);
-        }
-
-        for (auto &[key, val] : buttons)
-        {
-            val.draw(window);
+            window.draw(message_text);
+            window.display();
         }
-        window.draw(message_text);
-        window.display();
     }
 
     return 0;
@@ -0,0 +1,156 @@
+//talgov44@gmail.com
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Instrument.hpp"
+#include "Mcts.hpp"
+#include "Simulator.hpp"
+#include "Tournament.hpp"
+
+using namespace coup;
+using namespace std;
+
+namespace
+{
+    // Instrumented builds time every engine call; print their percentiles.
+    void print_latencies()
+    {
+        if (latency_recording_enabled())
+        {
+            cout << "\n";
+            write_latency_snapshot(cout);
+        }
+    }
+
+    // Average hardware counts per call of each action type.
+    void print_perf(const PerfByAction &perf)
+    {
+        PerfCounters probe;
+        if (!probe.available())
+        {
+            cout << "perf counters unavailable: " << probe.error() << "\n";
+            return;
+        }
+        cout << left << setw(10) << "action" << right << setw(12) << "calls" << setw(12) << "cycles"
+             << setw(12) << "instrs" << setw(12) << "IPC" << setw(12) << "cache miss" << setw(12) << "br miss" << "\n";
+        cout << fixed << setprecision(2);
+        for (size_t i = 0; i < ACTION_TYPE_COUNT; ++i)
+        {
+            const uint64_t calls = perf.calls[i];
+            if (calls == 0)
+            {
+                continue;
+            }
+            const PerfSample &total = perf.totals[i];
+            const double n = static_cast<double>(calls);
+            cout << left << setw(10) << to_string(static_cast<ActionType>(i)) << right << setw(12) << calls
+                 << setw(12) << total.cycles / n << setw(12) << total.instructions / n
+                 << setw(12) << (total.cycles == 0 ? 0.0 : static_cast<double>(total.instructions) / total.cycles)
+                 << setw(12) << total.cache_misses / n << setw(12) << total.branch_misses / n << "\n";
+        }
+    }
+}
+
+// Usage: ./Simulate [games] [seed] [random|greedy|mcts] [threads] [--perf]
+// Passing a thread count runs the games as a multi-threaded tournament.
+// --perf reads hardware counters around every action of a single-threaded
+// run and reports them per action type. Instrumented builds also print
+// latency percentiles of every engine call.
+int main(int argc, char *argv[])
+{
+    char **const end = remove_if(argv + 1, argv + argc, [](const char *arg)
+                                 { return string(arg) == "--perf"; });
+    const bool perf = end != argv + argc;
+    argc = static_cast<int>(end - argv);
+
+    SimulationConfig config;
+    config.perf_counters = perf;
+    config.lineup = {Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge, Role::Merchant};
+    config.games = argc > 1 ? stoul(argv[1]) : 100000;
+    config.seed = argc > 2 ? stoull(argv[2]) : 1;
+    const string policy_name = argc > 3 ? argv[3] : "random";
+
+    PolicyFactory make_policy;
+    if (policy_name == "random")
+    {
+        make_policy = []
+        { return unique_ptr<Policy>(new RandomPolicy()); };
+    }
+    else if (policy_name == "greedy")
+    {
+        make_policy = []
+        { return unique_ptr<Policy>(new GreedyPolicy()); };
+    }
+    else if (policy_name == "mcts")
+    {
+        make_policy = []
+        {
+            MctsConfig mcts;
+            mcts.iterations = 1000;
+            return unique_ptr<Policy>(new MctsPolicy(mcts));
+        };
+    }
+    else
+    {
+        cerr << "Unknown policy: " << policy_name << endl;
+        return 1;
+    }
+
+    if (argc > 4)
+    {
+        if (perf)
+        {
+            cerr << "--perf is ignored by tournament runs." << endl;
+        }
+        const size_t threads = stoul(argv[4]);
+        const size_t games_per_match = 1000;
+        const size_t seats = config.lineup.size();
+        const size_t rounds = (config.games + games_per_match * seats - 1) / (games_per_match * seats);
+
+        Tournament tournament(config.max_actions);
+        size_t entrant = tournament.add_entrant(policy_name, make_policy);
+        tournament.add_rotations(config.lineup, vector<size_t>(seats, entrant), games_per_match, rounds, config.seed);
+        TournamentResult result = tournament.run(threads);
+
+        cout << "matches:      " << result.matches << "\n";
+        cout << "games:        " << result.games << "\n";
+        cout << "actions:      " << result.actions << "\n";
+        cout << "draws:        " << result.draws << "\n";
+        cout << "seconds:      " << result.seconds << "\n";
+        cout << "games/sec:    " << result.games_per_second() << "\n";
+        for (Role role : config.lineup)
+        {
+            const TournamentStats &stats = result.by_role[static_cast<size_t>(role)];
+            cout << "win rate[" << to_string(role) << "]: " << stats.win_rate() << "\n";
+        }
+        print_latencies();
+        return 0;
+    }
+
+    unique_ptr<Policy> policy = make_policy();
+    Simulator simulator(config, vector<Policy *>(config.lineup.size(), policy.get()));
+    SimulationStats stats = simulator.run();
+
+    cout << "games:        " << stats.games << "\n";
+    cout << "actions:      " << stats.actions << "\n";
+    cout << "undos:        " << stats.undos << "\n";
+    cout << "draws:        " << stats.draws << "\n";
+    cout << "seconds:      " << stats.seconds << "\n";
+    cout << "games/sec:    " << stats.games_per_second() << "\n";
+    cout << "actions/sec:  " << stats.actions_per_second() << "\n";
+    for (size_t i = 0; i < stats.wins_by_seat.size(); ++i)
+    {
+        cout << "wins[" << to_string(config.lineup[i]) << "]: " << stats.wins_by_seat[i] << "\n";
+    }
+    if (perf)
+    {
+        print_perf(stats.perf);
+    }
+    print_latencies();
+    return 0;
+}
@@ -0,0 +1,37 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace coup
+{
+    // Every action a player can take, including the reactive undo.
+    enum class ActionType : std::uint8_t
+    {
+        None,
+        Gather,
+        Tax,
+        Bribe,
+        Arrest,
+        Sanction,
+        Coup,
+        Invest,
+        Undo
+    };
+
+    const size_t ACTION_TYPE_COUNT = 9;
+
+    const int NO_TARGET = -1;
+
+    // A concrete action choice: the action type and, for targeted actions,
+    // the index of the target in Game::get_players().
+    struct Action
+    {
+        ActionType type = ActionType::None;
+        int target = NO_TARGET;
+    };
+
+    const char *to_string(ActionType type);
+}
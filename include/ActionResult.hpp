@@ -0,0 +1,35 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstdint>
+
+namespace coup
+{
+    // Outcome of a try_* action. Everything except Ok means the rules refused
+    // the action; Sanctioned additionally means the turn was spent.
+    enum class ActionResult : std::uint8_t
+    {
+        Ok,
+        NoPlayers,
+        NotEnoughPlayers,
+        GameOver,
+        PlayerNotActive,
+        NotYourTurn,
+        MustCoup,
+        Sanctioned,
+        NotEnoughCoins,
+        InvalidTarget,
+        RepeatArrest,
+        TargetCannotPay,
+        CannotUndo,
+        NothingToUndo,
+        UndoWindowClosed
+    };
+
+    // Static, human readable description of a result. Never allocates.
+    const char *describe(ActionResult result);
+
+    // Throws std::runtime_error carrying describe(result) unless result is Ok.
+    void throw_if_failed(ActionResult result);
+}
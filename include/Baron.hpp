@@ -14,5 +14,6 @@ namespace coup
 
         // Baron's special action
         void invest();
+        ActionResult try_invest();
     };
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Action.hpp"
+#include "ActionResult.hpp"
+#include "GameState.hpp"
+#include "Role.hpp"
+
+namespace coup
+{
+    // Instruction set used by BatchEngine::step().
+    enum class BatchIsa : std::uint8_t
+    {
+        Scalar,
+        Sse2, // 16 games per instruction.
+        Avx2  // 32 games per instruction.
+    };
+
+    const char *to_string(BatchIsa isa);
+
+    /**
+     * @brief Many started games stored as structure of arrays, stepped with SIMD.
+     *
+     * Every field is a byte array with one entry per game, so one vector
+     * register holds the same field of 16 or 32 games. Coins and roles are
+     * stored seat-major (all games' seat 0, then all games' seat 1, ...), and
+     * the active, sanctioned and extra-action flags are bitmasks with one bit
+     * per seat.
+     *
+     * step() plays the economic actions: gather, tax, invest, bribe and coup.
+     * Each game's current player plays its own action. The results and state
+     * changes match apply_action(), including forfeited turns, the extra
+     * action after a bribe and the Merchant's bonus at the start of a turn.
+     * Arrests, sanctions and undos need per-player history that the batch does
+     * not keep, so they are not supported. The kernel is written once with
+     * GCC vector types. It is compiled for AVX2 and SSE2 and picked at run
+     * time, and games that do not fill a whole vector use the scalar code.
+     */
+    class BatchEngine
+    {
+    private:
+        size_t _games;
+        size_t _players;
+        std::vector<std::uint8_t> _coins; // [seat * _games + game]
+        std::vector<std::uint8_t> _roles; // [seat * _games + game]
+        std::vector<std::uint8_t> _active;
+        std::vector<std::uint8_t> _sanctioned;
+        std::vector<std::uint8_t> _extra;
+        std::vector<std::uint8_t> _turn;
+        BatchIsa _isa;
+
+    public:
+        // Every game starts like a new Game with this lineup.
+        BatchEngine(size_t games, const std::vector<Role> &lineup);
+
+        // Fastest instruction set this CPU supports.
+        static BatchIsa best_isa();
+
+        size_t games() const;
+        size_t players() const;
+        BatchIsa isa() const;
+        // Throws if this CPU does not support `isa`.
+        void set_isa(BatchIsa isa);
+
+        int coins(size_t game, size_t seat) const;
+        size_t turn(size_t game) const;
+        bool is_active(size_t game, size_t seat) const;
+
+        // Copies the batched fields of `state`, which must have players() seats.
+        void load(size_t game, const GameState &state);
+        // A started GameState with the batched fields of `game`. History fields
+        // (last actions and arrests, save target) are left empty.
+        GameState store(size_t game) const;
+
+        // Plays actions[g] for the current player of every game g. Targets are
+        // only read for coups. Writes one result per game.
+        void step(const ActionType *actions, const std::int8_t *targets, ActionResult *results);
+    };
+}
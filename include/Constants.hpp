@@ -0,0 +1,32 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+
+namespace coup
+{
+    // Rule constants shared by the player actions and the rule queries in Game.
+    const int TAX_AMOUNT = 2;
+    const int GOVERNOR_TAX_AMOUNT = 3;
+    const int BRIBE_COST = 4;
+    const int SANCTION_COST = 3;
+    const int COUP_COST = 7;
+    const int MUST_COUP_COINS = 10;
+    const int INVEST_COST = 3;
+    const int INVEST_RETURN = 6;
+    const int GENERAL_UNDO_COST = 5;
+    const int JUDGE_SANCTION_PENALTY = 1;
+    const int MERCHANT_ARREST_PENALTY = 2;
+    const int MERCHANT_BONUS_THRESHOLD = 3;
+    const int BARON_SANCTION_COMPENSATION = 1;
+
+    // Table size. A Game seats DEFAULT_MAX_PLAYERS unless it is constructed
+    // as a larger lobby; seat handles are 16-bit, which sets the upper limit.
+    // Game::legal_actions() returns 64-bit target masks and only works up to
+    // LEGAL_ACTIONS_MAX_SEATS; larger lobbies check actions with is_legal().
+    const size_t MIN_PLAYERS = 2;
+    const size_t DEFAULT_MAX_PLAYERS = 6;
+    const size_t MAX_LOBBY_PLAYERS = 32767;
+    const size_t LEGAL_ACTIONS_MAX_SEATS = 64;
+}
@@ -0,0 +1,88 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Action.hpp"
+#include "ActionResult.hpp"
+
+namespace coup
+{
+    class Game;
+
+    enum class EventKind : std::uint8_t
+    {
+        Turn,      // Game::turn() announced the current player.
+        Action,    // A turn action was performed (or forfeited while sanctioned).
+        Undo,      // A role undid another player's action.
+        SpyReport  // A Spy looked at another player's coins.
+    };
+
+    const std::uint16_t NO_SEAT = 0xFFFF;
+
+    /**
+     * @brief Fixed-width record of one thing that happened in a game.
+     *
+     * Players are identified by seat index. The deltas are the coin changes
+     * of the actor and target caused by the event; for a SpyReport,
+     * target_delta holds the number of coins the spy saw.
+     */
+    struct GameEvent
+    {
+        EventKind kind;
+        ActionType action;
+        ActionResult result;
+        std::uint8_t reserved;
+        std::uint16_t actor;
+        std::uint16_t target;
+        std::int16_t actor_delta;
+        std::int16_t target_delta;
+    };
+
+    /**
+     * @brief Receives game events. Attach one with Game::set_event_sink().
+     *
+     * A game without a sink (the default) skips event construction entirely,
+     * which makes "no sink" the zero-cost null sink.
+     */
+    class EventSink
+    {
+    public:
+        virtual ~EventSink() = default;
+        virtual void record(const Game &game, const GameEvent &event) = 0;
+    };
+
+    // Formats events as text lines and writes them to a stream in large chunks.
+    class TextEventSink : public EventSink
+    {
+    private:
+        std::ostream &_out;
+        std::string _buffer;
+        size_t _capacity;
+
+    public:
+        explicit TextEventSink(std::ostream &out, size_t capacity = 64 * 1024);
+        ~TextEventSink() override;
+
+        void record(const Game &game, const GameEvent &event) override;
+        void flush();
+    };
+
+    // Keeps the raw GameEvent records in memory.
+    class BinaryEventSink : public EventSink
+    {
+    private:
+        std::vector<GameEvent> _events;
+
+    public:
+        void record(const Game &game, const GameEvent &event) override;
+
+        const std::vector<GameEvent> &events() const;
+        void clear();
+        void write(std::ostream &out) const;
+    };
+}
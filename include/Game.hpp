@@ -5,7 +5,14 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include "Constants.hpp"
 #include "Player.hpp"
+#include "SeatSet.hpp"
+#include "LegalActions.hpp"
+#include "ActionResult.hpp"
+#include "EventSink.hpp"
 
 namespace coup
 {
@@ -15,26 +22,85 @@ namespace coup
     {
     private:
         std::vector<Player *> _players;
+        size_t _max_players;
         size_t _turn_index;
         bool _game_started;
-        std::string last_arrested_player;
-        Player *_player_to_be_saved;
+        std::int16_t _save_seat; // Seat a General may still revive, or NO_TARGET.
+        EventSink *_event_sink;
+        std::uint64_t _hash;
+        bool _hidden_coins;
+        std::vector<std::uint32_t> _coin_epoch;         // Per seat: bumped whenever its coin count changes.
+        // Spy reveals keyed by observer seat << 32 | target seat, holding the
+        // target's epoch when it was seen; valid while that epoch is unchanged.
+        std::unordered_map<std::uint64_t, std::uint32_t> _revealed;
+        SeatSet _active;                                // Seats whose players are still in the game.
+
+        void set_turn_index(size_t index);
+        void mark_started();
+        std::uint64_t seat_hash(size_t seat) const;
+        void toggle_hash(std::uint64_t delta) { _hash ^= delta; }
+        void conceal_coins(size_t seat);
+        void set_active(size_t seat, bool active);
+        size_t first_active_from(size_t seat) const;
+        bool is_turn_of(const Player &player) const;
+        int turn_coins(const Player &player) const;
+        bool can_undo(const Player &player, size_t seat) const;
+        bool can_target(const Player &player, ActionType type, size_t seat, int coins) const;
+
+        friend class Player;
+        friend struct GameState;
 
     public:
-        Game();
+        // Seats up to `max_players`, between MIN_PLAYERS and MAX_LOBBY_PLAYERS.
+        explicit Game(size_t max_players = DEFAULT_MAX_PLAYERS);
         ~Game();
 
         std::string turn();
+        Player *current_player();
+        ActionResult try_current_player(Player *&current);
         std::vector<std::string> players();
         std::string winner();
 
         void add_player(Player *player);
+        // Back to the state right after the players joined, keeping the same seats.
+        void reset();
         void next_turn();
         size_t active_players_count() const;
+        size_t max_players() const { return _max_players; }
         const std::vector<Player *> &get_players() const;
+        size_t seat_of(const Player &player) const;
+        // Every legal action of `player`. The target masks have one bit per seat,
+        // so this throws at tables of more than LEGAL_ACTIONS_MAX_SEATS.
+        LegalActions legal_actions(const Player &player) const;
+        // Whether legal_actions() would allow `action`, in constant time for any
+        // table size. The way to check actions at larger tables.
+        bool is_legal(const Player &player, const Action &action) const;
+        const SeatSet &active_seats() const { return _active; }
 
         void setPlayerToSave(Player *player);
         Player *getPlayerToSave() const;
         void clearSaveWindow();
+
+        // Zobrist hash of the whole game state, kept up to date as the state
+        // changes. Equal to GameState::capture(*this).hash().
+        std::uint64_t hash() const { return _hash; }
+
+        // Imperfect-information mode: players only see their own coins and coins
+        // a Spy has revealed to them. A revealed count stays visible until it changes.
+        void set_hidden_coins(bool hidden);
+        bool hidden_coins() const { return _hidden_coins; }
+        bool can_see_coins(const Player &observer, const Player &target) const;
+        void reveal_coins(const Player &observer, const Player &target);
+
+        // Events are only produced while a sink is attached; pass nullptr to detach.
+        void set_event_sink(EventSink *sink);
+        EventSink *event_sink() const { return _event_sink; }
+        void emit(const GameEvent &event) const
+        {
+            if (_event_sink != nullptr)
+            {
+                _event_sink->record(*this, event);
+            }
+        }
     };
 }
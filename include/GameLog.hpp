@@ -0,0 +1,121 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Action.hpp"
+#include "ActionResult.hpp"
+#include "EventSink.hpp"
+#include "Role.hpp"
+
+namespace coup
+{
+    class Game;
+
+    /**
+     * @brief On-disk record of one action or undo: 8 bytes, fixed width.
+     *
+     * An Undo record's actor is the player who undid, and its target is the
+     * player passed to undo(). Coin deltas are those reported in the GameEvent.
+     */
+    struct LogRecord
+    {
+        ActionType action;
+        ActionResult result;
+        std::uint16_t actor;
+        std::uint16_t target;
+        std::int8_t actor_delta;
+        std::int8_t target_delta;
+    };
+
+    /**
+     * @brief Header that starts every game in a log file.
+     *
+     * It is followed by player_count role bytes, padded to a multiple of 8,
+     * and then by record_count LogRecords.
+     */
+    struct LogGameHeader
+    {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t player_count;
+        std::uint64_t record_count;
+    };
+
+    const std::uint32_t LOG_MAGIC = 0x474C5043; // "CPLG"
+    const std::uint16_t LOG_VERSION = 1;
+
+    /**
+     * @brief Event sink that appends games to a binary log file.
+     *
+     * Call begin() before the first action of a game (it also attaches the
+     * writer as the game's event sink) and end() once the game is over. Any
+     * number of games can be written to the same file. A sink the game already
+     * had keeps receiving every event through the writer, and is put back by
+     * end().
+     *
+     * Records are written from inside the game's actions, so a failed write
+     * there only marks the game; end() reports it by throwing.
+     */
+    class GameLogWriter : public EventSink
+    {
+    private:
+        std::FILE *_file;
+        long _header_offset;
+        std::uint64_t _records;
+        Game *_game;
+        EventSink *_next; // The game's sink before begin().
+        bool _failed;     // A write of the open game failed.
+
+        bool finish();
+
+    public:
+        explicit GameLogWriter(const std::string &path);
+        ~GameLogWriter() override;
+        GameLogWriter(const GameLogWriter &) = delete;
+        GameLogWriter &operator=(const GameLogWriter &) = delete;
+
+        void begin(Game &game);
+        void end();
+        void record(const Game &game, const GameEvent &event) override;
+    };
+
+    // One game inside a mapped log. The pointers point into the mapping.
+    struct LoggedGame
+    {
+        const Role *roles;
+        size_t player_count;
+        const LogRecord *records;
+        size_t record_count;
+    };
+
+    /**
+     * @brief Memory-maps a log file and replays its games.
+     *
+     * Opening the log only walks the game headers; records are read in place
+     * from the mapping, never parsed or copied.
+     */
+    class GameLogReader
+    {
+    private:
+        const unsigned char *_data;
+        size_t _size;
+        std::vector<LoggedGame> _games;
+
+    public:
+        explicit GameLogReader(const std::string &path);
+        ~GameLogReader();
+        GameLogReader(const GameLogReader &) = delete;
+        GameLogReader &operator=(const GameLogReader &) = delete;
+
+        const std::vector<LoggedGame> &games() const;
+
+        // Re-applies every record of `logged` to `game`, which must be freshly set
+        // up with the same roles in the same seats. Returns the number of records.
+        size_t replay(const LoggedGame &logged, Game &game) const;
+    };
+}
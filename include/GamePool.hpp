@@ -0,0 +1,51 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "Game.hpp"
+#include "PlayerArena.hpp"
+#include "Role.hpp"
+
+namespace coup
+{
+    // A Game together with the players seated in it, in one allocation. Players
+    // keep a reference to their game, so the two are created and recycled as one unit.
+    struct PooledGame
+    {
+        Game game;
+        std::vector<Role> lineup;
+        PlayerArena players;
+
+        explicit PooledGame(size_t max_players = DEFAULT_MAX_PLAYERS) : game(max_players) {}
+    };
+
+    /**
+     * @brief Recycles games and their players across matches.
+     *
+     * acquire() hands out a game that is ready to start with the requested
+     * lineup, seating more than DEFAULT_MAX_PLAYERS when the lineup is longer. The players are named "P0", "P1", ... by seat. release() resets
+     * the game with Game::reset() and keeps it for the next acquire() with the
+     * same lineup. A simulation that plays one lineup over and over therefore
+     * allocates its game, players and names once, not once per match.
+     *
+     * A pool is not thread-safe; give each worker thread its own.
+     */
+    class GamePool
+    {
+    private:
+        std::vector<std::unique_ptr<PooledGame>> _free;
+        size_t _created;
+
+    public:
+        GamePool();
+
+        std::unique_ptr<PooledGame> acquire(const std::vector<Role> &lineup);
+        void release(std::unique_ptr<PooledGame> game);
+
+        size_t created() const;   // Games built so far, pooled or handed out.
+        size_t available() const; // Games waiting in the pool.
+    };
+}
@@ -0,0 +1,59 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Action.hpp"
+#include "Role.hpp"
+
+namespace coup
+{
+    class Game;
+
+    // Per-seat slice of a GameState. All fields are single bytes so the struct
+    // has no padding and copies as a flat block.
+    struct PlayerState
+    {
+        static const std::uint8_t ACTIVE = 1 << 0;
+        static const std::uint8_t SANCTIONED = 1 << 1;
+        static const std::uint8_t EXTRA_ACTION = 1 << 2;
+
+        std::uint8_t coins;
+        std::uint8_t flags;
+        Role role;
+        ActionType last_action;
+        std::int8_t last_arrested; // Seat index, or NO_TARGET.
+
+        bool has(std::uint8_t flag) const { return (flags & flag) != 0; }
+        void set(std::uint8_t flag, bool on) { flags = on ? (flags | flag) : (flags & ~flag); }
+    };
+
+    /**
+     * @brief Trivially copyable snapshot of a whole game of up to 6 players.
+     *
+     * Players are referred to by their seat index in Game::get_players(), so a
+     * GameState can be copied with memcpy, hashed, or compared bytewise. Use
+     * capture() to take a snapshot of a running Game and restore() to write it
+     * back into a Game with the same seats and roles.
+     */
+    struct GameState
+    {
+        static const size_t MAX_PLAYERS = 6;
+        static const std::uint8_t STARTED = 1 << 0;
+
+        PlayerState players[MAX_PLAYERS];
+        std::uint8_t player_count;
+        std::uint8_t turn;
+        std::int8_t save_target; // Seat a General may still revive, or NO_TARGET.
+        std::uint8_t flags;
+
+        static GameState capture(const Game &game);
+        void restore(Game &game) const;
+
+        size_t active_count() const;
+        std::uint64_t hash() const; // Same value as Game::hash() of the captured game.
+        bool operator==(const GameState &other) const;
+        bool operator!=(const GameState &other) const { return !(*this == other); }
+    };
+}
@@ -13,6 +13,6 @@ namespace coup
         General(Game &game, const std::string &name);
         ~General() override = default;
 
-        void undo(Player &target_of_coup) override;
+        ActionResult try_undo(Player &target_of_coup) override;
     };
 }
\ No newline at end of file
@@ -14,9 +14,9 @@ namespace coup
         ~Governor() override = default;
 
         // Overridden actions
-        void tax() override;
+        ActionResult try_tax() override;
 
         // Undoing ability
-        void undo(Player &target) override;
+        ActionResult try_undo(Player &target) override;
     };
 }
\ No newline at end of file
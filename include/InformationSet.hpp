@@ -0,0 +1,39 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstdint>
+#include "GameState.hpp"
+#include "Rng.hpp"
+
+namespace coup
+{
+    class Game;
+    class Player;
+
+    /**
+     * @brief What one player knows about a game in imperfect-information mode.
+     *
+     * `state` is a GameState in which the coins the observer cannot see are set
+     * to zero and flagged in `hidden`. Everything else in a GameState is public.
+     */
+    struct InformationSet
+    {
+        GameState state;
+        std::uint8_t observer; // Seat of the observing player.
+        std::uint8_t hidden;   // One bit per seat whose coins the observer cannot see.
+
+        // With `spy_rights`, an active Spy observer also sees the coins of every
+        // active opponent, as spyOn() would show them, without revealing
+        // anything in the game or reporting to its event sink.
+        static InformationSet observe(const Game &game, const Player &observer, bool spy_rights = false);
+
+        bool is_hidden(size_t seat) const { return (hidden >> seat & 1) != 0; }
+
+        // Fills in the hidden coin counts of `state`, which must agree with this
+        // information set on everything visible, with a guess drawn from `rng`:
+        // uniform over every count the player can hold between its turns, which
+        // depends on its public role and the number of active players.
+        void determinize(GameState &state, CounterRng &rng) const;
+    };
+}
@@ -0,0 +1,151 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include "LatencyHistogram.hpp"
+#include "Role.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Opt-in instrumentation of the engine's entry points.
+ *
+ * Build with -DCOUP_INSTRUMENT (`make ... INSTRUMENT=1`) to turn it on.
+ * Without it the COUP_* macros below expand to nothing and the query
+ * functions report zeros, so the normal build pays nothing.
+ */
+
+namespace coup
+{
+    // Engine calls that instrumentation is attributed to.
+    enum class EntryPoint : std::uint8_t
+    {
+        Gather,
+        Tax,
+        Bribe,
+        Arrest,
+        Sanction,
+        Coup,
+        Invest,
+        Undo,
+        Turn,
+        Players,
+        GetName,       // Player::getName()
+        RoleName,      // Player::role()
+        LastActionName // Player::getLastAction()
+    };
+
+    const size_t ENTRY_POINT_COUNT = 13;
+
+    const char *to_string(EntryPoint point);
+
+    struct AllocationStats
+    {
+        std::uint64_t calls = 0;       // Outermost calls of the entry point.
+        std::uint64_t allocations = 0; // operator new calls made while it ran.
+        std::uint64_t bytes = 0;
+
+        double per_call() const { return calls == 0 ? 0.0 : static_cast<double>(allocations) / calls; }
+    };
+
+    // Whether this build counts allocations (compiled with COUP_INSTRUMENT).
+    bool allocation_tracking_enabled();
+    // Totals over all threads since the last reset.
+    AllocationStats allocation_stats(EntryPoint point);
+    // Every operator new in the process, attributed or not. Also counted,
+    // without the per-entry-point attribution, when built with only
+    // -DCOUP_COUNT_ALLOCATIONS, as Bench is.
+    std::uint64_t total_allocations();
+    void reset_allocation_stats();
+
+    /**
+     * @brief Attributes the allocations made during its lifetime to an entry point.
+     *
+     * Scopes nest: an allocation counts towards every entry point open on the
+     * thread, so Game::turn() also sees the string built by getName(). A
+     * scope for an entry point that is already open (gather() calling
+     * try_gather()) does nothing, so each outer call is counted once.
+     */
+    class AllocationScope
+    {
+    private:
+        std::uint32_t _bit; // 0 when an enclosing scope already covers the entry point.
+
+    public:
+        explicit AllocationScope(EntryPoint point);
+        ~AllocationScope();
+        AllocationScope(const AllocationScope &) = delete;
+        AllocationScope &operator=(const AllocationScope &) = delete;
+    };
+
+    // Engine calls timed by the latency histograms. Undo is split by the
+    // role of the player undoing; UndoOther covers roles that cannot undo.
+    enum class LatencyKey : std::uint8_t
+    {
+        Gather,
+        Tax,
+        Bribe,
+        Arrest,
+        Sanction,
+        Coup,
+        Invest,
+        UndoGovernor,
+        UndoSpy,
+        UndoGeneral,
+        UndoJudge,
+        UndoOther
+    };
+
+    const size_t LATENCY_KEY_COUNT = 12;
+
+    const char *to_string(LatencyKey key);
+    LatencyKey undo_latency_key(Role role);
+
+    // Whether this build records latencies (compiled with COUP_INSTRUMENT).
+    bool latency_recording_enabled();
+    // Wall time of every outermost call since the last reset, over all threads.
+    const LatencyHistogram &latency_histogram(LatencyKey key);
+    void reset_latency_histograms();
+    // One row per key that has been called: count, mean, min, p50, p90, p99,
+    // p99.9, p99.99 and max, in nanoseconds.
+    void write_latency_snapshot(std::ostream &out);
+
+    /**
+     * @brief Records the wall time of its lifetime into a key's histogram.
+     *
+     * Destroyed during unwinding as well, so calls that end in an exception
+     * are recorded with the cost of the throw. Like AllocationScope, a scope
+     * for a key already open on the thread does nothing.
+     */
+    class LatencyScope
+    {
+    private:
+        std::uint32_t _bit; // 0 when an enclosing scope already times the key.
+        LatencyKey _key;
+        std::chrono::steady_clock::time_point _begin;
+
+    public:
+        explicit LatencyScope(LatencyKey key);
+        ~LatencyScope();
+        LatencyScope(const LatencyScope &) = delete;
+        LatencyScope &operator=(const LatencyScope &) = delete;
+    };
+}
+
+#define COUP_INSTRUMENT_CONCAT_(a, b) a##b
+#define COUP_INSTRUMENT_CONCAT(a, b) COUP_INSTRUMENT_CONCAT_(a, b)
+
+#ifdef COUP_INSTRUMENT
+#define COUP_TRACK_ALLOCATIONS(point) \
+    ::coup::AllocationScope COUP_INSTRUMENT_CONCAT(coup_allocation_scope_, __LINE__)(::coup::EntryPoint::point)
+#define COUP_RECORD_LATENCY(key) \
+    ::coup::LatencyScope COUP_INSTRUMENT_CONCAT(coup_latency_scope_, __LINE__)(::coup::LatencyKey::key)
+#define COUP_RECORD_UNDO_LATENCY(role) \
+    ::coup::LatencyScope COUP_INSTRUMENT_CONCAT(coup_latency_scope_, __LINE__)(::coup::undo_latency_key(role))
+#else
+#define COUP_TRACK_ALLOCATIONS(point) ((void)0)
+#define COUP_RECORD_LATENCY(key) ((void)0)
+#define COUP_RECORD_UNDO_LATENCY(role) ((void)0)
+#endif
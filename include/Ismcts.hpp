@@ -0,0 +1,85 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Action.hpp"
+#include "InformationSet.hpp"
+#include "Mcts.hpp"
+#include "Rules.hpp"
+
+namespace coup
+{
+    // Node of an information-set tree. Children form a singly linked list,
+    // because different determinizations make different actions available.
+    struct IsmctsNode
+    {
+        Action action;
+        std::uint32_t first_child;
+        std::uint32_t next_sibling;
+        std::uint8_t mover;
+        std::uint32_t visits;
+        std::uint32_t available; // Iterations in which this action could be chosen.
+        double value;
+    };
+
+    /**
+     * @brief Single-observer information-set MCTS (Cowling, Powley and Whitehouse).
+     *
+     * One tree is grown over action sequences for the whole information set.
+     * The search samples config.determinizations guesses of the hidden coins
+     * and spends an equal share of the iteration budget on each: every
+     * iteration of a batch starts from the same determinized state, descends
+     * the shared tree using only the actions available in it, and adds the
+     * first unexplored one. Selection uses UCB with availability counts in
+     * place of the parent's visits, so actions that are often unavailable are
+     * not penalised. Sampling once per batch instead of once per playout keeps
+     * the cost of determinization negligible while the tree still averages
+     * over many guesses.
+     */
+    class Ismcts
+    {
+    private:
+        MctsConfig _config;
+        std::vector<IsmctsNode> _nodes;
+        std::vector<std::uint32_t> _path;
+        size_t _used;
+        MctsStats _stats;
+
+        std::uint32_t add_child(std::uint32_t parent, const Action &action, std::uint8_t mover);
+        void iterate(const Position &start, CounterRng &rng, double *rewards);
+
+    public:
+        explicit Ismcts(const MctsConfig &config = MctsConfig());
+
+        // Searches the decision at `root`, whose hidden coins are described by `info`,
+        // and returns the most visited root action.
+        Action search(const Position &root, const InformationSet &info, std::uint64_t stream);
+        // After a search: the most visited root action among `legal`, or legal[0].
+        Action best_of(const Action *legal, size_t count) const;
+
+        const MctsStats &stats() const;
+        const IsmctsNode &node(std::uint32_t index) const;
+    };
+
+    // Policy for imperfect-information games: searches the information set of
+    // the deciding player. A Spy searches with the coins it is free to spy
+    // on, but the game itself is left untouched.
+    class IsmctsPolicy : public Policy
+    {
+    private:
+        Ismcts _search;
+
+    public:
+        explicit IsmctsPolicy(const MctsConfig &config = MctsConfig());
+
+        Action choose(const Game &game, const Player &self,
+                      const Action *legal, size_t count, CounterRng &rng) override;
+        bool react(const Game &game, const Player &self, const Player &actor,
+                   CounterRng &rng) override;
+
+        const MctsStats &last_search() const;
+    };
+}
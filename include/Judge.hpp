@@ -13,6 +13,6 @@ namespace coup
         ~Judge() override = default;
 
         // Judge's special undo ability
-        void undo(Player &target_of_bribe) override;
+        ActionResult try_undo(Player &target_of_bribe) override;
     };
 }
\ No newline at end of file
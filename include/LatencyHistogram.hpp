@@ -0,0 +1,66 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace coup
+{
+    /**
+     * @brief HDR-style histogram of latencies in nanoseconds.
+     *
+     * Buckets are log-linear: every power-of-two range is split into 64
+     * equal sub-buckets, so a recorded value is kept to within 1/64 (about
+     * 1.6%) of its size from 1 ns up to MAX_VALUE, in a fixed 18 KB table.
+     * Larger values are clamped to MAX_VALUE.
+     *
+     * Counters are relaxed atomics, so several threads may record into one
+     * histogram at once. A query taken while others record is a consistent
+     * count per bucket, not a snapshot of a single moment.
+     */
+    class LatencyHistogram
+    {
+    public:
+        static const std::uint64_t MAX_VALUE = (std::uint64_t(1) << 40) - 1; // About 18 minutes.
+
+    private:
+        static const unsigned SUB_BUCKET_BITS = 7;
+        static const size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+        static const size_t BUCKET_COUNT = (40 - SUB_BUCKET_BITS + 1) * (SUB_BUCKETS / 2) + SUB_BUCKETS / 2;
+
+        std::atomic<std::uint64_t> _counts[BUCKET_COUNT];
+        std::atomic<std::uint64_t> _total;
+        std::atomic<std::uint64_t> _sum;
+        std::atomic<std::uint64_t> _min;
+        std::atomic<std::uint64_t> _max;
+
+        static size_t index_of(std::uint64_t value);
+        static std::uint64_t highest_equivalent(size_t index);
+
+    public:
+        LatencyHistogram();
+        LatencyHistogram(const LatencyHistogram &) = delete;
+        LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+        void record(std::uint64_t nanoseconds);
+        void reset();
+        // Adds every value recorded in `other`.
+        void merge(const LatencyHistogram &other);
+
+        std::uint64_t count() const;
+        std::uint64_t min() const; // 0 when empty.
+        std::uint64_t max() const;
+        double mean() const;
+        // Smallest value that at least `percent` of the recorded values do not
+        // exceed, to within the bucket precision; 0 when empty.
+        std::uint64_t percentile(double percent) const;
+
+        // Percentile distribution in the HdrHistogram text layout: value,
+        // percentile, total count and 1/(1-percentile), halving the distance
+        // to 100% with each group of rows.
+        void write_percentiles(std::ostream &out) const;
+    };
+}
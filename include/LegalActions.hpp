@@ -0,0 +1,41 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Action.hpp"
+
+namespace coup
+{
+    /**
+     * @brief Everything one player may do right now, as bitmasks.
+     *
+     * `mask` has one bit per ActionType. For targeted actions (arrest,
+     * sanction, coup, undo) the matching target mask has one bit per seat in
+     * Game::get_players(). A sanctioned player may still choose gather, tax or
+     * invest; the action is accepted but forfeits the turn.
+     */
+    struct LegalActions
+    {
+        std::uint16_t mask = 0;
+        std::uint64_t arrest_targets = 0;
+        std::uint64_t sanction_targets = 0;
+        std::uint64_t coup_targets = 0;
+        std::uint64_t undo_targets = 0;
+
+        static std::uint16_t bit(ActionType type) { return static_cast<std::uint16_t>(1u << static_cast<unsigned>(type)); }
+
+        bool can(ActionType type) const { return (mask & bit(type)) != 0; }
+        bool can(ActionType type, size_t target) const;
+        bool empty() const { return mask == 0; }
+        std::uint64_t targets(ActionType type) const;
+
+        void allow(ActionType type) { mask |= bit(type); }
+        void allow(ActionType type, size_t target);
+        void forbid(ActionType type);
+
+        // Writes every concrete action into `out` and returns how many were written.
+        size_t expand(Action *out, size_t capacity) const;
+    };
+}
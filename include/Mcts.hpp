@@ -0,0 +1,115 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Action.hpp"
+#include "Rules.hpp"
+#include "Simulator.hpp"
+
+namespace coup
+{
+    struct MctsConfig
+    {
+        size_t iterations = 10000;  // Playouts per decision.
+        double seconds = 0.0;       // Time budget per decision, 0 for no limit.
+        double exploration = 1.4;   // UCT exploration constant.
+        size_t playout_depth = 60;  // Decisions per playout before the position is scored.
+        size_t max_nodes = 1 << 18; // Size of the node pool. The tree stops growing once it is full.
+        std::uint64_t seed = 1;
+        size_t threads = 1;         // Search threads; more than 1 uses ParallelMcts.
+        std::uint32_t virtual_loss = 3; // Zero-reward visits added per thread inside a subtree.
+        size_t determinizations = 16; // Ismcts: hidden-coin guesses per search, one batch each.
+    };
+
+    struct MctsStats
+    {
+        size_t iterations = 0;
+        size_t nodes = 0;
+        double seconds = 0.0;
+
+        double playouts_per_second() const;
+    };
+
+    // One tree node. Children of a node are stored next to each other in the pool.
+    struct MctsNode
+    {
+        Action action;            // Action that leads here from the parent.
+        std::uint32_t first_child;
+        std::uint16_t child_count;
+        std::uint8_t mover;       // Seat that played `action`.
+        bool expanded;
+        std::uint32_t visits;
+        double value;             // Sum of the playout rewards of `mover`.
+    };
+
+    // Plays random actions from `position` for at most `depth` decisions and
+    // writes one reward per seat, as described for Mcts.
+    void mcts_playout(Position &position, size_t depth, CounterRng &rng, double *rewards);
+
+    /**
+     * @brief Monte Carlo Tree Search over the decisions of a Position.
+     *
+     * Turn actions and reactive undos are both tree decisions, so the search
+     * plays for whichever seat decides at the root. Each iteration selects a
+     * path with UCT, expands the leaf with all of its actions, plays random
+     * actions for at most playout_depth decisions on a copy of the state, and
+     * backs the reward of every seat up the path. Every node scores the reward
+     * of the seat that moved into it. A won game pays 1 to the winner; a
+     * playout that is cut off splits the reward between the active players in
+     * proportion to their coins.
+     *
+     * All nodes come from a pool allocated once in the constructor and reused by
+     * every search, and all randomness comes from CounterRng streams keyed by
+     * (seed, stream, iteration), so a search is reproducible.
+     */
+    class Mcts
+    {
+    private:
+        MctsConfig _config;
+        std::vector<MctsNode> _nodes;
+        std::vector<std::uint32_t> _path;
+        size_t _used;
+        MctsStats _stats;
+
+        void expand(std::uint32_t node, const Position &position);
+        std::uint32_t select_child(std::uint32_t node) const;
+
+    public:
+        explicit Mcts(const MctsConfig &config = MctsConfig());
+
+        // Searches from `root` and returns the most visited action.
+        Action search(const Position &root, std::uint64_t stream);
+
+        const MctsStats &stats() const;
+        const MctsConfig &config() const;
+        const MctsNode &node(std::uint32_t index) const;
+    };
+
+    class ParallelMcts;
+
+    // Policy that runs a fresh MCTS search for every turn and every undo decision,
+    // tree-parallel when config.threads is more than 1.
+    class MctsPolicy : public Policy
+    {
+    private:
+        Mcts _search;
+        std::unique_ptr<ParallelMcts> _parallel;
+
+        Action search(const Position &root, std::uint64_t stream);
+
+    public:
+        explicit MctsPolicy(const MctsConfig &config = MctsConfig());
+        ~MctsPolicy() override;
+
+        Action choose(const Game &game, const Player &self,
+                      const Action *legal, size_t count, CounterRng &rng) override;
+        bool react(const Game &game, const Player &self, const Player &actor,
+                   CounterRng &rng) override;
+
+        const MctsStats &last_search() const;
+    };
+}
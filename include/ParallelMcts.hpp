@@ -0,0 +1,107 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Action.hpp"
+#include "Mcts.hpp"
+#include "Rules.hpp"
+
+namespace coup
+{
+    /**
+     * @brief Tree node shared by all search threads.
+     *
+     * Statistics are atomics updated without locks. `value` is a fixed-point
+     * sum of rewards so it can be added with fetch_add. `pending` counts the
+     * threads currently below this node; each one counts as a virtual loss.
+     * The child block is filled in by the thread that wins the expansion CAS
+     * and published by the release store of `status`.
+     */
+    struct ParallelMctsNode
+    {
+        static const std::uint8_t LEAF = 0;
+        static const std::uint8_t EXPANDING = 1;
+        static const std::uint8_t EXPANDED = 2;
+
+        Action action;
+        std::uint8_t mover;
+        std::uint16_t child_count;
+        std::uint32_t first_child;
+        std::atomic<std::uint8_t> status;
+        std::atomic<std::uint32_t> visits;
+        std::atomic<std::uint32_t> pending;
+        std::atomic<std::int64_t> value;
+
+        void reset(const Action &action, std::uint8_t mover);
+        double mean() const; // Average reward of `mover` over completed visits.
+    };
+
+    /**
+     * @brief Tree-parallel MCTS: config.threads workers grow one shared tree.
+     *
+     * Same search as Mcts (UCT selection, full expansion, random playouts with
+     * the same rewards), but nodes are taken from the shared pool with an atomic
+     * bump allocator, expanded by whichever thread wins a CAS on the node's
+     * status, and updated with atomic adds. While a thread is below a node the
+     * node counts config.virtual_loss extra visits with zero reward, which
+     * steers the other threads to different branches.
+     *
+     * Iteration indices are handed out from a shared counter and key the random
+     * streams as in Mcts, but the interleaving of threads makes the tree itself
+     * nondeterministic when more than one thread runs.
+     *
+     * The config.threads - 1 helper threads are started by the constructor
+     * and wait between searches; search() wakes them and works alongside them
+     * on the calling thread, so a move costs no thread creation. The
+     * destructor stops and joins them.
+     */
+    class ParallelMcts
+    {
+    private:
+        MctsConfig _config;
+        std::unique_ptr<ParallelMctsNode[]> _nodes;
+        std::atomic<size_t> _used;
+        std::atomic<size_t> _next_iteration;
+        std::atomic<bool> _stop;
+        MctsStats _stats;
+
+        // Worker pool. A search is published under _mutex by bumping
+        // _generation; each worker runs it once and decrements _running.
+        std::vector<std::thread> _workers;
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::condition_variable _done;
+        std::uint64_t _generation;
+        size_t _running;
+        bool _shutdown;
+        const Position *_job_root;
+        std::uint64_t _job_stream;
+
+        bool expand(std::uint32_t node, const Position &position);
+        std::uint32_t select_child(std::uint32_t node) const;
+        void work(const Position &root, std::uint64_t stream, double seconds_left);
+        void worker_loop();
+        void stop_workers();
+
+    public:
+        explicit ParallelMcts(const MctsConfig &config = MctsConfig());
+        ~ParallelMcts();
+        ParallelMcts(const ParallelMcts &) = delete;
+        ParallelMcts &operator=(const ParallelMcts &) = delete;
+
+        // Searches from `root` with config.threads threads and returns the most visited action.
+        Action search(const Position &root, std::uint64_t stream);
+
+        const MctsStats &stats() const;
+        const MctsConfig &config() const;
+        const ParallelMctsNode &node(std::uint32_t index) const;
+    };
+}
@@ -0,0 +1,72 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Action.hpp"
+
+namespace coup
+{
+    // Hardware event counts, user space only.
+    struct PerfSample
+    {
+        std::uint64_t cycles = 0;
+        std::uint64_t instructions = 0;
+        std::uint64_t cache_misses = 0;
+        std::uint64_t branch_misses = 0;
+
+        PerfSample &operator+=(const PerfSample &other);
+    };
+
+    /**
+     * @brief Cycle, instruction, cache-miss and branch-miss counters of the
+     *        calling thread, read through Linux perf_event_open.
+     *
+     * The four events are opened as one group, so a single read() returns
+     * them all from the same moment. Only user-space events are counted, so
+     * the read() system calls themselves barely show up; the few user
+     * instructions they add are measured once at construction and removed by
+     * since().
+     *
+     * Opening fails without throwing where perf events are not allowed (other
+     * operating systems, containers, perf_event_paranoid above 2). Then
+     * available() is false, error() says why, and every read is zero.
+     *
+     * The counters follow the thread that constructed the object, so create
+     * one per thread and only read it from that thread.
+     */
+    class PerfCounters
+    {
+    private:
+        int _group;
+        int _members[3];
+        std::string _error;
+        PerfSample _overhead; // Cost of one read() as seen by the counters.
+
+    public:
+        PerfCounters();
+        ~PerfCounters();
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters &operator=(const PerfCounters &) = delete;
+
+        bool available() const { return _group >= 0; }
+        const std::string &error() const { return _error; }
+
+        // Totals since construction.
+        PerfSample read() const;
+        // Events since `before`, a read() on this thread, without the read overhead.
+        PerfSample since(const PerfSample &before) const;
+    };
+
+    // Event totals and call counts per action type.
+    struct PerfByAction
+    {
+        PerfSample totals[ACTION_TYPE_COUNT];
+        std::uint64_t calls[ACTION_TYPE_COUNT] = {};
+
+        void record(ActionType type, const PerfSample &sample);
+        PerfByAction &operator+=(const PerfByAction &other);
+    };
+}
@@ -2,9 +2,14 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <stdexcept>
 #include "Game.hpp"
+#include "Action.hpp"
+#include "ActionResult.hpp"
+#include "EventSink.hpp"
+#include "Role.hpp"
 
 namespace coup
 {
@@ -17,45 +22,74 @@ namespace coup
         std::string _name;
         int _coins;
         bool is_active;
-        std::string _role;
-        std::string last_action;
-        Player *_last_arrested_target;
+        Role _role;
+        ActionType last_action;
+        std::int16_t _last_arrested_seat; // Seat index, or NO_TARGET.
         bool _is_sanctioned;
         bool _has_extra_action;
-        Player *_aggressor_in_last_coup;
+        std::int16_t _aggressor_seat; // Seat index, or NO_TARGET.
+        size_t _seat;
 
-        void check_turn() const;
-        void must_coup() const;
+        ActionResult check_turn() const;
+        ActionResult must_coup() const;
         void end_turn_or_continue();
+        void report(EventKind kind, ActionType action, ActionResult result, const Player *target,
+                    int coins_before, int target_before) const;
         void revive();            // For General
         void cancelExtraAction(); // For Judge
+        void reset();             // For Game::reset(), which also rebuilds the hash.
+        // throw_if_failed() for the throwing actions; flags the try_* trace span as thrown.
+        static void throw_action_error(ActionResult result);
 
+        // Field setters that keep the game's Zobrist hash in step. All changes
+        // to hashed fields go through these or the public state modifiers.
+        void setCoins(int coins);
+        void setLastAction(ActionType action);
+        void setExtraAction(bool status);
+        void setLastArrestedTarget(Player *target);
+
+        friend class Game;
         friend class General;
         friend class Judge;
         friend class Spy;
+        friend struct GameState;
 
     public:
-        Player *last_arrested = nullptr;
-
         Player(Game &game, const std::string &name);
         virtual ~Player() = default;
 
-        // General Actions
+        // General Actions. Each one throws std::runtime_error on a rule violation.
         void gather();
-        virtual void tax();
-        virtual void coup(Player &target);
+        void tax();
+        void coup(Player &target);
         void bribe();
         void arrest(Player &target);
         void sanction(Player &target);
 
+        // Non-throwing versions of the actions above. They apply exactly the
+        // same rules and report a violation through the returned ActionResult.
+        // A refused action changes nothing; a sanctioned gather or tax is not
+        // refused, it spends the turn.
+        ActionResult try_gather();
+        virtual ActionResult try_tax();
+        virtual ActionResult try_coup(Player &target);
+        ActionResult try_bribe();
+        ActionResult try_arrest(Player &target);
+        ActionResult try_sanction(Player &target);
+
         // Getters
-        std::string role() const;
+        Role roleType() const;
+        ActionType lastActionType() const;
+        std::string role() const; // Formatting helper, use roleType() for logic.
         int coins() const;
         std::string getName() const;
         bool isActive() const;
-        std::string getLastAction() const;
+        bool isSanctioned() const;
+        bool hasExtraAction() const;
+        std::string getLastAction() const; // Formatting helper, use lastActionType() for logic.
         Player *getLastArrestedTarget() const;
         Player *getAggressorInLastCoup() const;
+        size_t seat() const; // Position in Game::get_players().
 
         // State modifiers
         void addCoins(int amount);
@@ -64,6 +98,7 @@ namespace coup
         void setSanctioned(bool status);
 
         // Blocking actions
-        virtual void undo(Player &target);
+        void undo(Player &target);
+        virtual ActionResult try_undo(Player &target);
     };
 }
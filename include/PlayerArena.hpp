@@ -0,0 +1,56 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "Player.hpp"
+#include "Role.hpp"
+
+namespace coup
+{
+    /**
+     * @brief Owns the players of one game in a single contiguous block.
+     *
+     * create() constructs a player of any role in the next free slot and
+     * seats it in the game, like make_player() but without a heap allocation
+     * per player. Every role has the same size as Player, so the slots are
+     * Player-sized and the players of a game sit next to each other in
+     * memory. Players refer to each other by seat index, never by pointer,
+     * so dropping the arena discards the whole table in one step.
+     *
+     * The slots are allocated by the first create(), one per seat of that
+     * game's max_players(), so a large lobby fits as well as a 6-seat table.
+     *
+     * The arena must not outlive the game its players joined.
+     */
+    class PlayerArena
+    {
+    private:
+        struct alignas(Player) Slot
+        {
+            unsigned char bytes[sizeof(Player)];
+        };
+
+        std::unique_ptr<Slot[]> _slots;
+        std::unique_ptr<Player *[]> _players;
+        size_t _capacity;
+        size_t _count;
+
+    public:
+        PlayerArena();
+        ~PlayerArena();
+        PlayerArena(const PlayerArena &) = delete;
+        PlayerArena &operator=(const PlayerArena &) = delete;
+
+        Player &create(Game &game, Role role, const std::string &name);
+        // Destroys every player. Only valid together with discarding their game.
+        void clear();
+
+        size_t size() const { return _count; }
+        size_t capacity() const { return _capacity; }
+        Player &operator[](size_t seat) { return *_players[seat]; }
+        const Player &operator[](size_t seat) const { return *_players[seat]; }
+    };
+}
@@ -0,0 +1,104 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace coup
+{
+    using PhiloxBlock = std::array<std::uint32_t, 4>;
+    using PhiloxKey = std::array<std::uint32_t, 2>;
+
+    // Philox4x32-10 block function (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+    // The output depends only on the counter and the key.
+    inline PhiloxBlock philox4x32(PhiloxBlock counter, PhiloxKey key)
+    {
+        const std::uint32_t M0 = 0xD2511F53u;
+        const std::uint32_t M1 = 0xCD9E8D57u;
+        const std::uint32_t W0 = 0x9E3779B9u;
+        const std::uint32_t W1 = 0xBB67AE85u;
+        for (int round = 0; round < 10; ++round)
+        {
+            const std::uint64_t p0 = static_cast<std::uint64_t>(M0) * counter[0];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(M1) * counter[2];
+            counter = {static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^ key[0],
+                       static_cast<std::uint32_t>(p1),
+                       static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^ key[1],
+                       static_cast<std::uint32_t>(p0)};
+            key[0] += W0;
+            key[1] += W1;
+        }
+        return counter;
+    }
+
+    /**
+     * @brief Random stream for one decision point, identified by (seed, game, turn).
+     *
+     * The stream is a pure function of its three coordinates, so a game
+     * played on any thread, in any order, draws exactly the same numbers as
+     * the same game replayed alone. Creating one is free: there is no state
+     * to seed and nothing is shared between threads.
+     */
+    class CounterRng
+    {
+    private:
+        PhiloxKey _key;
+        PhiloxBlock _counter;
+        PhiloxBlock _block;
+        unsigned _used;
+
+    public:
+        using result_type = std::uint32_t;
+
+        CounterRng(std::uint64_t seed, std::uint64_t game, std::uint32_t turn)
+            : _key{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+              _counter{0, turn, static_cast<std::uint32_t>(game), static_cast<std::uint32_t>(game >> 32)},
+              _block{},
+              _used(4)
+        {
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return 0xFFFFFFFFu; }
+
+        result_type operator()()
+        {
+            if (_used == 4)
+            {
+                _block = philox4x32(_counter, _key);
+                _counter[0]++;
+                _used = 0;
+            }
+            return _block[_used++];
+        }
+
+        // Uniform integer in [0, bound) using Lemire's multiply-shift rejection.
+        std::uint32_t uniform(std::uint32_t bound)
+        {
+            std::uint64_t m = static_cast<std::uint64_t>((*this)()) * bound;
+            std::uint32_t low = static_cast<std::uint32_t>(m);
+            if (low < bound)
+            {
+                const std::uint32_t threshold = static_cast<std::uint32_t>(-bound) % bound;
+                while (low < threshold)
+                {
+                    m = static_cast<std::uint64_t>((*this)()) * bound;
+                    low = static_cast<std::uint32_t>(m);
+                }
+            }
+            return static_cast<std::uint32_t>(m >> 32);
+        }
+
+        // Uniform double in [0, 1) with 32 bits of resolution.
+        double uniform_real()
+        {
+            return (*this)() * (1.0 / 4294967296.0);
+        }
+
+        bool bernoulli(double probability)
+        {
+            return uniform_real() < probability;
+        }
+    };
+}
@@ -0,0 +1,36 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace coup
+{
+    class Game;
+    class Player;
+
+    enum class Role : std::uint8_t
+    {
+        Player,
+        Governor,
+        Spy,
+        Baron,
+        General,
+        Judge,
+        Merchant
+    };
+
+    const size_t ROLE_COUNT = 7;
+
+    const char *to_string(Role role);
+
+    /**
+     * @brief Creates a player of the given role and registers it with the game.
+     *
+     * The returned object must outlive every use of the game it was added to.
+     */
+    std::unique_ptr<Player> make_player(Game &game, Role role, const std::string &name);
+}
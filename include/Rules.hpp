@@ -0,0 +1,69 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Action.hpp"
+#include "ActionResult.hpp"
+#include "GameState.hpp"
+#include "LegalActions.hpp"
+
+namespace coup
+{
+    // The rules of Game and the Player classes, applied directly to a GameState.
+    // They give the same results, in the same order, as the member functions they
+    // mirror, but never allocate and never go through virtual calls, so search
+    // and training code can copy and play out states cheaply.
+
+    // Seat of the player whose turn it is, skipping eliminated players.
+    size_t current_seat(const GameState &state);
+
+    // Same as Game::legal_actions() for the player in `seat`.
+    LegalActions legal_actions(const GameState &state, size_t seat);
+
+    // Performs `action` for the player in `seat` like the matching try_* member.
+    // Invest is only accepted from a Baron, like Baron::try_invest().
+    ActionResult apply_action(GameState &state, size_t seat, const Action &action);
+
+    /**
+     * @brief A GameState at a decision point of the simulator's turn loop.
+     *
+     * A game alternates between turn decisions, where the current player picks
+     * one of its legal actions, and reaction decisions, where each other player
+     * that can undo the action just performed decides whether to do so, in seat
+     * order, exactly as Simulator::play_one() asks them. A reaction decision
+     * offers two actions: {Undo, target} and {None, NO_TARGET} to let it pass.
+     */
+    struct Position
+    {
+        static const std::uint8_t TURN = 0;
+        static const std::uint8_t REACTION = 1;
+
+        GameState state;
+        std::uint8_t phase;
+        std::uint8_t seat;         // Seat that decides next.
+        std::uint8_t actor;        // During REACTION: seat whose action may be undone.
+        ActionType performed;      // During REACTION: the action that may be undone.
+        std::int8_t undo_target;   // During REACTION: target of the pending undo.
+
+        // Position at the start of the current player's turn.
+        static Position turn(const GameState &state);
+        // Position where `reactor` is asked about the action `actor` just performed.
+        // If `reactor` cannot undo it, moves on to the next reactor or turn.
+        static Position reaction(const GameState &state, size_t actor, ActionType performed, size_t reactor);
+
+        // A coup can still be undone during the reaction phase, so a game is only
+        // over once the next turn would start with a single player left.
+        bool terminal() const { return phase == TURN && state.active_count() <= 1; }
+        int winner() const; // Winning seat, or -1 while the game is running.
+
+        // Writes the actions available at this decision and returns how many.
+        size_t actions(Action *out, size_t capacity) const;
+        // Plays an action returned by actions() and advances to the next decision.
+        void play(const Action &action);
+
+    private:
+        void advance_reaction(size_t from);
+    };
+}
@@ -0,0 +1,51 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace coup
+{
+    /**
+     * @brief Set of seat indices as a two-level bitset.
+     *
+     * The lower level has one bit per seat. The upper level has one bit per
+     * lower-level word, set while that word has any seat in it. Insert and
+     * erase touch one word of each level, the count is kept as a running
+     * total, and find() skips empty stretches 4096 seats at a time, so a
+     * lookup costs about the same for 6 seats as for a few thousand.
+     */
+    class SeatSet
+    {
+    private:
+        std::vector<std::uint64_t> _words;   // Bit per seat.
+        std::vector<std::uint64_t> _summary; // Bit per non-empty word.
+        size_t _capacity;
+        size_t _count;
+
+    public:
+        static const size_t NONE = static_cast<size_t>(-1);
+
+        // An empty set for seats [0, capacity).
+        explicit SeatSet(size_t capacity = 0);
+
+        size_t capacity() const { return _capacity; }
+        size_t size() const { return _count; }
+        bool empty() const { return _count == 0; }
+
+        bool contains(size_t seat) const
+        {
+            return (_words[seat >> 6] >> (seat & 63) & 1) != 0;
+        }
+        void insert(size_t seat);
+        void erase(size_t seat);
+        void clear();
+
+        // Lowest seat in the set at or after `seat`, or NONE.
+        size_t find(size_t seat) const;
+        // Like find(), but wraps around to the lowest seat. The set must not be empty.
+        size_t find_circular(size_t seat) const;
+    };
+}
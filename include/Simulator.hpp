@@ -0,0 +1,137 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Action.hpp"
+#include "Game.hpp"
+#include "GamePool.hpp"
+#include "PerfCounters.hpp"
+#include "Role.hpp"
+#include "Rng.hpp"
+#include "SeatSet.hpp"
+
+namespace coup
+{
+    class GameLogWriter;
+
+    // Upper bound on the number of distinct actions a player can have in one turn.
+    const size_t MAX_ACTIONS = 32;
+    // Opponents offered as arrest, sanction and coup targets per turn at tables
+    // larger than GameState::MAX_PLAYERS.
+    const size_t SAMPLED_TARGETS = 8;
+    // Seats asked to react to one action at tables larger than GameState::MAX_PLAYERS.
+    const size_t SAMPLED_REACTORS = 8;
+
+    /**
+     * @brief Decision strategy for one seat of a simulated game.
+     *
+     * choose() is called on the player's turn with the list of currently legal
+     * actions and must return one of them. react() is called right after another
+     * player's action when this player is able to undo it. Policies must take
+     * all their randomness from `rng`, which is keyed by (seed, game, turn), so
+     * games stay reproducible however they are spread across threads.
+     */
+    class Policy
+    {
+    public:
+        virtual ~Policy() = default;
+
+        virtual Action choose(const Game &game, const Player &self,
+                              const Action *legal, size_t count, CounterRng &rng) = 0;
+        virtual bool react(const Game &game, const Player &self, const Player &actor,
+                           CounterRng &rng);
+    };
+
+    // Picks uniformly among the legal actions and undoes with a fixed probability.
+    class RandomPolicy : public Policy
+    {
+    private:
+        double _react_probability;
+
+    public:
+        explicit RandomPolicy(double react_probability = 0.5);
+
+        Action choose(const Game &game, const Player &self,
+                      const Action *legal, size_t count, CounterRng &rng) override;
+        bool react(const Game &game, const Player &self, const Player &actor,
+                   CounterRng &rng) override;
+    };
+
+    // Coups the richest opponent when possible, otherwise takes the biggest payout.
+    class GreedyPolicy : public Policy
+    {
+    public:
+        Action choose(const Game &game, const Player &self,
+                      const Action *legal, size_t count, CounterRng &rng) override;
+        bool react(const Game &game, const Player &self, const Player &actor,
+                   CounterRng &rng) override;
+    };
+
+    struct SimulationConfig
+    {
+        std::vector<Role> lineup;  // One role per seat, in turn order.
+        size_t games = 1000;
+        std::uint64_t seed = 1;    // Key of the counter-based random streams.
+        size_t max_actions = 1000; // Games running longer than this count as draws.
+        GameLogWriter *log = nullptr; // When set, every game is appended to this log.
+        bool hidden_coins = false;    // Play in imperfect-information mode, see Game::set_hidden_coins().
+        bool perf_counters = false;   // Read hardware counters around every action, see PerfCounters.
+    };
+
+    struct SimulationStats
+    {
+        size_t games = 0;
+        size_t actions = 0;
+        size_t undos = 0;
+        size_t draws = 0;
+        std::vector<size_t> wins_by_seat;
+        double seconds = 0.0;
+        PerfByAction perf; // Per action type, with SimulationConfig::perf_counters.
+
+        double games_per_second() const;
+        double actions_per_second() const;
+    };
+
+    /**
+     * @brief Plays batches of games between policies with no console output.
+     *
+     * Each game is driven through the non-throwing try_* Player API. The
+     * simulator only offers legal actions to the policies, so the only refusal
+     * it sees is a sanctioned player forfeiting a gather, tax or invest.
+     *
+     * Up to GameState::MAX_PLAYERS seats, a policy is offered every legal
+     * action, and every active seat whose role can undo an action is asked to
+     * react to it. Larger lobbies offer the legal untargeted actions and a few
+     * sampled targets instead (see SAMPLED_TARGETS), and ask at most
+     * SAMPLED_REACTORS of those seats, taken in seat order from a random one.
+     * The seats are kept per action type in a SeatSet that loses a seat when
+     * it is eliminated, so the work of a turn is bounded by these constants
+     * rather than by the number of seats. Only setting up a game is linear.
+     */
+    class Simulator
+    {
+    private:
+        SimulationConfig _config;
+        std::vector<Policy *> _policies;
+        GamePool _pool; // Every game of a run reuses the same Game and players.
+        SeatSet _reactors[ACTION_TYPE_COUNT];      // Per action type: seats whose role can undo it.
+        SeatSet _live_reactors[ACTION_TYPE_COUNT]; // The same, less the seats out of the current game.
+        std::unique_ptr<PerfCounters> _perf; // Opened on the thread that plays the first game.
+
+        void set_live_reactor(const Player &player, bool live);
+
+    public:
+        Simulator(const SimulationConfig &config, const std::vector<Policy *> &policies);
+
+        // Switches to a new lineup and policies, keeping the pooled games, so
+        // one simulator can play many batches without rebuilding its tables.
+        void configure(const SimulationConfig &config, const std::vector<Policy *> &policies);
+
+        SimulationStats run();
+        int play_one(std::uint64_t game_id, SimulationStats &stats);
+    };
+}
@@ -1,7 +1,8 @@
 //talgov44@gmail.com
 
+#pragma once
+
 #include "Player.hpp"
-#include <iostream>
 
 namespace coup
 {
@@ -12,7 +13,7 @@ namespace coup
         ~Spy() override = default;
 
         // Spy's special undo ability
-        void undo(Player &arresting_player) override;
+        ActionResult try_undo(Player &arresting_player) override;
 
         // Spy's unique ability to see coins. This is a non-turn action.
         void spyOn(const Player &target) const;
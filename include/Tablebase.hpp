@@ -0,0 +1,99 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Role.hpp"
+#include "Rules.hpp"
+#include "Simulator.hpp"
+
+namespace coup
+{
+    const std::uint32_t TABLEBASE_MAGIC = 0x42545043; // "CPTB"
+    const std::uint16_t TABLEBASE_VERSION = 1;
+    const int TABLEBASE_MAX_COINS = 20; // Positions where a player holds more are not tabled.
+
+    enum class EndgameResult : std::uint8_t
+    {
+        Draw, // No forced result: the game can cycle, or leaves the table.
+        Win,
+        Loss
+    };
+
+    // Value of a position for the player who decides in it.
+    struct EndgameValue
+    {
+        EndgameResult result;
+        std::uint8_t distance; // Decisions, both players' and reactions included, until the game ends.
+    };
+
+    /**
+     * @brief Exact values of every two-player position, by retrograde analysis.
+     *
+     * Once two players are left, a Position is fully described (as far as the
+     * rest of the game is concerned) by the two roles, both coin counts, both
+     * sanction flags, whether each player last arrested the other, whose turn
+     * it is and that player's extra action, who decides, and whether the
+     * decision is a turn or a reaction to a tax, bribe or arrest. Each pair of roles gets a
+     * table with one byte per such position holding its win/loss/draw value and
+     * distance, so a lookup is an index computation and a single load.
+     *
+     * build() generates each table by playing every action of every position
+     * through the Position rules engine, then resolves positions backwards from
+     * the winning coups in order of distance. The file is read through a
+     * read-only memory mapping and can be shared by any number of bots.
+     */
+    class Tablebase
+    {
+    private:
+        const unsigned char *_data;
+        size_t _size;
+        const std::uint32_t *_offsets; // Byte offset of each role pair's table, 0 if not built.
+
+    public:
+        static const size_t ENTRIES_PER_TABLE;
+
+        // Builds tables for every pair of roles in `roles` and writes them to `path`.
+        static void build(const std::string &path, const std::vector<Role> &roles);
+
+        explicit Tablebase(const std::string &path);
+        ~Tablebase();
+        Tablebase(const Tablebase &) = delete;
+        Tablebase &operator=(const Tablebase &) = delete;
+
+        bool has(Role a, Role b) const;
+        // Value of `position` for the seat that decides in it. Returns false if the
+        // position does not have exactly two active players or is not in the table.
+        bool lookup(const Position &position, EndgameValue &value) const;
+    };
+
+    // True if `a` is the better value for the player who gets it.
+    bool better(const EndgameValue &a, const EndgameValue &b);
+
+    /**
+     * @brief Plays perfectly from the tablebase once two players are left.
+     *
+     * Every decision whose position is in the table picks the action with the
+     * best tabled outcome: the fastest win, else a draw, else the slowest loss.
+     * Every other decision is left to the fallback policy.
+     */
+    class EndgamePolicy : public Policy
+    {
+    private:
+        const Tablebase &_tablebase;
+        Policy &_fallback;
+
+        bool best_action(const Position &root, const Action *legal, size_t count, Action &best) const;
+
+    public:
+        EndgamePolicy(const Tablebase &tablebase, Policy &fallback);
+
+        Action choose(const Game &game, const Player &self,
+                      const Action *legal, size_t count, CounterRng &rng) override;
+        bool react(const Game &game, const Player &self, const Player &actor,
+                   CounterRng &rng) override;
+    };
+}
@@ -0,0 +1,92 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Role.hpp"
+#include "Simulator.hpp"
+
+namespace coup
+{
+    // Builds a fresh policy. Each worker thread calls it once per entrant, so
+    // policies with internal state are never shared between threads.
+    using PolicyFactory = std::function<std::unique_ptr<Policy>()>;
+
+    struct Entrant
+    {
+        std::string name;
+        PolicyFactory make_policy;
+    };
+
+    // A batch of games with a fixed lineup: one role and one entrant per seat.
+    struct Match
+    {
+        std::vector<Role> lineup;
+        std::vector<size_t> entrants;
+        size_t games = 1;
+        std::uint64_t seed = 1;
+    };
+
+    struct TournamentStats
+    {
+        size_t games = 0;
+        size_t wins = 0;
+
+        double win_rate() const;
+    };
+
+    struct TournamentResult
+    {
+        size_t matches = 0;
+        size_t games = 0;
+        size_t actions = 0;
+        size_t undos = 0;
+        size_t draws = 0;
+        std::vector<TournamentStats> by_entrant;
+        std::vector<TournamentStats> by_role; // Indexed by Role.
+        double seconds = 0.0;
+
+        void merge(const TournamentResult &other);
+        double games_per_second() const;
+    };
+
+    /**
+     * @brief Runs many independent matches across all cores.
+     *
+     * Matches are dealt round-robin onto one work-stealing deque per worker.
+     * Each worker plays its own matches first and then steals from the others,
+     * using its own policy instances and one simulator, whose pooled games are
+     * reused from match to match. Per-worker results are merged once all
+     * workers have finished.
+     */
+    class Tournament
+    {
+    private:
+        std::vector<Entrant> _entrants;
+        std::vector<Match> _matches;
+        size_t _max_actions;
+
+        void play_match(const Match &match, std::vector<std::unique_ptr<Policy>> &policies,
+                        std::unique_ptr<Simulator> &simulator, TournamentResult &result) const;
+
+    public:
+        explicit Tournament(size_t max_actions = 1000);
+
+        size_t add_entrant(const std::string &name, PolicyFactory make_policy);
+        void add_match(const Match &match);
+        void add_rotations(const std::vector<Role> &roles, const std::vector<size_t> &entrants,
+                           size_t games_per_match, size_t rounds, std::uint64_t seed);
+
+        const std::vector<Entrant> &entrants() const;
+        const std::vector<Match> &matches() const;
+
+        // threads == 0 uses every hardware thread. The first exception thrown
+        // by any worker stops the others and is rethrown once all have joined.
+        TournamentResult run(size_t threads = 0) const;
+    };
+}
@@ -0,0 +1,94 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * Scoped trace spans, exported as Chrome trace JSON.
+ *
+ * Build with -DCOUP_TRACE (`make ... TRACE=1`) to record them. Without it
+ * COUP_TRACE_SPAN and COUP_TRACE_FLAG_LAST expand to nothing. Open the output of
+ * write_chrome_trace() in chrome://tracing or ui.perfetto.dev.
+ */
+
+namespace coup
+{
+    // Timestamp counter read at both ends of a span.
+    inline std::uint64_t trace_clock()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // One finished span. `name` must be a string literal or otherwise outlive the trace.
+    struct TraceEvent
+    {
+        const char *name;
+        std::uint64_t begin;
+        std::uint64_t end;
+        std::uint32_t flags; // TRACE_* bits, exported as span arguments.
+    };
+
+    // The span's try_* result made the throwing action raise an exception.
+    const std::uint32_t TRACE_THREW = 1;
+
+    // Spans kept per thread; older ones are overwritten once a thread's ring is full.
+    const size_t TRACE_RING_SIZE = 1 << 16;
+
+    // Appends a span to the calling thread's ring, creating the ring on first use.
+    void record_trace(const char *name, std::uint64_t begin, std::uint64_t end);
+    // Sets `flags` on the calling thread's most recent span, if it has one.
+    // Spans are recorded when they close, so right after a call returns its
+    // span is the most recent one.
+    void flag_last_trace(std::uint32_t flags);
+
+    /**
+     * @brief Writes the spans of every thread as Chrome trace JSON.
+     *
+     * Each thread that recorded spans gets its own track. The rings are read
+     * without locking, so call this while the traced threads are idle, e.g.
+     * between frames or after a run.
+     */
+    void write_chrome_trace(std::ostream &out);
+    // Drops every buffered span.
+    void clear_trace();
+    // Spans currently buffered over all threads.
+    size_t trace_size();
+
+    // Records the time from construction to destruction as one span.
+    class TraceSpan
+    {
+    private:
+        const char *_name;
+        std::uint64_t _begin;
+
+    public:
+        explicit TraceSpan(const char *name) : _name(name), _begin(trace_clock()) {}
+        ~TraceSpan() { record_trace(_name, _begin, trace_clock()); }
+        TraceSpan(const TraceSpan &) = delete;
+        TraceSpan &operator=(const TraceSpan &) = delete;
+    };
+}
+
+#define COUP_TRACE_CONCAT_(a, b) a##b
+#define COUP_TRACE_CONCAT(a, b) COUP_TRACE_CONCAT_(a, b)
+
+#ifdef COUP_TRACE
+#define COUP_TRACE_SPAN(name) ::coup::TraceSpan COUP_TRACE_CONCAT(coup_trace_span_, __LINE__)(name)
+#define COUP_TRACE_FLAG_LAST(flags) ::coup::flag_last_trace(::coup::flags)
+#else
+#define COUP_TRACE_SPAN(name) ((void)0)
+#define COUP_TRACE_FLAG_LAST(flags) ((void)0)
+#endif
@@ -0,0 +1,77 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Action.hpp"
+#include "Role.hpp"
+#include "Rules.hpp"
+
+namespace coup
+{
+    // Discrete action space of VecEnv: one slot per action type and seat.
+    // Untargeted actions use seat slot 0; {None, NO_TARGET} passes a reaction.
+    const size_t VEC_ACTION_COUNT = ACTION_TYPE_COUNT * GameState::MAX_PLAYERS;
+
+    std::uint32_t action_index(const Action &action);
+    Action action_at(std::uint32_t index);
+
+    struct VecEnvConfig
+    {
+        size_t envs = 64;
+        std::vector<Role> lineup = {Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge, Role::Merchant};
+        size_t max_actions = 500; // Decisions before a game is cut off as a draw.
+        float illegal_reward = -1.0f; // Reward for an action the game refuses.
+    };
+
+    /**
+     * @brief Steps many independent games at once for training agents.
+     *
+     * Every game is a Position of the state-based rules engine, so the step
+     * loop makes no virtual calls and no allocations; all games share the
+     * starting state built once from the lineup. The caller passes one action
+     * index per game and contiguous buffers of envs() rows for the results:
+     *
+     * - observations: OBSERVATION_SIZE floats per game, seen from the seat that
+     *   decides next. Seats are listed starting from that seat, each as
+     *   active, coins / 10, sanctioned, extra action and a role one-hot,
+     *   followed by a reaction flag and a one-hot of the action that may be
+     *   undone.
+     * - rewards: for the seat that played the action, 1 if it won the game
+     *   with it, -1 if the game ended with another winner, 0 otherwise.
+     * - dones: 1 if the game ended (or hit max_actions) with this step. The
+     *   game is then reset, and its observation and mask describe the new game.
+     * - masks: bit i set if action_at(i) is legal for the seat that decides next.
+     * - refused (optional): 1 if the game's own rules refused the action. The
+     *   game is left as it was, the reward is illegal_reward and done is 0.
+     */
+    class VecEnv
+    {
+    private:
+        static const size_t SEAT_FEATURES = 4 + ROLE_COUNT;
+
+        VecEnvConfig _config;
+        GameState _start;
+        std::vector<Position> _positions;
+        std::vector<std::uint32_t> _steps;
+        std::vector<std::uint64_t> _legal; // Mask last written for each game, kept out of the caller's reach.
+
+        void write(size_t env, float *observation, std::uint64_t &mask);
+
+    public:
+        static const size_t OBSERVATION_SIZE = SEAT_FEATURES * GameState::MAX_PLAYERS + 1 + ACTION_TYPE_COUNT;
+
+        explicit VecEnv(const VecEnvConfig &config = VecEnvConfig());
+
+        size_t envs() const;
+        const Position &position(size_t env) const;
+
+        // Starts every game over and writes the first observations and masks.
+        void reset(float *observations, std::uint64_t *masks);
+        // Plays actions[i] in game i and returns how many actions were refused.
+        size_t step(const std::uint32_t *actions, float *observations, float *rewards,
+                    std::uint8_t *dones, std::uint64_t *masks, std::uint8_t *refused = nullptr);
+    };
+}
@@ -0,0 +1,45 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace coup
+{
+    /**
+     * @brief Fixed-capacity Chase-Lev work-stealing deque of task indices.
+     *
+     * The owning thread pushes and takes at the bottom; any other thread may
+     * steal from the top. No locks are taken on either path.
+     */
+    class WorkStealingDeque
+    {
+    public:
+        enum class Status
+        {
+            Success,
+            Empty,
+            Retry // Lost a race with another thief or the owner; the deque may still hold work.
+        };
+
+    private:
+        std::unique_ptr<std::atomic<size_t>[]> _buffer;
+        size_t _capacity;
+        alignas(64) std::atomic<std::int64_t> _top;
+        alignas(64) std::atomic<std::int64_t> _bottom;
+
+    public:
+        explicit WorkStealingDeque(size_t capacity);
+
+        // Owner only.
+        bool push(size_t task);
+        bool take(size_t &task);
+
+        // Any thread.
+        Status steal(size_t &task);
+        size_t size() const;
+    };
+}
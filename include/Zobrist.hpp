@@ -0,0 +1,50 @@
+//talgov44@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace coup
+{
+    // Every piece of game state that takes part in the Zobrist hash. Per-seat
+    // features are keyed by seat; game-wide ones use seat 0.
+    enum class ZobristFeature : std::uint8_t
+    {
+        Coins,
+        Active,
+        Sanctioned,
+        ExtraAction,
+        LastAction,
+        LastArrested, // Seat + 1, or 0 for nobody.
+        Turn,
+        SaveTarget, // Seat + 1, or 0 for nobody.
+        Started
+    };
+
+    /**
+     * @brief Zobrist key of one feature value.
+     *
+     * Keys are a fixed pseudo-random function of (feature, seat, value), so
+     * there is no table to initialise and coin counts are not bounded. The
+     * hash of a state is the XOR of the keys of all its feature values, and
+     * changing one value updates it with two XORs: the old key and the new.
+     */
+    inline std::uint64_t zobrist_key(ZobristFeature feature, size_t seat, int value)
+    {
+        std::uint64_t x = (static_cast<std::uint64_t>(feature) << 56) ^
+                          (static_cast<std::uint64_t>(seat) << 40) ^
+                          static_cast<std::uint32_t>(value);
+        // splitmix64 finaliser
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // Hash update for a feature that changes from `before` to `after`.
+    inline std::uint64_t zobrist_delta(ZobristFeature feature, size_t seat, int before, int after)
+    {
+        return before == after ? 0 : zobrist_key(feature, seat, before) ^ zobrist_key(feature, seat, after);
+    }
+}
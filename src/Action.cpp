@@ -0,0 +1,32 @@
+//talgov44@gmail.com
+
+#include "Action.hpp"
+
+namespace coup
+{
+    const char *to_string(ActionType type)
+    {
+        switch (type)
+        {
+        case ActionType::Gather:
+            return "gather";
+        case ActionType::Tax:
+            return "tax";
+        case ActionType::Bribe:
+            return "bribe";
+        case ActionType::Arrest:
+            return "arrest";
+        case ActionType::Sanction:
+            return "sanction";
+        case ActionType::Coup:
+            return "coup";
+        case ActionType::Invest:
+            return "invest";
+        case ActionType::Undo:
+            return "undo";
+        case ActionType::None:
+            break;
+        }
+        return "";
+    }
+}
@@ -0,0 +1,53 @@
+//talgov44@gmail.com
+
+#include "ActionResult.hpp"
+#include <stdexcept>
+
+namespace coup
+{
+    const char *describe(ActionResult result)
+    {
+        switch (result)
+        {
+        case ActionResult::Ok:
+            return "OK.";
+        case ActionResult::NoPlayers:
+            return "No players in the game.";
+        case ActionResult::NotEnoughPlayers:
+            return "Need at least 2 players to start the game.";
+        case ActionResult::GameOver:
+            return "Game has ended.";
+        case ActionResult::PlayerNotActive:
+            return "Player is not active.";
+        case ActionResult::NotYourTurn:
+            return "It's not this player's turn!";
+        case ActionResult::MustCoup:
+            return "Player must perform a coup with 10 or more coins.";
+        case ActionResult::Sanctioned:
+            return "Cannot use this action, you are sanctioned for this turn.";
+        case ActionResult::NotEnoughCoins:
+            return "Not enough coins for this action.";
+        case ActionResult::InvalidTarget:
+            return "Invalid target for this action.";
+        case ActionResult::RepeatArrest:
+            return "Cannot arrest the same player twice in a row.";
+        case ActionResult::TargetCannotPay:
+            return "Target does not have enough coins for this action.";
+        case ActionResult::CannotUndo:
+            return "This player cannot undo actions.";
+        case ActionResult::NothingToUndo:
+            return "The target's last action cannot be undone by this player.";
+        case ActionResult::UndoWindowClosed:
+            return "This player was not eliminated in the previous turn or the window to undo has closed.";
+        }
+        return "Unknown action result.";
+    }
+
+    void throw_if_failed(ActionResult result)
+    {
+        if (result != ActionResult::Ok)
+        {
+            throw std::runtime_error(describe(result));
+        }
+    }
+}
@@ -1,39 +1,60 @@
 //talgov44@gmail.com
 
 #include "Baron.hpp"
+#include "Constants.hpp"
+#include "Instrument.hpp"
+#include "Trace.hpp"
 
 namespace coup
 {
-    const int INVEST_COST = 3;
-    const int INVEST_RETURN = 6;
-
     Baron::Baron(Game &game, const std::string &name) : Player(game, name)
     {
-        this->_role = "Baron";
+        this->_role = Role::Baron;
+    }
+
+    void Baron::invest()
+    {
+        COUP_RECORD_LATENCY(Invest);
+        COUP_TRACK_ALLOCATIONS(Invest);
+        throw_action_error(try_invest());
     }
 
     /**
      * @brief A Baron can invest 3 coins to receive 6 in return.
      * This is a standard turn action.
      */
-    void Baron::invest()
+    ActionResult Baron::try_invest()
     {
+        COUP_RECORD_LATENCY(Invest);
+        COUP_TRACK_ALLOCATIONS(Invest);
+        COUP_TRACE_SPAN("Baron::try_invest");
+        ActionResult result = check_turn();
+        if (result == ActionResult::Ok)
+        {
+            result = must_coup();
+        }
+        if (result != ActionResult::Ok)
+        {
+            return result;
+        }
+        const int coins_before = this->_coins;
+        if (!this->_is_sanctioned && this->coins() < INVEST_COST)
+        {
+            return ActionResult::NotEnoughCoins;
+        }
         this->game.clearSaveWindow();
-        check_turn();
-        must_coup();
         if (this->_is_sanctioned)
         {
-            this->_is_sanctioned = false;
+            setSanctioned(false);
             end_turn_or_continue();
-            throw std::runtime_error("Cannot use invest, you are sanctioned for this turn.");
-        }
-        if (this->coins() < INVEST_COST)
-        {
-            throw std::runtime_error("Not enough coins to invest.");
+            report(EventKind::Action, ActionType::Invest, ActionResult::Sanctioned, nullptr, coins_before, 0);
+            return ActionResult::Sanctioned;
         }
         this->removeCoins(INVEST_COST);
         this->addCoins(INVEST_RETURN);
-        this->last_action = "invest";
+        setLastAction(ActionType::Invest);
         end_turn_or_continue();
+        report(EventKind::Action, ActionType::Invest, ActionResult::Ok, nullptr, coins_before, 0);
+        return ActionResult::Ok;
     }
 }
@@ -0,0 +1,531 @@
+//talgov44@gmail.com
+
+#include "BatchEngine.hpp"
+#include "Constants.hpp"
+#include "Game.hpp"
+#include "PlayerArena.hpp"
+#include "Rules.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define COUP_BATCH_X86 1
+#endif
+
+// The lane helpers pass 32-byte vectors by value, which would change the ABI
+// without AVX; they are always inlined, so no such call is ever emitted.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace coup
+{
+    namespace
+    {
+        typedef std::uint8_t Lanes16 __attribute__((vector_size(16)));
+        typedef std::uint8_t Lanes32 __attribute__((vector_size(32)));
+
+        // Byte arrays of one step, all indexed by game.
+        struct BatchView
+        {
+            std::uint8_t *coins;
+            const std::uint8_t *roles;
+            std::uint8_t *active;
+            std::uint8_t *sanctioned;
+            std::uint8_t *extra;
+            std::uint8_t *turn;
+            const std::uint8_t *actions;
+            const std::uint8_t *targets;
+            std::uint8_t *results;
+            size_t games;
+            size_t players;
+        };
+
+        const std::uint8_t GATHER = static_cast<std::uint8_t>(ActionType::Gather);
+        const std::uint8_t TAX = static_cast<std::uint8_t>(ActionType::Tax);
+        const std::uint8_t BRIBE = static_cast<std::uint8_t>(ActionType::Bribe);
+        const std::uint8_t COUP = static_cast<std::uint8_t>(ActionType::Coup);
+        const std::uint8_t INVEST = static_cast<std::uint8_t>(ActionType::Invest);
+        const std::uint8_t GOVERNOR = static_cast<std::uint8_t>(Role::Governor);
+        const std::uint8_t BARON = static_cast<std::uint8_t>(Role::Baron);
+        const std::uint8_t MERCHANT = static_cast<std::uint8_t>(Role::Merchant);
+
+        std::uint8_t result_code(ActionResult result)
+        {
+            return static_cast<std::uint8_t>(result);
+        }
+
+        // One game, in the order of the checks in apply_action().
+        void step_game(const BatchView &v, size_t g)
+        {
+            const size_t n = v.players;
+            const size_t mover = v.turn[g];
+            const std::uint8_t self = static_cast<std::uint8_t>(1u << mover);
+            const std::uint8_t action = v.actions[g];
+            std::uint8_t &coins = v.coins[mover * v.games + g];
+            const std::uint8_t role = v.roles[mover * v.games + g];
+            const int active_count = __builtin_popcount(v.active[g]);
+
+            if (action == INVEST && role != BARON)
+            {
+                v.results[g] = result_code(ActionResult::InvalidTarget);
+                return;
+            }
+            if (active_count < 2)
+            {
+                v.results[g] = result_code(ActionResult::GameOver);
+                return;
+            }
+            if (action != COUP && coins >= MUST_COUP_COINS)
+            {
+                v.results[g] = result_code(ActionResult::MustCoup);
+                return;
+            }
+
+            const bool income = action == GATHER || action == TAX || action == INVEST;
+            bool ends_turn = true;
+            bool eliminated = false;
+            if (income && (v.sanctioned[g] & self) != 0)
+            {
+                v.sanctioned[g] = static_cast<std::uint8_t>(v.sanctioned[g] & ~self);
+                v.results[g] = result_code(ActionResult::Sanctioned);
+            }
+            else
+            {
+                const int cost = action == BRIBE ? BRIBE_COST : action == COUP ? COUP_COST : action == INVEST ? INVEST_COST : 0;
+                if (coins < cost)
+                {
+                    v.results[g] = result_code(ActionResult::NotEnoughCoins);
+                    return;
+                }
+                const std::uint8_t target = v.targets[g];
+                const std::uint8_t victim = target < n ? static_cast<std::uint8_t>(1u << target) : 0;
+                if (action == COUP && ((v.active[g] & victim) == 0 || victim == self))
+                {
+                    v.results[g] = result_code(ActionResult::InvalidTarget);
+                    return;
+                }
+                if (!income)
+                {
+                    v.sanctioned[g] = static_cast<std::uint8_t>(v.sanctioned[g] & ~self);
+                }
+
+                switch (action)
+                {
+                case GATHER:
+                    coins = static_cast<std::uint8_t>(coins + 1);
+                    break;
+                case TAX:
+                    coins = static_cast<std::uint8_t>(coins + (role == GOVERNOR ? GOVERNOR_TAX_AMOUNT : TAX_AMOUNT));
+                    break;
+                case INVEST:
+                    coins = static_cast<std::uint8_t>(coins - INVEST_COST + INVEST_RETURN);
+                    break;
+                case BRIBE:
+                    coins = static_cast<std::uint8_t>(coins - BRIBE_COST);
+                    v.extra[g] = static_cast<std::uint8_t>(v.extra[g] | self);
+                    ends_turn = false;
+                    break;
+                default:
+                    coins = static_cast<std::uint8_t>(coins - COUP_COST);
+                    v.active[g] = static_cast<std::uint8_t>(v.active[g] & ~victim);
+                    eliminated = true;
+                    break;
+                }
+                v.results[g] = result_code(ActionResult::Ok);
+            }
+
+            if (!ends_turn)
+            {
+                return;
+            }
+            if ((v.extra[g] & self) != 0)
+            {
+                v.extra[g] = static_cast<std::uint8_t>(v.extra[g] & ~self);
+                return;
+            }
+            if (active_count - (eliminated ? 1 : 0) < 2)
+            {
+                return;
+            }
+            size_t next = mover;
+            do
+            {
+                next = (next + 1) % n;
+            } while ((v.active[g] >> next & 1) == 0);
+            v.turn[g] = static_cast<std::uint8_t>(next);
+            std::uint8_t &bonus = v.coins[next * v.games + g];
+            if (v.roles[next * v.games + g] == MERCHANT && bonus >= MERCHANT_BONUS_THRESHOLD)
+            {
+                bonus = static_cast<std::uint8_t>(bonus + 1);
+            }
+        }
+
+        template <typename V>
+        __attribute__((always_inline)) inline V load(const std::uint8_t *p)
+        {
+            V lanes;
+            std::memcpy(&lanes, p, sizeof(V));
+            return lanes;
+        }
+
+        template <typename V>
+        __attribute__((always_inline)) inline void store(std::uint8_t *p, const V &lanes)
+        {
+            std::memcpy(p, &lanes, sizeof(V));
+        }
+
+        /**
+         * @brief step_game() for sizeof(V) games at once, without branches.
+         *
+         * Every check of step_game() becomes a lane mask, and every write a
+         * select between the old and the new value. Per-seat lookups (the
+         * mover's coins and role, the seat bit of the mover and the target)
+         * are selects over the players() seat planes.
+         */
+        template <typename V>
+        __attribute__((always_inline)) inline void step_lanes(const BatchView &v, size_t g)
+        {
+            const V zero = {};
+            const V one = zero + 1;
+            const V turn = load<V>(v.turn + g);
+            const V action = load<V>(v.actions + g);
+            const V target = load<V>(v.targets + g);
+            V active = load<V>(v.active + g);
+            V sanctioned = load<V>(v.sanctioned + g);
+            V extra = load<V>(v.extra + g);
+
+            V coins = zero;
+            V role = zero;
+            V self = zero;
+            V victim = zero;
+            V count = zero;
+            for (size_t s = 0; s < v.players; ++s)
+            {
+                const V bit = zero + static_cast<std::uint8_t>(1u << s);
+                const auto is_mover = turn == static_cast<std::uint8_t>(s);
+                coins = is_mover ? load<V>(v.coins + s * v.games + g) : coins;
+                role = is_mover ? load<V>(v.roles + s * v.games + g) : role;
+                self = is_mover ? bit : self;
+                victim = target == static_cast<std::uint8_t>(s) ? bit : victim;
+                count += (active & bit) != 0 ? one : zero;
+            }
+
+            const auto is_gather = action == GATHER;
+            const auto is_tax = action == TAX;
+            const auto is_invest = action == INVEST;
+            const auto is_bribe = action == BRIBE;
+            const auto is_coup = action == COUP;
+            const auto income = is_gather | is_tax | is_invest;
+
+            const auto bad_invest = is_invest & (role != BARON);
+            const auto game_over = ~bad_invest & (count < 2);
+            const auto must_coup = ~bad_invest & ~game_over & ~is_coup & (coins >= MUST_COUP_COINS);
+            const auto refused = bad_invest | game_over | must_coup;
+            const auto forfeit = ~refused & income & ((sanctioned & self) != 0);
+            const auto poor = ~refused & ~forfeit &
+                              ((is_invest & (coins < INVEST_COST)) | (is_bribe & (coins < BRIBE_COST)) |
+                               (is_coup & (coins < COUP_COST)));
+            const auto bad_target = ~refused & ~poor & is_coup & (((active & victim) == 0) | (victim == self));
+            const auto done = ~refused & ~forfeit & ~poor & ~bad_target;
+
+            V result = zero + result_code(ActionResult::Ok);
+            result = bad_target ? zero + result_code(ActionResult::InvalidTarget) : result;
+            result = poor ? zero + result_code(ActionResult::NotEnoughCoins) : result;
+            result = forfeit ? zero + result_code(ActionResult::Sanctioned) : result;
+            result = must_coup ? zero + result_code(ActionResult::MustCoup) : result;
+            result = game_over ? zero + result_code(ActionResult::GameOver) : result;
+            result = bad_invest ? zero + result_code(ActionResult::InvalidTarget) : result;
+
+            const V tax = role == GOVERNOR ? zero + GOVERNOR_TAX_AMOUNT : zero + TAX_AMOUNT;
+            V delta = is_gather ? one : zero;
+            delta = is_tax ? tax : delta;
+            delta = is_invest ? zero + (INVEST_RETURN - INVEST_COST) : delta;
+            delta = is_bribe ? zero - BRIBE_COST : delta;
+            delta = is_coup ? zero - COUP_COST : delta;
+            coins = done ? coins + delta : coins;
+
+            const auto clears = forfeit | (done & (is_bribe | is_coup));
+            sanctioned = clears ? (sanctioned & ~self) : sanctioned;
+            const auto eliminated = done & is_coup;
+            active = eliminated ? (active & ~victim) : active;
+            extra = (done & is_bribe) ? (extra | self) : extra;
+
+            const auto ends = forfeit | (done & ~is_bribe);
+            const auto continues = ends & ((extra & self) != 0);
+            extra = continues ? (extra & ~self) : extra;
+            const auto advances = ends & ~continues & ((count - (eliminated ? one : zero)) >= 2);
+
+            // Next active seat after the mover, wrapping around.
+            V after = zero;
+            V first = zero;
+            auto found = turn != turn;
+            for (size_t s = v.players; s-- > 0;)
+            {
+                const auto on = (active & static_cast<std::uint8_t>(1u << s)) != 0;
+                const auto later = on & (turn < static_cast<std::uint8_t>(s));
+                after = later ? zero + static_cast<std::uint8_t>(s) : after;
+                found |= later;
+                first = on ? zero + static_cast<std::uint8_t>(s) : first;
+            }
+            const V next = found ? after : first;
+
+            for (size_t s = 0; s < v.players; ++s)
+            {
+                std::uint8_t *plane = v.coins + s * v.games + g;
+                V seat_coins = load<V>(plane);
+                seat_coins = turn == static_cast<std::uint8_t>(s) ? coins : seat_coins;
+                const auto bonus = advances & (next == static_cast<std::uint8_t>(s)) &
+                                   (load<V>(v.roles + s * v.games + g) == MERCHANT) &
+                                   (seat_coins >= MERCHANT_BONUS_THRESHOLD);
+                store(plane, bonus ? seat_coins + 1 : seat_coins);
+            }
+            store(v.turn + g, advances ? next : turn);
+            store(v.active + g, active);
+            store(v.sanctioned + g, sanctioned);
+            store(v.extra + g, extra);
+            store(v.results + g, result);
+        }
+
+        void step_scalar(const BatchView &v)
+        {
+            for (size_t g = 0; g < v.games; ++g)
+            {
+                step_game(v, g);
+            }
+        }
+
+        template <typename V>
+        __attribute__((always_inline)) inline void step_vectors(const BatchView &v)
+        {
+            size_t g = 0;
+            for (; g + sizeof(V) <= v.games; g += sizeof(V))
+            {
+                step_lanes<V>(v, g);
+            }
+            for (; g < v.games; ++g)
+            {
+                step_game(v, g);
+            }
+        }
+
+#ifdef COUP_BATCH_X86
+        __attribute__((target("sse2"))) void step_sse2(const BatchView &v)
+        {
+            step_vectors<Lanes16>(v);
+        }
+
+        __attribute__((target("avx2"))) void step_avx2(const BatchView &v)
+        {
+            step_vectors<Lanes32>(v);
+        }
+#endif
+
+        bool supported(BatchIsa isa)
+        {
+            switch (isa)
+            {
+            case BatchIsa::Scalar:
+                return true;
+#ifdef COUP_BATCH_X86
+            case BatchIsa::Sse2:
+                return __builtin_cpu_supports("sse2");
+            case BatchIsa::Avx2:
+                return __builtin_cpu_supports("avx2");
+#endif
+            default:
+                return false;
+            }
+        }
+    }
+
+    const char *to_string(BatchIsa isa)
+    {
+        switch (isa)
+        {
+        case BatchIsa::Scalar:
+            return "scalar";
+        case BatchIsa::Sse2:
+            return "sse2";
+        case BatchIsa::Avx2:
+            return "avx2";
+        }
+        return "";
+    }
+
+    /**
+     * @throws std::runtime_error If there are no games, or the lineup does not
+     *                            fit a GameState.
+     */
+    BatchEngine::BatchEngine(size_t games, const std::vector<Role> &lineup)
+        : _games(games), _players(lineup.size()), _isa(best_isa())
+    {
+        if (_games == 0)
+        {
+            throw std::runtime_error("BatchEngine needs at least one game.");
+        }
+        if (_players < 2 || _players > GameState::MAX_PLAYERS)
+        {
+            throw std::runtime_error("BatchEngine lineup must have 2 to 6 players.");
+        }
+        _coins.assign(_players * _games, 0);
+        _roles.assign(_players * _games, 0);
+        _active.assign(_games, 0);
+        _sanctioned.assign(_games, 0);
+        _extra.assign(_games, 0);
+        _turn.assign(_games, 0);
+
+        Game game;
+        PlayerArena players;
+        for (size_t i = 0; i < _players; ++i)
+        {
+            players.create(game, lineup[i], "P" + std::to_string(i));
+        }
+        const GameState start = GameState::capture(game);
+        for (size_t g = 0; g < _games; ++g)
+        {
+            load(g, start);
+        }
+    }
+
+    BatchIsa BatchEngine::best_isa()
+    {
+        if (supported(BatchIsa::Avx2))
+        {
+            return BatchIsa::Avx2;
+        }
+        return supported(BatchIsa::Sse2) ? BatchIsa::Sse2 : BatchIsa::Scalar;
+    }
+
+    size_t BatchEngine::games() const
+    {
+        return _games;
+    }
+
+    size_t BatchEngine::players() const
+    {
+        return _players;
+    }
+
+    BatchIsa BatchEngine::isa() const
+    {
+        return _isa;
+    }
+
+    /**
+     * @throws std::runtime_error If this CPU does not support `isa`.
+     */
+    void BatchEngine::set_isa(BatchIsa isa)
+    {
+        if (!supported(isa))
+        {
+            throw std::runtime_error(std::string("This CPU does not support ") + to_string(isa) + ".");
+        }
+        _isa = isa;
+    }
+
+    int BatchEngine::coins(size_t game, size_t seat) const
+    {
+        return _coins.at(seat * _games + game);
+    }
+
+    size_t BatchEngine::turn(size_t game) const
+    {
+        return _turn.at(game);
+    }
+
+    bool BatchEngine::is_active(size_t game, size_t seat) const
+    {
+        return (_active.at(game) >> seat & 1) != 0;
+    }
+
+    /**
+     * @throws std::runtime_error If the game index is out of range or the state
+     *                            has a different number of seats.
+     */
+    void BatchEngine::load(size_t game, const GameState &state)
+    {
+        if (game >= _games || state.player_count != _players)
+        {
+            throw std::runtime_error("GameState does not fit this batch.");
+        }
+        std::uint8_t active = 0;
+        std::uint8_t sanctioned = 0;
+        std::uint8_t extra = 0;
+        for (size_t s = 0; s < _players; ++s)
+        {
+            const PlayerState &player = state.players[s];
+            _coins[s * _games + game] = player.coins;
+            _roles[s * _games + game] = static_cast<std::uint8_t>(player.role);
+            active |= player.has(PlayerState::ACTIVE) ? static_cast<std::uint8_t>(1u << s) : 0;
+            sanctioned |= player.has(PlayerState::SANCTIONED) ? static_cast<std::uint8_t>(1u << s) : 0;
+            extra |= player.has(PlayerState::EXTRA_ACTION) ? static_cast<std::uint8_t>(1u << s) : 0;
+        }
+        _active[game] = active;
+        _sanctioned[game] = sanctioned;
+        _extra[game] = extra;
+        _turn[game] = static_cast<std::uint8_t>(current_seat(state));
+    }
+
+    GameState BatchEngine::store(size_t game) const
+    {
+        GameState state;
+        std::memset(&state, 0, sizeof(state));
+        state.player_count = static_cast<std::uint8_t>(_players);
+        state.turn = _turn.at(game);
+        state.save_target = NO_TARGET;
+        state.flags = GameState::STARTED;
+        for (size_t s = 0; s < _players; ++s)
+        {
+            PlayerState &player = state.players[s];
+            player.coins = _coins[s * _games + game];
+            player.role = static_cast<Role>(_roles[s * _games + game]);
+            player.set(PlayerState::ACTIVE, (_active[game] >> s & 1) != 0);
+            player.set(PlayerState::SANCTIONED, (_sanctioned[game] >> s & 1) != 0);
+            player.set(PlayerState::EXTRA_ACTION, (_extra[game] >> s & 1) != 0);
+            player.last_action = ActionType::None;
+            player.last_arrested = NO_TARGET;
+        }
+        return state;
+    }
+
+    /**
+     * @throws std::runtime_error If an action is not gather, tax, invest,
+     *                            bribe or coup. No game is changed then.
+     */
+    void BatchEngine::step(const ActionType *actions, const std::int8_t *targets, ActionResult *results)
+    {
+        for (size_t g = 0; g < _games; ++g)
+        {
+            switch (actions[g])
+            {
+            case ActionType::Gather:
+            case ActionType::Tax:
+            case ActionType::Invest:
+            case ActionType::Bribe:
+            case ActionType::Coup:
+                break;
+            default:
+                throw std::runtime_error(std::string("BatchEngine cannot play ") + to_string(actions[g]) + ".");
+            }
+        }
+
+        const BatchView view = {_coins.data(), _roles.data(), _active.data(), _sanctioned.data(), _extra.data(),
+                                _turn.data(), reinterpret_cast<const std::uint8_t *>(actions),
+                                reinterpret_cast<const std::uint8_t *>(targets),
+                                reinterpret_cast<std::uint8_t *>(results), _games, _players};
+        switch (_isa)
+        {
+#ifdef COUP_BATCH_X86
+        case BatchIsa::Avx2:
+            step_avx2(view);
+            return;
+        case BatchIsa::Sse2:
+            step_sse2(view);
+            return;
+#endif
+        default:
+            step_scalar(view);
+            return;
+        }
+    }
+}
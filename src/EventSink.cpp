@@ -0,0 +1,104 @@
+//talgov44@gmail.com
+
+#include "EventSink.hpp"
+#include "Game.hpp"
+#include "Player.hpp"
+#include <type_traits>
+
+namespace coup
+{
+    static_assert(std::is_trivially_copyable<GameEvent>::value, "GameEvent must be trivially copyable");
+    static_assert(sizeof(GameEvent) == 12, "GameEvent must stay fixed-width");
+
+    namespace
+    {
+        std::string name_at(const Game &game, std::uint16_t seat)
+        {
+            const std::vector<Player *> &players = game.get_players();
+            return seat < players.size() ? players[seat]->getName() : "?";
+        }
+    }
+
+    TextEventSink::TextEventSink(std::ostream &out, size_t capacity) : _out(out), _capacity(capacity)
+    {
+        this->_buffer.reserve(capacity);
+    }
+
+    TextEventSink::~TextEventSink()
+    {
+        flush();
+    }
+
+    void TextEventSink::record(const Game &game, const GameEvent &event)
+    {
+        switch (event.kind)
+        {
+        case EventKind::Turn:
+            this->_buffer += name_at(game, event.actor);
+            break;
+        case EventKind::SpyReport:
+            this->_buffer += "[SPY REPORT] ";
+            this->_buffer += name_at(game, event.actor);
+            this->_buffer += " sees that ";
+            this->_buffer += name_at(game, event.target);
+            this->_buffer += " has ";
+            this->_buffer += std::to_string(event.target_delta);
+            this->_buffer += " coins.";
+            break;
+        case EventKind::Action:
+        case EventKind::Undo:
+            this->_buffer += name_at(game, event.actor);
+            this->_buffer += ' ';
+            this->_buffer += to_string(event.action);
+            if (event.target != NO_SEAT)
+            {
+                this->_buffer += ' ';
+                this->_buffer += name_at(game, event.target);
+            }
+            if (event.result != ActionResult::Ok)
+            {
+                this->_buffer += " (";
+                this->_buffer += describe(event.result);
+                this->_buffer += ')';
+            }
+            break;
+        }
+        this->_buffer += '\n';
+        if (this->_buffer.size() >= this->_capacity)
+        {
+            flush();
+        }
+    }
+
+    void TextEventSink::flush()
+    {
+        if (!this->_buffer.empty())
+        {
+            this->_out.write(this->_buffer.data(), static_cast<std::streamsize>(this->_buffer.size()));
+            this->_out.flush();
+            this->_buffer.clear();
+        }
+    }
+
+    void BinaryEventSink::record(const Game &game, const GameEvent &event)
+    {
+        (void)game;
+        this->_events.push_back(event);
+    }
+
+    const std::vector<GameEvent> &BinaryEventSink::events() const
+    {
+        return this->_events;
+    }
+
+    void BinaryEventSink::clear()
+    {
+        this->_events.clear();
+    }
+
+    void BinaryEventSink::write(std::ostream &out) const
+    {
+        out.write(reinterpret_cast<const char *>(this->_events.data()),
+                  static_cast<std::streamsize>(this->_events.size() * sizeof(GameEvent)));
+    }
+}
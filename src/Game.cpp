@@ -2,15 +2,33 @@
 
 #include "Game.hpp"
 #include "Player.hpp"
-#include <iostream>
+#include "Constants.hpp"
+#include "Instrument.hpp"
+#include "Trace.hpp"
+#include "Zobrist.hpp"
 #include <stdexcept>
 #include <algorithm>
 
 namespace coup
 {
-    const int MERCHANT_BONUS_THRESHOLD = 3;
-
-    Game::Game() : _turn_index(0), _game_started(false) {}
+    /**
+     * @throws std::runtime_error If `max_players` is below MIN_PLAYERS or above
+     *                            MAX_LOBBY_PLAYERS.
+     */
+    Game::Game(size_t max_players) : _max_players(max_players), _turn_index(0), _game_started(false),
+                                     _save_seat(NO_TARGET), _event_sink(nullptr), _hidden_coins(false)
+    {
+        if (max_players < MIN_PLAYERS || max_players > MAX_LOBBY_PLAYERS)
+        {
+            throw std::runtime_error("A game seats between 2 and " + std::to_string(MAX_LOBBY_PLAYERS) + " players.");
+        }
+        _players.reserve(max_players);
+        _coin_epoch.reserve(max_players);
+        this->_active = SeatSet(max_players);
+        this->_hash = zobrist_key(ZobristFeature::Turn, 0, 0) ^
+                      zobrist_key(ZobristFeature::SaveTarget, 0, 0) ^
+                      zobrist_key(ZobristFeature::Started, 0, 0);
+    }
 
     Game::~Game() {}
 
@@ -24,36 +42,154 @@ namespace coup
      * @param player A pointer to the Player object to be added. The Game does not
      *               take ownership of the pointer.
      * @throws std::runtime_error if the game has already started.
-     * @throws std::runtime_error if the game is full (maximum of 6 players).
+     * @throws std::runtime_error if the game is full (max_players(), 6 by default).
      */
     void Game::add_player(Player *player)
     {
-        const size_t max_players = 6;
-        const size_t min_players_to_start = 2;
-        if (_game_started && this->players().size() >= min_players_to_start)
+        if (_game_started && active_players_count() >= MIN_PLAYERS)
         {
             throw std::runtime_error("Game has already started, cannot add more players.");
         }
-        if (_players.size() >= max_players)
+        if (_players.size() >= _max_players)
         {
             throw std::runtime_error("Game is full, cannot add more players.");
         }
         _players.push_back(player);
+        _coin_epoch.push_back(0);
+        set_active(_players.size() - 1, player->isActive());
+
+        // Fold the new seat's starting state into the hash.
+        this->_hash ^= seat_hash(_players.size() - 1);
+    }
+
+    // Hash contribution of a seat whose player has not acted yet.
+    std::uint64_t Game::seat_hash(size_t seat) const
+    {
+        const Player *player = _players[seat];
+        return zobrist_key(ZobristFeature::Coins, seat, player->coins()) ^
+               zobrist_key(ZobristFeature::Active, seat, player->isActive()) ^
+               zobrist_key(ZobristFeature::Sanctioned, seat, player->isSanctioned()) ^
+               zobrist_key(ZobristFeature::ExtraAction, seat, player->hasExtraAction()) ^
+               zobrist_key(ZobristFeature::LastAction, seat, static_cast<int>(player->lastActionType())) ^
+               zobrist_key(ZobristFeature::LastArrested, seat, 0);
+    }
+
+    /**
+     * @brief Starts the game over with the same players in the same seats.
+     *
+     * Every player gets back its starting coins and flags, the turn returns to
+     * seat 0 and the game counts as not started. The hidden-coin mode and the
+     * event sink are settings rather than game state and are kept. Nothing is
+     * allocated, so a game and its players can be reused for many matches.
+     */
+    void Game::reset()
+    {
+        this->_turn_index = 0;
+        this->_game_started = false;
+        this->_save_seat = NO_TARGET;
+        _revealed.clear();
+        this->_hash = zobrist_key(ZobristFeature::Turn, 0, 0) ^
+                      zobrist_key(ZobristFeature::SaveTarget, 0, 0) ^
+                      zobrist_key(ZobristFeature::Started, 0, 0);
+        for (size_t seat = 0; seat < _players.size(); ++seat)
+        {
+            _players[seat]->reset();
+            _active.insert(seat);
+            this->_hash ^= seat_hash(seat);
+        }
+    }
+
+    void Game::set_turn_index(size_t index)
+    {
+        this->_hash ^= zobrist_delta(ZobristFeature::Turn, 0, static_cast<int>(_turn_index), static_cast<int>(index));
+        this->_turn_index = index;
+    }
+
+    void Game::mark_started()
+    {
+        this->_hash ^= zobrist_delta(ZobristFeature::Started, 0, _game_started, true);
+        this->_game_started = true;
+    }
+
+    // Called by Player::eliminate() and Player::revive().
+    void Game::set_active(size_t seat, bool active)
+    {
+        if (active)
+        {
+            _active.insert(seat);
+        }
+        else
+        {
+            _active.erase(seat);
+        }
+    }
+
+    /**
+     * @brief The first active seat at or after `seat`, wrapping around the table.
+     *
+     * Found with a bit scan of the active set instead of walking the players.
+     * There must be at least one active player.
+     */
+    size_t Game::first_active_from(size_t seat) const
+    {
+        return _active.find_circular(seat);
+    }
+
+    void Game::set_hidden_coins(bool hidden)
+    {
+        this->_hidden_coins = hidden;
+        _revealed.clear();
+    }
+
+    /**
+     * @brief Whether `observer` may see how many coins `target` holds.
+     *
+     * Always true outside imperfect-information mode and for a player's own
+     * coins. Otherwise only true after Spy::spyOn() revealed the target's coins
+     * to the observer, and only until the target's coin count changes.
+     */
+    bool Game::can_see_coins(const Player &observer, const Player &target) const
+    {
+        if (!_hidden_coins || &observer == &target)
+        {
+            return true;
+        }
+        const auto seen = _revealed.find(std::uint64_t(observer.seat()) << 32 | target.seat());
+        return seen != _revealed.end() && seen->second == _coin_epoch[target.seat()];
+    }
+
+    void Game::reveal_coins(const Player &observer, const Player &target)
+    {
+        _revealed[std::uint64_t(observer.seat()) << 32 | target.seat()] = _coin_epoch[target.seat()];
+    }
+
+    // Called whenever a player's coin count changes. Earlier reveals of the
+    // seat go stale without visiting every observer.
+    void Game::conceal_coins(size_t seat)
+    {
+        ++_coin_epoch[seat];
+    }
+
+    void Game::set_event_sink(EventSink *sink)
+    {
+        this->_event_sink = sink;
     }
 
     void Game::setPlayerToSave(Player *player)
     {
-        this->_player_to_be_saved = player;
+        const std::int16_t seat = player == nullptr ? NO_TARGET : static_cast<std::int16_t>(player->seat());
+        this->_hash ^= zobrist_delta(ZobristFeature::SaveTarget, 0, _save_seat + 1, seat + 1);
+        this->_save_seat = seat;
     }
 
     Player *Game::getPlayerToSave() const
     {
-        return this->_player_to_be_saved;
+        return this->_save_seat == NO_TARGET ? nullptr : _players[this->_save_seat];
     }
 
     void Game::clearSaveWindow()
     {
-        this->_player_to_be_saved = nullptr;
+        setPlayerToSave(nullptr);
     }
 
     const std::vector<Player *> &Game::get_players() const
@@ -61,6 +197,225 @@ namespace coup
         return _players;
     }
 
+    /**
+     * @brief Returns the seat index of a player, i.e. its position in get_players().
+     *
+     * @throws std::runtime_error If the player is not part of this game.
+     */
+    size_t Game::seat_of(const Player &player) const
+    {
+        const size_t seat = player.seat();
+        if (seat < _players.size() && _players[seat] == &player)
+        {
+            return seat;
+        }
+        throw std::runtime_error("Player is not part of this game.");
+    }
+
+    // Whether it is `player`'s turn, found the same way current_player() does.
+    bool Game::is_turn_of(const Player &player) const
+    {
+        if (!player.isActive() || _players.size() < 2 || (_game_started && active_players_count() < 2))
+        {
+            return false;
+        }
+        return _players[first_active_from(_turn_index)] == &player;
+    }
+
+    // Coins the player acts with on its turn. The Merchant's start-of-game
+    // bonus is only paid by the first turn() call, so it is counted in advance.
+    int Game::turn_coins(const Player &player) const
+    {
+        int coins = player.coins();
+        if (!_game_started && player.roleType() == Role::Merchant && coins >= MERCHANT_BONUS_THRESHOLD)
+        {
+            coins += 1;
+        }
+        return coins;
+    }
+
+    // Whether `player` has an open undo window against the player in `seat`:
+    // exactly the cases in which the role's try_undo() returns Ok.
+    bool Game::can_undo(const Player &player, size_t seat) const
+    {
+        const Player *other = _players[seat];
+        switch (player.roleType())
+        {
+        case Role::Governor:
+            return other != &player && other->isActive() && other->lastActionType() == ActionType::Tax;
+        case Role::Judge:
+            return other->lastActionType() == ActionType::Bribe;
+        case Role::Spy:
+            return other->lastActionType() == ActionType::Arrest && other->getLastArrestedTarget() != nullptr;
+        case Role::General:
+            return static_cast<int>(seat) == _save_seat && !other->isActive() && player.coins() >= GENERAL_UNDO_COST;
+        default:
+            return false;
+        }
+    }
+
+    // Whether the player to move, holding `coins`, may arrest, sanction or coup the player in `seat`.
+    bool Game::can_target(const Player &player, ActionType type, size_t seat, int coins) const
+    {
+        const Player *target = _players[seat];
+        if (target == &player || !target->isActive())
+        {
+            return false;
+        }
+        const bool must_coup = coins >= MUST_COUP_COINS;
+        switch (type)
+        {
+        case ActionType::Coup:
+            return coins >= COUP_COST;
+        case ActionType::Arrest:
+        {
+            const int arrest_min = target->roleType() == Role::Merchant ? MERCHANT_ARREST_PENALTY : 1;
+            return !must_coup && target != player.getLastArrestedTarget() && target->coins() >= arrest_min;
+        }
+        case ActionType::Sanction:
+            return !must_coup && coins >= SANCTION_COST;
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * @brief Lists every action the player may take right now without throwing.
+     *
+     * Turn actions are only reported for the player whose turn it is, and
+     * follow the same rules as the actions themselves: only coup at 10+ coins,
+     * the bribe, sanction, coup and invest costs, no arresting the same
+     * player twice in a row, and the Merchant arrest penalty. Undo targets
+     * follow the roles' try_undo() and are reported whenever it would succeed,
+     * on any player's turn and, as try_undo() does not check it, even for an
+     * eliminated player: a Governor against another active player whose
+     * last action was tax, a Judge against any player whose last action was a
+     * bribe, a Spy against any player whose last action was an arrest, and a
+     * General with 5+ coins against the victim of the latest coup.
+     *
+     * The Merchant's start-of-game bonus is taken into account before the
+     * first turn has been announced. Turn actions only target active seats.
+     *
+     * @param player A player of this game.
+     * @return LegalActions The action mask and target masks, by seat index.
+     * @throws std::runtime_error If the game has more than 64 seats, which the
+     *                            target masks cannot hold. Use is_legal() there.
+     */
+    LegalActions Game::legal_actions(const Player &player) const
+    {
+        if (_players.size() > LEGAL_ACTIONS_MAX_SEATS)
+        {
+            throw std::runtime_error("legal_actions() supports at most 64 seats.");
+        }
+        LegalActions legal;
+        switch (player.roleType())
+        {
+        case Role::General:
+            if (_save_seat != NO_TARGET && can_undo(player, static_cast<size_t>(_save_seat)))
+            {
+                legal.allow(ActionType::Undo, static_cast<size_t>(_save_seat));
+            }
+            break;
+        case Role::Spy:
+        case Role::Judge:
+            for (size_t seat = 0; seat < _players.size(); ++seat)
+            {
+                if (can_undo(player, seat))
+                {
+                    legal.allow(ActionType::Undo, seat);
+                }
+            }
+            break;
+        case Role::Governor:
+            for (size_t seat = _active.find(0); seat != SeatSet::NONE; seat = _active.find(seat + 1))
+            {
+                if (can_undo(player, seat))
+                {
+                    legal.allow(ActionType::Undo, seat);
+                }
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (!is_turn_of(player))
+        {
+            return legal;
+        }
+        const int coins = turn_coins(player);
+        const bool must_coup = coins >= MUST_COUP_COINS;
+        if (!must_coup)
+        {
+            legal.allow(ActionType::Gather);
+            legal.allow(ActionType::Tax);
+            if (coins >= BRIBE_COST)
+            {
+                legal.allow(ActionType::Bribe);
+            }
+            if (player.roleType() == Role::Baron && coins >= INVEST_COST)
+            {
+                legal.allow(ActionType::Invest);
+            }
+        }
+        const ActionType targeted[] = {ActionType::Arrest, ActionType::Sanction, ActionType::Coup};
+        for (size_t seat = _active.find(0); seat != SeatSet::NONE; seat = _active.find(seat + 1))
+        {
+            for (ActionType type : targeted)
+            {
+                if (can_target(player, type, seat, coins))
+                {
+                    legal.allow(type, seat);
+                }
+            }
+        }
+        return legal;
+    }
+
+    /**
+     * @brief Checks a single action against the rules of legal_actions().
+     *
+     * Looks only at the player, the target and the turn, so the cost is the
+     * same at 6 seats and at thousands, and no target mask limits the seat.
+     *
+     * @return bool True if legal_actions(player) would allow the action.
+     */
+    bool Game::is_legal(const Player &player, const Action &action) const
+    {
+        const bool targeted = action.type == ActionType::Arrest || action.type == ActionType::Sanction ||
+                              action.type == ActionType::Coup || action.type == ActionType::Undo;
+        if (targeted && (action.target < 0 || static_cast<size_t>(action.target) >= _players.size()))
+        {
+            return false;
+        }
+        if (action.type == ActionType::Undo)
+        {
+            return can_undo(player, static_cast<size_t>(action.target));
+        }
+        if (!is_turn_of(player))
+        {
+            return false;
+        }
+        const int coins = turn_coins(player);
+        const bool must_coup = coins >= MUST_COUP_COINS;
+        switch (action.type)
+        {
+        case ActionType::Gather:
+        case ActionType::Tax:
+            return !must_coup;
+        case ActionType::Bribe:
+            return !must_coup && coins >= BRIBE_COST;
+        case ActionType::Invest:
+            return !must_coup && player.roleType() == Role::Baron && coins >= INVEST_COST;
+        case ActionType::Arrest:
+        case ActionType::Sanction:
+        case ActionType::Coup:
+            return can_target(player, action.type, static_cast<size_t>(action.target), coins);
+        default:
+            return false;
+        }
+    }
+
     /**
      * @brief Determines and returns the name of the current player whose turn it is.
      *
@@ -73,53 +428,95 @@ namespace coup
      * @throws std::runtime_error If the game has ended (fewer than 2 active players and game already started).
      * @throws std::runtime_error If the game has not started and there are fewer than 2 players.
      *
-     * @note This function also prints the current player's name to standard output.
+     * @note This function also sends a Turn event to the attached event sink, if any.
+     *       Engine code should use current_player(), which does not.
      * @note The game is considered started after the first successful call to this function.
      */
     std::string Game::turn()
+    {
+        COUP_TRACK_ALLOCATIONS(Turn);
+        COUP_TRACE_SPAN("Game::turn");
+        Player *current = current_player();
+        if (_event_sink != nullptr)
+        {
+            GameEvent event{};
+            event.kind = EventKind::Turn;
+            event.result = ActionResult::Ok;
+            event.actor = static_cast<std::uint16_t>(_turn_index);
+            event.target = NO_SEAT;
+            _event_sink->record(*this, event);
+        }
+        return current->getName();
+    }
+
+    /**
+     * @brief Returns the player whose turn it is, without any console output.
+     *
+     * Performs the same validation and start-of-game bookkeeping as turn(), but
+     * hands back the Player itself so callers on the action path can compare by
+     * identity instead of by name.
+     *
+     * @return Player* The player whose turn it is.
+     * @throws std::runtime_error Under the same conditions as turn().
+     */
+    Player *Game::current_player()
+    {
+        Player *current = nullptr;
+        throw_if_failed(try_current_player(current));
+        return current;
+    }
+
+    /**
+     * @brief Non-throwing version of current_player().
+     *
+     * @param current Set to the player whose turn it is when the result is Ok.
+     * @return ActionResult NoPlayers, GameOver or NotEnoughPlayers when there is
+     *                      no current player, otherwise Ok.
+     */
+    ActionResult Game::try_current_player(Player *&current)
     {
         if (_players.empty())
         {
-            throw std::runtime_error("No players in the game.");
+            return ActionResult::NoPlayers;
         }
         if (active_players_count() < 2 && _game_started)
         {
-            throw std::runtime_error("Game has ended.");
+            return ActionResult::GameOver;
         }
         if (!_game_started && _players.size() < 2)
         {
-            throw std::runtime_error("Need at least 2 players to start the game.");
+            return ActionResult::NotEnoughPlayers;
         }
 
-        while (!_players.at(_turn_index)->isActive())
+        if (_active.empty())
         {
-            _turn_index = (_turn_index + 1) % _players.size();
+            return ActionResult::GameOver;
         }
+        set_turn_index(first_active_from(_turn_index));
 
         // Apply start-of-turn effects before returning the player's name
         if (!_game_started)
         {
             Player *currentPlayer = _players.at(_turn_index);
-            if (currentPlayer->role() == "Merchant" && currentPlayer->coins() >= MERCHANT_BONUS_THRESHOLD)
+            if (currentPlayer->roleType() == Role::Merchant && currentPlayer->coins() >= MERCHANT_BONUS_THRESHOLD)
             {
                 currentPlayer->addCoins(1);
             }
         }
 
-        _game_started = true;
-        std::cout << _players.at(_turn_index)->getName() << std::endl;
-        return _players.at(_turn_index)->getName();
+        mark_started();
+        current = _players.at(_turn_index);
+        return ActionResult::Ok;
     }
 
     std::vector<std::string> Game::players()
     {
+        COUP_TRACK_ALLOCATIONS(Players);
         std::vector<std::string> active_players_names;
-        for (const auto &p : _players)
+        active_players_names.reserve(active_players_count());
+        for (size_t seat = _active.find(0); seat != SeatSet::NONE; seat = _active.find(seat + 1))
         {
-            if (p->isActive())
-            {
-                active_players_names.push_back(p->getName());
-            }
+            active_players_names.push_back(_players[seat]->getName());
         }
         return active_players_names;
     }
@@ -134,15 +531,7 @@ namespace coup
         {
             throw std::runtime_error("Game is still active or has not concluded.");
         }
-
-        for (const auto &p : _players)
-        {
-            if (p->isActive())
-            {
-                return p->getName();
-            }
-        }
-        throw std::runtime_error("Could not determine winner.");
+        return _players[first_active_from(0)]->getName();
     }
 
     /**
@@ -156,39 +545,30 @@ namespace coup
      */
     void Game::next_turn()
     {
+        COUP_TRACE_SPAN("Game::next_turn");
         if (!_game_started)
         {
-            _game_started = true;
+            mark_started();
         }
         if (active_players_count() < 2)
         {
             return; // Game is over
         }
 
-        do
-        {
-            _turn_index = (_turn_index + 1) % _players.size();
-        } while (!_players.at(_turn_index)->isActive());
+        set_turn_index(first_active_from((_turn_index + 1) % _players.size()));
 
         // Apply start-of-turn effects for the next player
         Player *nextPlayer = _players.at(_turn_index);
-        if (nextPlayer->role() == "Merchant" && nextPlayer->coins() >= MERCHANT_BONUS_THRESHOLD)
+        if (nextPlayer->roleType() == Role::Merchant && nextPlayer->coins() >= MERCHANT_BONUS_THRESHOLD)
         {
             nextPlayer->addCoins(1);
         }
     }
 
+    // Kept up to date by Player::eliminate() and Player::revive().
     size_t Game::active_players_count() const
     {
-        size_t count = 0;
-        for (const auto &p : _players)
-        {
-            if (p->isActive())
-            {
-                count++;
-            }
-        }
-        return count;
+        return _active.size();
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,335 @@
+//talgov44@gmail.com
+
+#include "GameLog.hpp"
+#include "Baron.hpp"
+#include "Game.hpp"
+#include "Player.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace coup
+{
+    static_assert(sizeof(LogRecord) == 8, "LogRecord must stay 8 bytes");
+    static_assert(sizeof(LogGameHeader) == 16, "LogGameHeader must stay 16 bytes");
+
+    namespace
+    {
+        const size_t LOG_ALIGNMENT = 8;
+        const size_t LOG_BUFFER_SIZE = 1 << 20;
+
+        size_t padded(size_t bytes)
+        {
+            return (bytes + LOG_ALIGNMENT - 1) / LOG_ALIGNMENT * LOG_ALIGNMENT;
+        }
+
+        Player &seat(const std::vector<Player *> &players, std::uint16_t index)
+        {
+            if (index >= players.size())
+            {
+                throw std::runtime_error("Log record refers to a seat that does not exist.");
+            }
+            return *players[index];
+        }
+    }
+
+    /**
+     * @brief Opens (and truncates) a log file for writing.
+     *
+     * @throws std::runtime_error If the file cannot be opened.
+     */
+    GameLogWriter::GameLogWriter(const std::string &path)
+        : _header_offset(-1), _records(0), _game(nullptr), _next(nullptr), _failed(false)
+    {
+        _file = std::fopen(path.c_str(), "wb");
+        if (_file == nullptr)
+        {
+            throw std::runtime_error("Cannot open game log for writing: " + path);
+        }
+        std::setvbuf(_file, nullptr, _IOFBF, LOG_BUFFER_SIZE);
+    }
+
+    GameLogWriter::~GameLogWriter()
+    {
+        finish();
+        std::fclose(_file);
+    }
+
+    /**
+     * @brief Starts a new game in the log and attaches the writer to it.
+     *
+     * The game's seats and roles are written to the game header, so call this
+     * after all players have been added. The game's current sink, if any, is
+     * chained behind the writer.
+     *
+     * @throws std::runtime_error If the previous game or the new header cannot
+     *                            be written.
+     */
+    void GameLogWriter::begin(Game &game)
+    {
+        end();
+        const std::vector<Player *> &players = game.get_players();
+
+        LogGameHeader header{};
+        header.magic = LOG_MAGIC;
+        header.version = LOG_VERSION;
+        header.player_count = static_cast<std::uint16_t>(players.size());
+        header.record_count = 0;
+
+        std::vector<unsigned char> roles(padded(players.size()), 0);
+        for (size_t i = 0; i < players.size(); ++i)
+        {
+            roles[i] = static_cast<unsigned char>(players[i]->roleType());
+        }
+
+        _header_offset = std::ftell(_file);
+        if (_header_offset < 0 || std::fwrite(&header, sizeof(header), 1, _file) != 1 ||
+            std::fwrite(roles.data(), 1, roles.size(), _file) != roles.size())
+        {
+            throw std::runtime_error("Cannot write game log header.");
+        }
+        _records = 0;
+        _failed = false;
+        _game = &game;
+        _next = game.event_sink();
+        game.set_event_sink(this);
+    }
+
+    // Detaches from the open game and patches its record count into the
+    // header. Returns false if any write of the game failed.
+    bool GameLogWriter::finish()
+    {
+        if (_game == nullptr)
+        {
+            return true;
+        }
+        if (_game->event_sink() == this)
+        {
+            _game->set_event_sink(_next);
+        }
+        _game = nullptr;
+        _next = nullptr;
+
+        const long end_offset = std::ftell(_file);
+        bool ok = !_failed && end_offset >= 0 &&
+                  std::fseek(_file, _header_offset + static_cast<long>(offsetof(LogGameHeader, record_count)), SEEK_SET) == 0 &&
+                  std::fwrite(&_records, sizeof(_records), 1, _file) == 1 &&
+                  std::fseek(_file, end_offset, SEEK_SET) == 0;
+        ok = std::fflush(_file) == 0 && ok;
+        return ok;
+    }
+
+    /**
+     * @brief Finishes the current game: fills in its record count and detaches
+     *        the writer from the game, putting back the game's previous sink.
+     *        Does nothing if no game is open.
+     *
+     * @throws std::runtime_error If any part of the game could not be written.
+     */
+    void GameLogWriter::end()
+    {
+        if (!finish())
+        {
+            throw std::runtime_error("Cannot write game log.");
+        }
+    }
+
+    void GameLogWriter::record(const Game &game, const GameEvent &event)
+    {
+        if (_next != nullptr)
+        {
+            _next->record(game, event);
+        }
+        if (_failed || (event.kind != EventKind::Action && event.kind != EventKind::Undo))
+        {
+            return;
+        }
+        LogRecord record;
+        record.action = event.action;
+        record.result = event.result;
+        record.actor = event.actor;
+        record.target = event.target;
+        record.actor_delta = static_cast<std::int8_t>(event.actor_delta);
+        record.target_delta = static_cast<std::int8_t>(event.target_delta);
+        if (std::fwrite(&record, sizeof(record), 1, _file) != 1)
+        {
+            _failed = true;
+            return;
+        }
+        _records++;
+    }
+
+    /**
+     * @brief Maps a log file read-only and indexes its games.
+     *
+     * @throws std::runtime_error If the file cannot be mapped or is not a valid log.
+     */
+    GameLogReader::GameLogReader(const std::string &path) : _data(nullptr), _size(0)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open game log: " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Cannot read game log size: " + path);
+        }
+        _size = static_cast<size_t>(info.st_size);
+        if (_size > 0)
+        {
+            void *mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("Cannot map game log: " + path);
+            }
+            ::madvise(mapping, _size, MADV_SEQUENTIAL);
+            _data = static_cast<const unsigned char *>(mapping);
+        }
+        ::close(fd);
+
+        auto fail = [this](const char *message)
+        {
+            ::munmap(const_cast<unsigned char *>(_data), _size);
+            throw std::runtime_error(message);
+        };
+
+        size_t offset = 0;
+        while (offset < _size)
+        {
+            LogGameHeader header;
+            if (_size - offset < sizeof(header))
+            {
+                fail("Game log is truncated.");
+            }
+            std::memcpy(&header, _data + offset, sizeof(header));
+            if (header.magic != LOG_MAGIC || header.version != LOG_VERSION)
+            {
+                fail("Not a game log, or an unsupported version.");
+            }
+            offset += sizeof(header);
+            const size_t roles_size = padded(header.player_count);
+            const size_t records_size = header.record_count * sizeof(LogRecord);
+            if (_size - offset < roles_size + records_size)
+            {
+                fail("Game log is truncated.");
+            }
+
+            LoggedGame game;
+            game.roles = reinterpret_cast<const Role *>(_data + offset);
+            game.player_count = header.player_count;
+            game.records = reinterpret_cast<const LogRecord *>(_data + offset + roles_size);
+            game.record_count = header.record_count;
+            _games.push_back(game);
+            offset += roles_size + records_size;
+        }
+    }
+
+    GameLogReader::~GameLogReader()
+    {
+        if (_data != nullptr)
+        {
+            ::munmap(const_cast<unsigned char *>(_data), _size);
+            _data = nullptr;
+        }
+    }
+
+    const std::vector<LoggedGame> &GameLogReader::games() const
+    {
+        return _games;
+    }
+
+    /**
+     * @brief Replays a logged game into a live Game through the try_* actions.
+     *
+     * Every record is re-executed and its result and coin deltas are checked
+     * against the log.
+     *
+     * @throws std::runtime_error If the game's seats or roles do not match the
+     *                            log, or if the replay diverges from it.
+     */
+    size_t GameLogReader::replay(const LoggedGame &logged, Game &game) const
+    {
+        const std::vector<Player *> &players = game.get_players();
+        if (players.size() != logged.player_count)
+        {
+            throw std::runtime_error("Game does not match the number of players in the log.");
+        }
+        for (size_t i = 0; i < players.size(); ++i)
+        {
+            if (players[i]->roleType() != logged.roles[i])
+            {
+                throw std::runtime_error("Game does not match the roles in the log.");
+            }
+        }
+
+        for (size_t r = 0; r < logged.record_count; ++r)
+        {
+            const LogRecord &record = logged.records[r];
+            Player &actor = seat(players, record.actor);
+            Player *target = record.target == NO_SEAT ? nullptr : &seat(players, record.target);
+            const int actor_before = actor.coins();
+            const int target_before = target == nullptr ? 0 : target->coins();
+
+            ActionResult result = ActionResult::InvalidTarget;
+            switch (record.action)
+            {
+            case ActionType::Gather:
+                result = actor.try_gather();
+                break;
+            case ActionType::Tax:
+                result = actor.try_tax();
+                break;
+            case ActionType::Bribe:
+                result = actor.try_bribe();
+                break;
+            case ActionType::Invest:
+                if (actor.roleType() == Role::Baron)
+                {
+                    result = static_cast<Baron &>(actor).try_invest();
+                }
+                break;
+            case ActionType::Arrest:
+                if (target != nullptr)
+                {
+                    result = actor.try_arrest(*target);
+                }
+                break;
+            case ActionType::Sanction:
+                if (target != nullptr)
+                {
+                    result = actor.try_sanction(*target);
+                }
+                break;
+            case ActionType::Coup:
+                if (target != nullptr)
+                {
+                    result = actor.try_coup(*target);
+                }
+                break;
+            case ActionType::Undo:
+                if (target != nullptr)
+                {
+                    result = actor.try_undo(*target);
+                }
+                break;
+            case ActionType::None:
+                break;
+            }
+
+            const bool deltas_match = actor.coins() - actor_before == record.actor_delta &&
+                                      (target == nullptr || target->coins() - target_before == record.target_delta);
+            if (result != record.result || !deltas_match)
+            {
+                throw std::runtime_error("Replay diverged from the log at record " + std::to_string(r) + ".");
+            }
+        }
+        return logged.record_count;
+    }
+}
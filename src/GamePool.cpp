@@ -0,0 +1,60 @@
+//talgov44@gmail.com
+
+#include "GamePool.hpp"
+#include <algorithm>
+#include <string>
+
+namespace coup
+{
+    GamePool::GamePool() : _created(0) {}
+
+    /**
+     * @brief A game with one player per role in `lineup`, not yet started.
+     *
+     * Reuses the most recently released game with the same lineup, and only
+     * builds a new one if there is none.
+     */
+    std::unique_ptr<PooledGame> GamePool::acquire(const std::vector<Role> &lineup)
+    {
+        for (size_t i = _free.size(); i-- > 0;)
+        {
+            if (_free[i]->lineup == lineup)
+            {
+                std::unique_ptr<PooledGame> game = std::move(_free[i]);
+                _free[i] = std::move(_free.back());
+                _free.pop_back();
+                return game;
+            }
+        }
+
+        std::unique_ptr<PooledGame> game(new PooledGame(std::max(lineup.size(), DEFAULT_MAX_PLAYERS)));
+        game->lineup = lineup;
+        for (size_t i = 0; i < lineup.size(); ++i)
+        {
+            game->players.create(game->game, lineup[i], "P" + std::to_string(i));
+        }
+        ++_created;
+        return game;
+    }
+
+    // Resets the game and keeps it for a later acquire(). Null is ignored.
+    void GamePool::release(std::unique_ptr<PooledGame> game)
+    {
+        if (!game)
+        {
+            return;
+        }
+        game->game.reset();
+        _free.push_back(std::move(game));
+    }
+
+    size_t GamePool::created() const
+    {
+        return _created;
+    }
+
+    size_t GamePool::available() const
+    {
+        return _free.size();
+    }
+}
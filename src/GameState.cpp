@@ -0,0 +1,150 @@
+//talgov44@gmail.com
+
+#include "GameState.hpp"
+#include "Game.hpp"
+#include "Player.hpp"
+#include "Zobrist.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace coup
+{
+    static_assert(std::is_trivially_copyable<GameState>::value, "GameState must be trivially copyable");
+    static_assert(std::has_unique_object_representations<GameState>::value, "GameState must not contain padding");
+    static_assert(sizeof(GameState) <= 64, "GameState should fit in a cache line");
+
+    namespace
+    {
+        const int MAX_STATE_COINS = 255;
+    }
+
+    /**
+     * @brief Takes a snapshot of the game and all of its players.
+     *
+     * @throws std::runtime_error If the game has more than 6 players or a player
+     *                            holds more coins than a GameState can store.
+     */
+    GameState GameState::capture(const Game &game)
+    {
+        const std::vector<Player *> &players = game._players;
+        if (players.size() > MAX_PLAYERS)
+        {
+            throw std::runtime_error("GameState holds at most 6 players.");
+        }
+
+        GameState state;
+        std::memset(&state, 0, sizeof(state));
+        for (size_t i = 0; i < players.size(); ++i)
+        {
+            const Player &p = *players[i];
+            if (p._coins > MAX_STATE_COINS)
+            {
+                throw std::runtime_error("Coin count too large for GameState.");
+            }
+            PlayerState &ps = state.players[i];
+            ps.coins = static_cast<std::uint8_t>(p._coins);
+            ps.set(PlayerState::ACTIVE, p.is_active);
+            ps.set(PlayerState::SANCTIONED, p._is_sanctioned);
+            ps.set(PlayerState::EXTRA_ACTION, p._has_extra_action);
+            ps.role = p._role;
+            ps.last_action = p.last_action;
+            ps.last_arrested = static_cast<std::int8_t>(p._last_arrested_seat);
+        }
+        state.player_count = static_cast<std::uint8_t>(players.size());
+        state.turn = static_cast<std::uint8_t>(game._turn_index);
+        state.save_target = static_cast<std::int8_t>(game._save_seat);
+        state.flags = game._game_started ? STARTED : 0;
+        return state;
+    }
+
+    /**
+     * @brief Writes the snapshot back into a game.
+     *
+     * The game must have the same number of players, in the same seats and with
+     * the same roles, as the game the snapshot was captured from. Every coin
+     * count a Spy revealed before is concealed again, as the restored coins
+     * may differ.
+     *
+     * @throws std::runtime_error If the game's seats do not match the snapshot.
+     */
+    void GameState::restore(Game &game) const
+    {
+        const std::vector<Player *> &players = game._players;
+        if (players.size() != this->player_count)
+        {
+            throw std::runtime_error("GameState does not match the number of players in the game.");
+        }
+        for (size_t i = 0; i < players.size(); ++i)
+        {
+            if (players[i]->_role != this->players[i].role)
+            {
+                throw std::runtime_error("GameState does not match the roles in the game.");
+            }
+        }
+
+        game._active.clear();
+        for (size_t i = 0; i < players.size(); ++i)
+        {
+            Player &p = *players[i];
+            const PlayerState &ps = this->players[i];
+            p._coins = ps.coins;
+            game.conceal_coins(i);
+            p.is_active = ps.has(PlayerState::ACTIVE);
+            p._is_sanctioned = ps.has(PlayerState::SANCTIONED);
+            p._has_extra_action = ps.has(PlayerState::EXTRA_ACTION);
+            p.last_action = ps.last_action;
+            p._last_arrested_seat = ps.last_arrested;
+            if (p.is_active)
+            {
+                game._active.insert(i);
+            }
+        }
+        game._turn_index = this->turn;
+        game._game_started = (this->flags & STARTED) != 0;
+        game._save_seat = this->save_target;
+        game._hash = hash();
+    }
+
+    /**
+     * @brief Recomputes the Zobrist hash of the snapshot from scratch.
+     *
+     * Game maintains the same hash incrementally, so this is mainly useful for
+     * states that never lived in a Game and for checking the incremental one.
+     */
+    std::uint64_t GameState::hash() const
+    {
+        std::uint64_t h = zobrist_key(ZobristFeature::Turn, 0, this->turn) ^
+                          zobrist_key(ZobristFeature::SaveTarget, 0, this->save_target + 1) ^
+                          zobrist_key(ZobristFeature::Started, 0, (this->flags & STARTED) != 0);
+        for (size_t i = 0; i < this->player_count; ++i)
+        {
+            const PlayerState &ps = this->players[i];
+            h ^= zobrist_key(ZobristFeature::Coins, i, ps.coins) ^
+                 zobrist_key(ZobristFeature::Active, i, ps.has(PlayerState::ACTIVE)) ^
+                 zobrist_key(ZobristFeature::Sanctioned, i, ps.has(PlayerState::SANCTIONED)) ^
+                 zobrist_key(ZobristFeature::ExtraAction, i, ps.has(PlayerState::EXTRA_ACTION)) ^
+                 zobrist_key(ZobristFeature::LastAction, i, static_cast<int>(ps.last_action)) ^
+                 zobrist_key(ZobristFeature::LastArrested, i, ps.last_arrested + 1);
+        }
+        return h;
+    }
+
+    size_t GameState::active_count() const
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < this->player_count; ++i)
+        {
+            if (this->players[i].has(PlayerState::ACTIVE))
+            {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    bool GameState::operator==(const GameState &other) const
+    {
+        return std::memcmp(this, &other, sizeof(GameState)) == 0;
+    }
+}
@@ -1,15 +1,16 @@
 //talgov44@gmail.com
 
 #include "General.hpp"
+#include "Constants.hpp"
+#include "Instrument.hpp"
+#include "Trace.hpp"
 #include <iostream>
 
 namespace coup
 {
-    const int GENERAL_UNDO_COST = 5;
-
     General::General(Game &game, const std::string &name) : Player(game, name)
     {
-        this->_role = "General";
+        this->_role = Role::General;
     }
 
     /**
@@ -21,32 +22,38 @@ namespace coup
      *
      * @param target_of_coup The player who was just eliminated by a coup and is
      *                       to be revived.
-     * @throws std::runtime_error If the General has fewer than 5 coins.
-     * @throws std::runtime_error If the target player is already active (i.e., was not eliminated).
-     * @throws std::runtime_error If the target player was not the most recent victim of a coup,
-     *                            or if the opportunity to undo has passed.
+     * @return ActionResult NotEnoughCoins if the General has fewer than 5 coins,
+     *                      NothingToUndo if the target player is still active (i.e., was not eliminated),
+     *                      UndoWindowClosed if the target player was not the most recent victim of a coup,
+     *                      or if the opportunity to undo has passed.
      */
-    void General::undo(Player &target_of_coup)
+    ActionResult General::try_undo(Player &target_of_coup)
     {
+        COUP_RECORD_LATENCY(UndoGeneral);
+        COUP_TRACK_ALLOCATIONS(Undo);
+        COUP_TRACE_SPAN("General::try_undo");
         if (this->coins() < GENERAL_UNDO_COST)
         {
-            throw std::runtime_error("General needs 5 coins to undo a coup.");
+            return ActionResult::NotEnoughCoins;
         }
         // Can only undo a coup on a player who was actually eliminated.
         if (target_of_coup.isActive())
         {
-            throw std::runtime_error("Cannot undo a coup on an active player.");
+            return ActionResult::NothingToUndo;
         }
 
         // Check if this player was the target of the most recent coup.
         // This opportunity is cleared once the next player takes an action.
         if (&target_of_coup != this->game.getPlayerToSave())
         {
-            throw std::runtime_error("This player was not eliminated in the previous turn or the window to undo has closed.");
+            return ActionResult::UndoWindowClosed;
         }
 
+        const int coins_before = this->_coins;
         this->removeCoins(GENERAL_UNDO_COST);
         target_of_coup.revive();
         this->game.clearSaveWindow();
+        report(EventKind::Undo, ActionType::Undo, ActionResult::Ok, &target_of_coup, coins_before, target_of_coup.coins());
+        return ActionResult::Ok;
     }
 }
\ No newline at end of file
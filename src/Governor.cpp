@@ -1,6 +1,9 @@
 //talgov44@gmail.com
 
 #include "Governor.hpp"
+#include "Constants.hpp"
+#include "Instrument.hpp"
+#include "Trace.hpp"
 #include <iostream>
 
 namespace coup
@@ -8,38 +11,58 @@ namespace coup
     Governor::Governor(Game &game, const std::string &name) : Player(game, name)
     {
 
-        this->_role = "Governor";
+        this->_role = Role::Governor;
     }
 
     // A Governor takes 3 coins when using tax.
-    void Governor::tax()
+    ActionResult Governor::try_tax()
     {
-        check_turn();
-        must_coup();
+        COUP_RECORD_LATENCY(Tax);
+        COUP_TRACK_ALLOCATIONS(Tax);
+        COUP_TRACE_SPAN("Governor::try_tax");
+        ActionResult result = check_turn();
+        if (result == ActionResult::Ok)
+        {
+            result = must_coup();
+        }
+        if (result != ActionResult::Ok)
+        {
+            return result;
+        }
+        const int coins_before = this->_coins;
         if (this->_is_sanctioned)
         {
-            this->_is_sanctioned = false;
+            setSanctioned(false);
             end_turn_or_continue();
-            throw std::runtime_error("Cannot use tax, you are sanctioned for this turn.");
+            report(EventKind::Action, ActionType::Tax, ActionResult::Sanctioned, nullptr, coins_before, 0);
+            return ActionResult::Sanctioned;
         }
-        this->addCoins(3);
-        this->last_action = "tax";
+        this->addCoins(GOVERNOR_TAX_AMOUNT);
+        setLastAction(ActionType::Tax);
         end_turn_or_continue();
+        report(EventKind::Action, ActionType::Tax, ActionResult::Ok, nullptr, coins_before, 0);
+        return ActionResult::Ok;
     }
 
     // A Governor can undo another player's tax action.
     // This action does not cost a turn.
-    void Governor::undo(Player &target)
+    ActionResult Governor::try_undo(Player &target)
     {
+        COUP_RECORD_LATENCY(UndoGovernor);
+        COUP_TRACK_ALLOCATIONS(Undo);
+        COUP_TRACE_SPAN("Governor::try_undo");
         if (!target.isActive() || this == &target)
         {
-            throw std::runtime_error("Invalid undo target.");
+            return ActionResult::InvalidTarget;
         }
-        if (target.getLastAction() != "tax")
+        if (target.lastActionType() != ActionType::Tax)
         {
-            throw std::runtime_error("Governor can only undo a 'tax' action.");
+            return ActionResult::NothingToUndo;
         }
         // A normal tax gives 2 coins.
-        target.removeCoins(2);
+        const int target_before = target.coins();
+        target.removeCoins(TAX_AMOUNT);
+        report(EventKind::Undo, ActionType::Undo, ActionResult::Ok, &target, this->_coins, target_before);
+        return ActionResult::Ok;
     }
 }
\ No newline at end of file
@@ -0,0 +1,59 @@
+//talgov44@gmail.com
+
+#include "InformationSet.hpp"
+#include "Constants.hpp"
+#include "Game.hpp"
+#include "Player.hpp"
+
+namespace coup
+{
+    namespace
+    {
+        // A player starts its turn with at most MUST_COUP_COINS - 1 coins (or
+        // must coup) and gains at most 3 on it, from a Governor's tax or a
+        // Baron's investment. The only net gain between its turns is a Baron's
+        // sanction compensation, once per sanction: at most two per opponent
+        // turn, with a bribe.
+        int max_hidden_coins(const GameState &state, size_t seat)
+        {
+            const int turn_end = MUST_COUP_COINS - 1 + GOVERNOR_TAX_AMOUNT;
+            if (state.players[seat].role != Role::Baron)
+            {
+                return turn_end;
+            }
+            const int opponents = static_cast<int>(state.active_count()) - 1;
+            return turn_end + 2 * opponents * BARON_SANCTION_COMPENSATION;
+        }
+    }
+
+    InformationSet InformationSet::observe(const Game &game, const Player &observer, bool spy_rights)
+    {
+        const bool spy = spy_rights && observer.roleType() == Role::Spy && observer.isActive();
+        InformationSet info;
+        info.state = GameState::capture(game);
+        info.observer = static_cast<std::uint8_t>(game.seat_of(observer));
+        info.hidden = 0;
+        const std::vector<Player *> &players = game.get_players();
+        for (size_t i = 0; i < players.size(); ++i)
+        {
+            if (!(spy && players[i]->isActive()) && !game.can_see_coins(observer, *players[i]))
+            {
+                info.hidden |= static_cast<std::uint8_t>(1u << i);
+                info.state.players[i].coins = 0;
+            }
+        }
+        return info;
+    }
+
+    void InformationSet::determinize(GameState &state, CounterRng &rng) const
+    {
+        for (size_t i = 0; i < state.player_count; ++i)
+        {
+            if (is_hidden(i))
+            {
+                const int most = max_hidden_coins(state, i);
+                state.players[i].coins = static_cast<std::uint8_t>(rng.uniform(static_cast<std::uint32_t>(most + 1)));
+            }
+        }
+    }
+}
@@ -0,0 +1,278 @@
+//talgov44@gmail.com
+
+#include "Instrument.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+namespace coup
+{
+    namespace
+    {
+        struct AtomicStats
+        {
+            std::atomic<std::uint64_t> calls;
+            std::atomic<std::uint64_t> allocations;
+            std::atomic<std::uint64_t> bytes;
+        };
+
+        // Zero-initialised before any dynamic initialiser runs, so operator new
+        // may use them from the very first allocation.
+        AtomicStats stats[ENTRY_POINT_COUNT];
+        std::atomic<std::uint64_t> total;
+        thread_local std::uint32_t open_points = 0; // Bit per EntryPoint with a live scope.
+
+        const char *const NAMES[ENTRY_POINT_COUNT] = {
+            "gather", "tax", "bribe", "arrest", "sanction", "coup", "invest", "undo",
+            "Game::turn", "Game::players", "getName", "role", "getLastAction"};
+    }
+
+    const char *to_string(EntryPoint point)
+    {
+        return NAMES[static_cast<size_t>(point)];
+    }
+
+    bool allocation_tracking_enabled()
+    {
+#ifdef COUP_INSTRUMENT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    AllocationStats allocation_stats(EntryPoint point)
+    {
+        const AtomicStats &s = stats[static_cast<size_t>(point)];
+        AllocationStats result;
+        result.calls = s.calls.load(std::memory_order_relaxed);
+        result.allocations = s.allocations.load(std::memory_order_relaxed);
+        result.bytes = s.bytes.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    std::uint64_t total_allocations()
+    {
+        return total.load(std::memory_order_relaxed);
+    }
+
+    void reset_allocation_stats()
+    {
+        for (AtomicStats &s : stats)
+        {
+            s.calls.store(0, std::memory_order_relaxed);
+            s.allocations.store(0, std::memory_order_relaxed);
+            s.bytes.store(0, std::memory_order_relaxed);
+        }
+        total.store(0, std::memory_order_relaxed);
+    }
+
+    AllocationScope::AllocationScope(EntryPoint point) : _bit(std::uint32_t(1) << static_cast<unsigned>(point))
+    {
+        if ((open_points & _bit) != 0)
+        {
+            this->_bit = 0;
+            return;
+        }
+        open_points |= _bit;
+        stats[static_cast<size_t>(point)].calls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    AllocationScope::~AllocationScope()
+    {
+        open_points &= ~_bit;
+    }
+
+    namespace
+    {
+        LatencyHistogram latencies[LATENCY_KEY_COUNT];
+        thread_local std::uint32_t open_latency_keys = 0; // Bit per LatencyKey with a live scope.
+
+        const char *const LATENCY_NAMES[LATENCY_KEY_COUNT] = {
+            "gather", "tax", "bribe", "arrest", "sanction", "coup", "invest",
+            "undo[Governor]", "undo[Spy]", "undo[General]", "undo[Judge]", "undo[other]"};
+    }
+
+    const char *to_string(LatencyKey key)
+    {
+        return LATENCY_NAMES[static_cast<size_t>(key)];
+    }
+
+    LatencyKey undo_latency_key(Role role)
+    {
+        switch (role)
+        {
+        case Role::Governor:
+            return LatencyKey::UndoGovernor;
+        case Role::Spy:
+            return LatencyKey::UndoSpy;
+        case Role::General:
+            return LatencyKey::UndoGeneral;
+        case Role::Judge:
+            return LatencyKey::UndoJudge;
+        default:
+            return LatencyKey::UndoOther;
+        }
+    }
+
+    bool latency_recording_enabled()
+    {
+        return allocation_tracking_enabled();
+    }
+
+    const LatencyHistogram &latency_histogram(LatencyKey key)
+    {
+        return latencies[static_cast<size_t>(key)];
+    }
+
+    void reset_latency_histograms()
+    {
+        for (LatencyHistogram &histogram : latencies)
+        {
+            histogram.reset();
+        }
+    }
+
+    void write_latency_snapshot(std::ostream &out)
+    {
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        out << std::left << std::setw(16) << "action" << std::right << std::setw(12) << "count"
+            << std::setw(10) << "mean ns" << std::setw(10) << "min" << std::setw(10) << "p50"
+            << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+            << std::setw(10) << "p99.99" << std::setw(10) << "max" << "\n";
+        for (size_t i = 0; i < LATENCY_KEY_COUNT; ++i)
+        {
+            const LatencyHistogram &histogram = latencies[i];
+            if (histogram.count() == 0)
+            {
+                continue;
+            }
+            out << std::left << std::setw(16) << LATENCY_NAMES[i] << std::right << std::setw(12) << histogram.count()
+                << std::setw(10) << std::fixed << std::setprecision(1) << histogram.mean()
+                << std::setw(10) << histogram.min();
+            const double percents[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+            for (double percent : percents)
+            {
+                out << std::setw(10) << histogram.percentile(percent);
+            }
+            out << std::setw(10) << histogram.max() << "\n";
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    LatencyScope::LatencyScope(LatencyKey key)
+        : _bit(std::uint32_t(1) << static_cast<unsigned>(key)), _key(key)
+    {
+        if ((open_latency_keys & _bit) != 0)
+        {
+            this->_bit = 0;
+            return;
+        }
+        open_latency_keys |= _bit;
+        this->_begin = std::chrono::steady_clock::now();
+    }
+
+    LatencyScope::~LatencyScope()
+    {
+        if (this->_bit == 0)
+        {
+            return;
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - this->_begin;
+        open_latency_keys &= ~_bit;
+        latencies[static_cast<size_t>(this->_key)].record(
+            static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+#if defined(COUP_INSTRUMENT) || defined(COUP_COUNT_ALLOCATIONS)
+    namespace
+    {
+        void record_allocation(std::size_t size)
+        {
+            total.fetch_add(1, std::memory_order_relaxed);
+#ifdef COUP_INSTRUMENT
+            for (std::uint32_t open = open_points; open != 0; open &= open - 1)
+            {
+                AtomicStats &s = stats[__builtin_ctz(open)];
+                s.allocations.fetch_add(1, std::memory_order_relaxed);
+                s.bytes.fetch_add(size, std::memory_order_relaxed);
+            }
+#else
+            (void)size;
+#endif
+        }
+    }
+#endif
+}
+
+#if defined(COUP_INSTRUMENT) || defined(COUP_COUNT_ALLOCATIONS)
+namespace
+{
+    // What the standard allocation functions do when memory runs out: call
+    // the installed new-handler and retry, or throw if there is none.
+    void out_of_memory()
+    {
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+// Replacements for the global allocation functions, and the only ones in
+// the tree. The array and nothrow forms of the standard library forward to
+// these, so over-aligned objects such as the WorkStealingDeque are counted too.
+void *operator new(std::size_t size)
+{
+    coup::record_allocation(size);
+    while (true)
+    {
+        if (void *p = std::malloc(size == 0 ? 1 : size))
+        {
+            return p;
+        }
+        out_of_memory();
+    }
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    coup::record_allocation(size);
+    const std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void *));
+    while (true)
+    {
+        void *p = nullptr;
+        if (posix_memalign(&p, align, size == 0 ? 1 : size) == 0)
+        {
+            return p;
+        }
+        out_of_memory();
+    }
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+#endif
@@ -0,0 +1,270 @@
+//talgov44@gmail.com
+
+#include "Ismcts.hpp"
+#include "Game.hpp"
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace coup
+{
+    namespace
+    {
+        const size_t CLOCK_INTERVAL = 64;
+        const std::uint32_t NO_NODE = 0;                          // Node 0 is the root, never a child.
+        const std::uint64_t DETERMINIZATION_SALT = 0x5DEECE66Dull; // Separates guess streams from playout streams.
+
+        std::uint64_t draw_stream(CounterRng &rng)
+        {
+            const std::uint64_t high = rng();
+            return (high << 32) | rng();
+        }
+
+        bool same(const Action &a, const Action &b)
+        {
+            return a.type == b.type && a.target == b.target;
+        }
+    }
+
+    /**
+     * @throws std::runtime_error If the node pool cannot hold the root and its
+     *                            children, or there is no search budget.
+     */
+    Ismcts::Ismcts(const MctsConfig &config) : _config(config), _used(0)
+    {
+        if (_config.max_nodes < MAX_ACTIONS + 1)
+        {
+            throw std::runtime_error("MCTS node pool is too small.");
+        }
+        if (_config.iterations == 0 && _config.seconds <= 0.0)
+        {
+            throw std::runtime_error("MCTS needs an iteration or time budget.");
+        }
+        if (_config.determinizations == 0)
+        {
+            _config.determinizations = 1;
+        }
+        _nodes.resize(_config.max_nodes);
+        _path.reserve(256);
+    }
+
+    const MctsStats &Ismcts::stats() const
+    {
+        return _stats;
+    }
+
+    const IsmctsNode &Ismcts::node(std::uint32_t index) const
+    {
+        return _nodes.at(index);
+    }
+
+    // Prepends a child to the parent's list. Returns NO_NODE if the pool is full.
+    std::uint32_t Ismcts::add_child(std::uint32_t parent, const Action &action, std::uint8_t mover)
+    {
+        if (_used >= _nodes.size())
+        {
+            return NO_NODE;
+        }
+        const std::uint32_t index = static_cast<std::uint32_t>(_used++);
+        IsmctsNode &child = _nodes[index];
+        child.action = action;
+        child.first_child = NO_NODE;
+        child.next_sibling = _nodes[parent].first_child;
+        child.mover = mover;
+        child.visits = 0;
+        child.available = 0;
+        child.value = 0.0;
+        _nodes[parent].first_child = index;
+        return index;
+    }
+
+    // One iteration on a determinized position: select among the children whose
+    // actions are available, expand the first untried action, play out, back up.
+    void Ismcts::iterate(const Position &start, CounterRng &rng, double *rewards)
+    {
+        Position position = start;
+        std::uint32_t node = 0;
+        _path.clear();
+        _path.push_back(node);
+
+        Action actions[MAX_ACTIONS];
+        while (!position.terminal())
+        {
+            const size_t count = position.actions(actions, MAX_ACTIONS);
+            std::uint32_t tried = 0; // Bit i: actions[i] already has a child.
+            std::uint32_t best = NO_NODE;
+            double best_score = -1.0;
+            for (std::uint32_t c = _nodes[node].first_child; c != NO_NODE; c = _nodes[c].next_sibling)
+            {
+                IsmctsNode &child = _nodes[c];
+                for (size_t i = 0; i < count; ++i)
+                {
+                    if (same(child.action, actions[i]))
+                    {
+                        tried |= 1u << i;
+                        child.available++;
+                        const double visits = std::max<std::uint32_t>(child.visits, 1);
+                        const double score = child.value / visits +
+                                             _config.exploration * std::sqrt(std::log(static_cast<double>(child.available)) / visits);
+                        if (score > best_score)
+                        {
+                            best_score = score;
+                            best = c;
+                        }
+                        break;
+                    }
+                }
+            }
+
+            if (tried != (count >= 32 ? ~0u : (1u << count) - 1))
+            {
+                // Expand the first untried action and leave the tree.
+                size_t i = 0;
+                while (tried >> i & 1)
+                {
+                    ++i;
+                }
+                const std::uint32_t child = add_child(node, actions[i], position.seat);
+                if (child != NO_NODE)
+                {
+                    _nodes[child].available = 1;
+                    position.play(actions[i]);
+                    _path.push_back(child);
+                }
+                break;
+            }
+            node = best;
+            position.play(_nodes[node].action);
+            _path.push_back(node);
+        }
+
+        mcts_playout(position, _config.playout_depth, rng, rewards);
+        for (std::uint32_t index : _path)
+        {
+            IsmctsNode &n = _nodes[index];
+            n.visits++;
+            n.value += rewards[n.mover];
+        }
+    }
+
+    /**
+     * @brief Searches one decision of an imperfect-information game.
+     *
+     * @param root The decision to search. Its hidden coin counts are ignored:
+     *             every batch replaces them with a fresh guess.
+     * @param info What the deciding player knows; only `hidden` is used.
+     * @param stream Selects the random streams of this search together with the seed.
+     * @throws std::runtime_error If the root position is terminal.
+     */
+    Action Ismcts::search(const Position &root, const InformationSet &info, std::uint64_t stream)
+    {
+        if (root.terminal())
+        {
+            throw std::runtime_error("Cannot search a finished game.");
+        }
+        const auto start = std::chrono::steady_clock::now();
+        const bool timed = _config.seconds > 0.0;
+        const size_t batches = _config.determinizations;
+        const size_t per_batch = _config.iterations == 0 ? 0 : std::max<size_t>(1, _config.iterations / batches);
+
+        IsmctsNode &top = _nodes[0];
+        top.action = {ActionType::None, NO_TARGET};
+        top.first_child = NO_NODE;
+        top.next_sibling = NO_NODE;
+        top.mover = root.seat;
+        top.visits = 0;
+        top.available = 0;
+        top.value = 0.0;
+        _used = 1;
+
+        double rewards[GameState::MAX_PLAYERS];
+        size_t iteration = 0;
+        bool out_of_time = false;
+        for (size_t batch = 0; !out_of_time && (timed || batch < batches); ++batch)
+        {
+            CounterRng guess(_config.seed ^ DETERMINIZATION_SALT, stream, static_cast<std::uint32_t>(batch));
+            Position determinized = root;
+            info.determinize(determinized.state, guess);
+
+            // A timed search keeps cycling through fresh guesses until time runs out.
+            const size_t limit = per_batch == 0 ? CLOCK_INTERVAL : per_batch;
+            for (size_t i = 0; i < limit; ++i, ++iteration)
+            {
+                if (timed && iteration % CLOCK_INTERVAL == 0 &&
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= _config.seconds)
+                {
+                    out_of_time = true;
+                    break;
+                }
+                CounterRng rng(_config.seed, stream, static_cast<std::uint32_t>(iteration));
+                iterate(determinized, rng, rewards);
+            }
+        }
+
+        std::uint32_t best = _nodes[0].first_child;
+        for (std::uint32_t c = best; c != NO_NODE; c = _nodes[c].next_sibling)
+        {
+            if (_nodes[c].visits > _nodes[best].visits)
+            {
+                best = c;
+            }
+        }
+
+        _stats.iterations = iteration;
+        _stats.nodes = _used;
+        _stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return best == NO_NODE ? Action{ActionType::None, NO_TARGET} : _nodes[best].action;
+    }
+
+    Action Ismcts::best_of(const Action *legal, size_t count) const
+    {
+        Action best = legal[0];
+        std::uint32_t best_visits = 0;
+        for (std::uint32_t c = _nodes[0].first_child; c != NO_NODE; c = _nodes[c].next_sibling)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (same(_nodes[c].action, legal[i]) && _nodes[c].visits > best_visits)
+                {
+                    best_visits = _nodes[c].visits;
+                    best = legal[i];
+                }
+            }
+        }
+        return best;
+    }
+
+    IsmctsPolicy::IsmctsPolicy(const MctsConfig &config) : _search(config) {}
+
+    const MctsStats &IsmctsPolicy::last_search() const
+    {
+        return _search.stats();
+    }
+
+    Action IsmctsPolicy::choose(const Game &game, const Player &self,
+                                const Action *legal, size_t count, CounterRng &rng)
+    {
+        if (count == 1)
+        {
+            return legal[0];
+        }
+        // Spying is free, so a Spy searches with every opponent's coins, but
+        // choosing must not reveal them in the game or report a SpyReport.
+        const InformationSet info = InformationSet::observe(game, self, true);
+        _search.search(Position::turn(info.state), info, draw_stream(rng));
+        // Some searched actions depend on guessed coins; only play a real one.
+        return _search.best_of(legal, count);
+    }
+
+    bool IsmctsPolicy::react(const Game &game, const Player &self, const Player &actor, CounterRng &rng)
+    {
+        const InformationSet info = InformationSet::observe(game, self, true);
+        const size_t seat = game.seat_of(self);
+        const Position root = Position::reaction(info.state, game.seat_of(actor), actor.lastActionType(), seat);
+        if (root.phase != Position::REACTION || root.seat != seat)
+        {
+            return false;
+        }
+        return _search.search(root, info, draw_stream(rng)).type == ActionType::Undo;
+    }
+}
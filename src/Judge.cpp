@@ -4,27 +4,34 @@
 #include <iostream>
 
 #include "Game.hpp"
+#include "Instrument.hpp"
+#include "Trace.hpp"
 
 namespace coup
 {
 
     Judge::Judge(Game &game, const std::string &name) : Player(game, name)
     {
-        this->_role = "Judge";
+        this->_role = Role::Judge;
     }
 
     /**
      * @brief Cancels a 'bribe' action performed by another player.
      *
      * @param target_of_bribe The player who just performed the 'bribe' action.
-     * @throws std::runtime_error If the target player's last action was not 'bribe'.
+     * @return ActionResult NothingToUndo if the target player's last action was not 'bribe'.
      */
-    void Judge::undo(Player &target_of_bribe)
+    ActionResult Judge::try_undo(Player &target_of_bribe)
     {
-        if (target_of_bribe.getLastAction() != "bribe")
+        COUP_RECORD_LATENCY(UndoJudge);
+        COUP_TRACK_ALLOCATIONS(Undo);
+        COUP_TRACE_SPAN("Judge::try_undo");
+        if (target_of_bribe.lastActionType() != ActionType::Bribe)
         {
-            throw std::runtime_error("Judge can only undo a 'bribe' action.");
+            return ActionResult::NothingToUndo;
         }
         target_of_bribe.cancelExtraAction();
+        report(EventKind::Undo, ActionType::Undo, ActionResult::Ok, &target_of_bribe, this->_coins, target_of_bribe.coins());
+        return ActionResult::Ok;
     }
 }
\ No newline at end of file
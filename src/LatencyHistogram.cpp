@@ -0,0 +1,175 @@
+//talgov44@gmail.com
+
+#include "LatencyHistogram.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+namespace coup
+{
+    const std::uint64_t LatencyHistogram::MAX_VALUE;
+
+    LatencyHistogram::LatencyHistogram()
+    {
+        reset();
+    }
+
+    // Values below SUB_BUCKETS map to themselves. Above, a value with its top
+    // bit at position SUB_BUCKET_BITS - 1 + b keeps its top SUB_BUCKET_BITS bits.
+    size_t LatencyHistogram::index_of(std::uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+        {
+            return static_cast<size_t>(value);
+        }
+        const unsigned shift = static_cast<unsigned>(63 - __builtin_clzll(value)) - (SUB_BUCKET_BITS - 1);
+        return shift * (SUB_BUCKETS / 2) + static_cast<size_t>(value >> shift);
+    }
+
+    std::uint64_t LatencyHistogram::highest_equivalent(size_t index)
+    {
+        if (index < SUB_BUCKETS)
+        {
+            return index;
+        }
+        const size_t half = SUB_BUCKETS / 2;
+        const unsigned shift = static_cast<unsigned>(index / half - 1);
+        const std::uint64_t sub = index % half + half;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void LatencyHistogram::record(std::uint64_t nanoseconds)
+    {
+        const std::uint64_t value = std::min(nanoseconds, MAX_VALUE);
+        _counts[index_of(value)].fetch_add(1, std::memory_order_relaxed);
+        _total.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+
+        std::uint64_t low = _min.load(std::memory_order_relaxed);
+        while (value < low && !_min.compare_exchange_weak(low, value, std::memory_order_relaxed))
+        {
+        }
+        std::uint64_t high = _max.load(std::memory_order_relaxed);
+        while (value > high && !_max.compare_exchange_weak(high, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void LatencyHistogram::reset()
+    {
+        for (std::atomic<std::uint64_t> &count : _counts)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+        _total.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram &other)
+    {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            _counts[i].fetch_add(other._counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        _total.fetch_add(other._total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _sum.fetch_add(other._sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        const std::uint64_t other_min = other._min.load(std::memory_order_relaxed);
+        std::uint64_t low = _min.load(std::memory_order_relaxed);
+        while (other_min < low && !_min.compare_exchange_weak(low, other_min, std::memory_order_relaxed))
+        {
+        }
+        const std::uint64_t other_max = other._max.load(std::memory_order_relaxed);
+        std::uint64_t high = _max.load(std::memory_order_relaxed);
+        while (other_max > high && !_max.compare_exchange_weak(high, other_max, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    std::uint64_t LatencyHistogram::count() const
+    {
+        return _total.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t LatencyHistogram::min() const
+    {
+        return count() == 0 ? 0 : _min.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t LatencyHistogram::max() const
+    {
+        return _max.load(std::memory_order_relaxed);
+    }
+
+    double LatencyHistogram::mean() const
+    {
+        const std::uint64_t total = count();
+        return total == 0 ? 0.0 : static_cast<double>(_sum.load(std::memory_order_relaxed)) / total;
+    }
+
+    std::uint64_t LatencyHistogram::percentile(double percent) const
+    {
+        const std::uint64_t total = count();
+        if (total == 0)
+        {
+            return 0;
+        }
+        const double clamped = std::min(std::max(percent, 0.0), 100.0);
+        const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * total)));
+        std::uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i)
+        {
+            seen += _counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                return std::min(highest_equivalent(i), max());
+            }
+        }
+        return max();
+    }
+
+    void LatencyHistogram::write_percentiles(std::ostream &out) const
+    {
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        out << std::setw(12) << "Value" << std::setw(16) << "Percentile" << std::setw(12) << "TotalCount"
+            << std::setw(18) << "1/(1-Percentile)" << "\n\n";
+
+        // Rows step through each half of the remaining distance to 100% in
+        // TICKS_PER_HALF even steps, until every recorded value is covered.
+        const int TICKS_PER_HALF = 5;
+        const std::uint64_t total = count();
+        for (int half = 0; total > 0; ++half)
+        {
+            const double remaining = std::ldexp(100.0, -half);
+            bool covered = false;
+            for (int tick = 0; tick < TICKS_PER_HALF && !covered; ++tick)
+            {
+                const double percent = 100.0 - remaining + remaining / 2.0 * tick / TICKS_PER_HALF;
+                const std::uint64_t value = percentile(percent);
+                std::uint64_t at_or_below = 0;
+                for (size_t i = 0; i <= index_of(value); ++i)
+                {
+                    at_or_below += _counts[i].load(std::memory_order_relaxed);
+                }
+                covered = at_or_below >= total;
+                out << std::fixed << std::setw(12) << value << std::setw(16) << std::setprecision(6) << percent / 100.0
+                    << std::setw(12) << std::min(at_or_below, total) << std::setw(18) << std::setprecision(2)
+                    << 100.0 / (100.0 - percent) << "\n";
+            }
+            if (covered)
+            {
+                out << std::setw(12) << max() << std::setw(16) << std::setprecision(6) << 1.0
+                    << std::setw(12) << total << "\n";
+                break;
+            }
+        }
+        out << "#[Mean = " << std::fixed << std::setprecision(2) << mean() << ", Max = " << max()
+            << ", Total count = " << total << "]\n";
+        out.flags(flags);
+        out.precision(precision);
+    }
+}
@@ -0,0 +1,101 @@
+//talgov44@gmail.com
+
+#include "LegalActions.hpp"
+
+namespace coup
+{
+    namespace
+    {
+        const ActionType UNTARGETED[] = {ActionType::Gather, ActionType::Tax, ActionType::Bribe, ActionType::Invest};
+        const ActionType TARGETED[] = {ActionType::Arrest, ActionType::Sanction, ActionType::Coup, ActionType::Undo};
+    }
+
+    std::uint64_t LegalActions::targets(ActionType type) const
+    {
+        switch (type)
+        {
+        case ActionType::Arrest:
+            return this->arrest_targets;
+        case ActionType::Sanction:
+            return this->sanction_targets;
+        case ActionType::Coup:
+            return this->coup_targets;
+        case ActionType::Undo:
+            return this->undo_targets;
+        default:
+            return 0;
+        }
+    }
+
+    bool LegalActions::can(ActionType type, size_t target) const
+    {
+        return target < 64 && ((targets(type) >> target) & 1u) != 0;
+    }
+
+    void LegalActions::allow(ActionType type, size_t target)
+    {
+        const std::uint64_t seat = std::uint64_t(1) << target;
+        switch (type)
+        {
+        case ActionType::Arrest:
+            this->arrest_targets |= seat;
+            break;
+        case ActionType::Sanction:
+            this->sanction_targets |= seat;
+            break;
+        case ActionType::Coup:
+            this->coup_targets |= seat;
+            break;
+        case ActionType::Undo:
+            this->undo_targets |= seat;
+            break;
+        default:
+            return;
+        }
+        allow(type);
+    }
+
+    void LegalActions::forbid(ActionType type)
+    {
+        this->mask &= static_cast<std::uint16_t>(~bit(type));
+        switch (type)
+        {
+        case ActionType::Arrest:
+            this->arrest_targets = 0;
+            break;
+        case ActionType::Sanction:
+            this->sanction_targets = 0;
+            break;
+        case ActionType::Coup:
+            this->coup_targets = 0;
+            break;
+        case ActionType::Undo:
+            this->undo_targets = 0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    size_t LegalActions::expand(Action *out, size_t capacity) const
+    {
+        size_t count = 0;
+        for (ActionType type : UNTARGETED)
+        {
+            if (can(type) && count < capacity)
+            {
+                out[count++] = {type, NO_TARGET};
+            }
+        }
+        for (ActionType type : TARGETED)
+        {
+            std::uint64_t remaining = targets(type);
+            while (remaining != 0 && count < capacity)
+            {
+                out[count++] = {type, __builtin_ctzll(remaining)};
+                remaining &= remaining - 1;
+            }
+        }
+        return count;
+    }
+}
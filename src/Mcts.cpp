@@ -0,0 +1,280 @@
+//talgov44@gmail.com
+
+#include "Mcts.hpp"
+#include "GameState.hpp"
+#include "ParallelMcts.hpp"
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace coup
+{
+    namespace
+    {
+        // How often the time budget is checked, in iterations.
+        const size_t CLOCK_INTERVAL = 64;
+
+        std::uint64_t draw_stream(CounterRng &rng)
+        {
+            const std::uint64_t high = rng();
+            return (high << 32) | rng();
+        }
+    }
+
+    double MctsStats::playouts_per_second() const
+    {
+        return this->seconds > 0.0 ? static_cast<double>(this->iterations) / this->seconds : 0.0;
+    }
+
+    /**
+     * @throws std::runtime_error If the node pool cannot hold the root and its children.
+     */
+    Mcts::Mcts(const MctsConfig &config) : _config(config), _used(0)
+    {
+        if (_config.max_nodes < MAX_ACTIONS + 1)
+        {
+            throw std::runtime_error("MCTS node pool is too small.");
+        }
+        if (_config.iterations == 0 && _config.seconds <= 0.0)
+        {
+            throw std::runtime_error("MCTS needs an iteration or time budget.");
+        }
+        _nodes.resize(_config.max_nodes);
+        _path.reserve(256);
+    }
+
+    const MctsStats &Mcts::stats() const
+    {
+        return _stats;
+    }
+
+    const MctsConfig &Mcts::config() const
+    {
+        return _config;
+    }
+
+    const MctsNode &Mcts::node(std::uint32_t index) const
+    {
+        return _nodes.at(index);
+    }
+
+    // Creates all children of a leaf at once, if the pool has room for them.
+    void Mcts::expand(std::uint32_t node, const Position &position)
+    {
+        Action actions[MAX_ACTIONS];
+        const size_t count = position.actions(actions, MAX_ACTIONS);
+        if (count == 0 || _used + count > _nodes.size())
+        {
+            return;
+        }
+        MctsNode &parent = _nodes[node];
+        parent.first_child = static_cast<std::uint32_t>(_used);
+        parent.child_count = static_cast<std::uint16_t>(count);
+        parent.expanded = true;
+        for (size_t i = 0; i < count; ++i)
+        {
+            MctsNode &child = _nodes[_used++];
+            child.action = actions[i];
+            child.first_child = 0;
+            child.child_count = 0;
+            child.mover = position.seat;
+            child.expanded = false;
+            child.visits = 0;
+            child.value = 0.0;
+        }
+    }
+
+    // UCT: mean reward of the child's mover plus an exploration bonus. Unvisited
+    // children are always tried first.
+    std::uint32_t Mcts::select_child(std::uint32_t node) const
+    {
+        const MctsNode &parent = _nodes[node];
+        const double log_visits = std::log(static_cast<double>(parent.visits));
+        std::uint32_t best = parent.first_child;
+        double best_score = -1.0;
+        for (std::uint32_t c = parent.first_child; c < parent.first_child + parent.child_count; ++c)
+        {
+            const MctsNode &child = _nodes[c];
+            if (child.visits == 0)
+            {
+                return c;
+            }
+            const double visits = static_cast<double>(child.visits);
+            const double score = child.value / visits + _config.exploration * std::sqrt(log_visits / visits);
+            if (score > best_score)
+            {
+                best_score = score;
+                best = c;
+            }
+        }
+        return best;
+    }
+
+    // Plays uniformly random actions and writes one reward per seat.
+    void mcts_playout(Position &position, size_t depth, CounterRng &rng, double *rewards)
+    {
+        Action actions[MAX_ACTIONS];
+        for (size_t played = 0; played < depth && !position.terminal(); ++played)
+        {
+            const size_t count = position.actions(actions, MAX_ACTIONS);
+            position.play(actions[rng.uniform(static_cast<std::uint32_t>(count))]);
+        }
+
+        const GameState &state = position.state;
+        const int winner = position.winner();
+        double total = 0.0;
+        for (size_t i = 0; i < state.player_count; ++i)
+        {
+            const bool alive = winner >= 0 ? static_cast<int>(i) == winner : state.players[i].has(PlayerState::ACTIVE);
+            rewards[i] = alive ? 1.0 + state.players[i].coins : 0.0;
+            total += rewards[i];
+        }
+        for (size_t i = 0; i < state.player_count; ++i)
+        {
+            rewards[i] /= total;
+        }
+    }
+
+    /**
+     * @brief Runs one search and returns the root action that was visited most.
+     *
+     * @param root A position that is not terminal.
+     * @param stream Selects the random streams of this search together with the seed.
+     * @throws std::runtime_error If the root position is terminal.
+     */
+    Action Mcts::search(const Position &root, std::uint64_t stream)
+    {
+        if (root.terminal())
+        {
+            throw std::runtime_error("Cannot search a finished game.");
+        }
+        const auto start = std::chrono::steady_clock::now();
+        const bool timed = _config.seconds > 0.0;
+
+        MctsNode &top = _nodes[0];
+        top.action = {ActionType::None, NO_TARGET};
+        top.child_count = 0;
+        top.expanded = false;
+        top.visits = 0;
+        top.value = 0.0;
+        top.mover = root.seat;
+        _used = 1;
+        expand(0, root);
+
+        double rewards[GameState::MAX_PLAYERS];
+        size_t iteration = 0;
+        while (_config.iterations == 0 || iteration < _config.iterations)
+        {
+            if (timed && iteration % CLOCK_INTERVAL == 0 &&
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= _config.seconds)
+            {
+                break;
+            }
+            CounterRng rng(_config.seed, stream, static_cast<std::uint32_t>(iteration));
+            Position position = root;
+            std::uint32_t node = 0;
+            _path.clear();
+            _path.push_back(node);
+
+            // Selection
+            while (_nodes[node].expanded)
+            {
+                node = select_child(node);
+                position.play(_nodes[node].action);
+                _path.push_back(node);
+            }
+
+            // Expansion: add every child of the leaf and step into one of them.
+            if (!position.terminal() && _nodes[node].visits > 0)
+            {
+                expand(node, position);
+                if (_nodes[node].expanded)
+                {
+                    node = _nodes[node].first_child + rng.uniform(_nodes[node].child_count);
+                    position.play(_nodes[node].action);
+                    _path.push_back(node);
+                }
+            }
+
+            mcts_playout(position, _config.playout_depth, rng, rewards);
+
+            for (std::uint32_t index : _path)
+            {
+                MctsNode &n = _nodes[index];
+                n.visits++;
+                n.value += rewards[n.mover];
+            }
+            ++iteration;
+        }
+
+        const MctsNode &parent = _nodes[0];
+        std::uint32_t best = parent.first_child;
+        for (std::uint32_t c = parent.first_child; c < parent.first_child + parent.child_count; ++c)
+        {
+            if (_nodes[c].visits > _nodes[best].visits)
+            {
+                best = c;
+            }
+        }
+
+        _stats.iterations = iteration;
+        _stats.nodes = _used;
+        _stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return _nodes[best].action;
+    }
+
+    MctsPolicy::MctsPolicy(const MctsConfig &config) : _search(config)
+    {
+        if (config.threads > 1)
+        {
+            _parallel = std::make_unique<ParallelMcts>(config);
+        }
+    }
+
+    MctsPolicy::~MctsPolicy() = default;
+
+    const MctsStats &MctsPolicy::last_search() const
+    {
+        return _parallel ? _parallel->stats() : _search.stats();
+    }
+
+    Action MctsPolicy::search(const Position &root, std::uint64_t stream)
+    {
+        return _parallel ? _parallel->search(root, stream) : _search.search(root, stream);
+    }
+
+    /**
+     * @throws std::runtime_error If the search picks an action that is not in
+     *                            `legal`, i.e. the rules engine and Game disagree.
+     */
+    Action MctsPolicy::choose(const Game &game, const Player &self,
+                              const Action *legal, size_t count, CounterRng &rng)
+    {
+        (void)self;
+        if (count == 1)
+        {
+            return legal[0];
+        }
+        const Action best = search(Position::turn(GameState::capture(game)), draw_stream(rng));
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (legal[i].type == best.type && legal[i].target == best.target)
+            {
+                return legal[i];
+            }
+        }
+        throw std::runtime_error("MCTS chose an action the game does not allow.");
+    }
+
+    bool MctsPolicy::react(const Game &game, const Player &self, const Player &actor, CounterRng &rng)
+    {
+        const size_t seat = game.seat_of(self);
+        const Position root = Position::reaction(GameState::capture(game), game.seat_of(actor),
+                                                 actor.lastActionType(), seat);
+        if (root.phase != Position::REACTION || root.seat != seat)
+        {
+            return false;
+        }
+        return search(root, draw_stream(rng)).type == ActionType::Undo;
+    }
+}
@@ -6,6 +6,6 @@ namespace coup
 {
     Merchant::Merchant(Game &game, const std::string &name) : Player(game, name)
     {
-        this->_role = "Merchant";
+        this->_role = Role::Merchant;
     }
 }
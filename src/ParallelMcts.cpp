@@ -0,0 +1,320 @@
+//talgov44@gmail.com
+
+#include "ParallelMcts.hpp"
+#include "GameState.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace coup
+{
+    namespace
+    {
+        // Rewards are summed in fixed point so they can be added with fetch_add.
+        const double VALUE_SCALE = static_cast<double>(1 << 24);
+        const size_t CLOCK_INTERVAL = 64;
+    }
+
+    void ParallelMctsNode::reset(const Action &action, std::uint8_t mover)
+    {
+        this->action = action;
+        this->mover = mover;
+        this->child_count = 0;
+        this->first_child = 0;
+        this->status.store(LEAF, std::memory_order_relaxed);
+        this->visits.store(0, std::memory_order_relaxed);
+        this->pending.store(0, std::memory_order_relaxed);
+        this->value.store(0, std::memory_order_relaxed);
+    }
+
+    double ParallelMctsNode::mean() const
+    {
+        const std::uint32_t n = this->visits.load(std::memory_order_relaxed);
+        return n == 0 ? 0.0 : static_cast<double>(this->value.load(std::memory_order_relaxed)) / VALUE_SCALE / n;
+    }
+
+    /**
+     * @throws std::runtime_error If the node pool cannot hold the root and its
+     *                            children, or there is no search budget.
+     */
+    ParallelMcts::ParallelMcts(const MctsConfig &config)
+        : _config(config), _used(0), _next_iteration(0), _stop(false), _generation(0), _running(0),
+          _shutdown(false), _job_root(nullptr), _job_stream(0)
+    {
+        if (_config.max_nodes < MAX_ACTIONS + 1)
+        {
+            throw std::runtime_error("MCTS node pool is too small.");
+        }
+        if (_config.iterations == 0 && _config.seconds <= 0.0)
+        {
+            throw std::runtime_error("MCTS needs an iteration or time budget.");
+        }
+        if (_config.threads == 0)
+        {
+            _config.threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        _nodes.reset(new ParallelMctsNode[_config.max_nodes]);
+        try
+        {
+            for (size_t t = 1; t < _config.threads; ++t)
+            {
+                _workers.emplace_back(&ParallelMcts::worker_loop, this);
+            }
+        }
+        catch (...)
+        {
+            stop_workers();
+            throw;
+        }
+    }
+
+    ParallelMcts::~ParallelMcts()
+    {
+        stop_workers();
+    }
+
+    void ParallelMcts::stop_workers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            this->_shutdown = true;
+        }
+        _wake.notify_all();
+        for (std::thread &worker : _workers)
+        {
+            worker.join();
+        }
+        _workers.clear();
+    }
+
+    // Body of each helper thread: run every published search once, until shutdown.
+    void ParallelMcts::worker_loop()
+    {
+        std::uint64_t seen = 0;
+        for (;;)
+        {
+            const Position *root = nullptr;
+            std::uint64_t stream = 0;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [&]
+                           { return _shutdown || _generation != seen; });
+                if (_shutdown)
+                {
+                    return;
+                }
+                seen = _generation;
+                root = _job_root;
+                stream = _job_stream;
+            }
+            work(*root, stream, _config.seconds);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (--_running == 0)
+                {
+                    _done.notify_one();
+                }
+            }
+        }
+    }
+
+    const MctsStats &ParallelMcts::stats() const
+    {
+        return _stats;
+    }
+
+    const MctsConfig &ParallelMcts::config() const
+    {
+        return _config;
+    }
+
+    const ParallelMctsNode &ParallelMcts::node(std::uint32_t index) const
+    {
+        if (index >= std::min(_used.load(std::memory_order_acquire), _config.max_nodes))
+        {
+            throw std::runtime_error("No such MCTS node.");
+        }
+        return _nodes[index];
+    }
+
+    /**
+     * @brief Expands a leaf if this thread wins the race for it.
+     *
+     * The children are reserved with one fetch_add on the pool and filled in
+     * before the release store that marks the node expanded, so threads that
+     * see EXPANDED also see the children. A thread that loses the race, or finds
+     * the pool full, simply plays out from the leaf.
+     *
+     * @return bool Whether this call expanded the node.
+     */
+    bool ParallelMcts::expand(std::uint32_t node, const Position &position)
+    {
+        ParallelMctsNode &parent = _nodes[node];
+        std::uint8_t expected = ParallelMctsNode::LEAF;
+        if (!parent.status.compare_exchange_strong(expected, ParallelMctsNode::EXPANDING, std::memory_order_acq_rel))
+        {
+            return false;
+        }
+        Action actions[MAX_ACTIONS];
+        const size_t count = position.actions(actions, MAX_ACTIONS);
+        const size_t first = count == 0 ? 0 : _used.fetch_add(count, std::memory_order_relaxed);
+        if (count == 0 || first + count > _config.max_nodes)
+        {
+            // Leave the node EXPANDING for good: it stays a leaf for every thread.
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            _nodes[first + i].reset(actions[i], position.seat);
+        }
+        parent.first_child = static_cast<std::uint32_t>(first);
+        parent.child_count = static_cast<std::uint16_t>(count);
+        parent.status.store(ParallelMctsNode::EXPANDED, std::memory_order_release);
+        return true;
+    }
+
+    // UCT where every thread currently below a child counts as virtual_loss
+    // visits that earned nothing.
+    std::uint32_t ParallelMcts::select_child(std::uint32_t node) const
+    {
+        const ParallelMctsNode &parent = _nodes[node];
+        const double parent_visits = parent.visits.load(std::memory_order_relaxed) +
+                                     static_cast<double>(parent.pending.load(std::memory_order_relaxed)) * _config.virtual_loss;
+        const double log_visits = std::log(std::max(1.0, parent_visits));
+        std::uint32_t best = parent.first_child;
+        double best_score = -1.0;
+        for (std::uint32_t c = parent.first_child; c < parent.first_child + parent.child_count; ++c)
+        {
+            const ParallelMctsNode &child = _nodes[c];
+            const std::uint32_t visits = child.visits.load(std::memory_order_relaxed);
+            const std::uint32_t pending = child.pending.load(std::memory_order_relaxed);
+            if (visits == 0 && pending == 0)
+            {
+                return c;
+            }
+            const double n = visits + static_cast<double>(pending) * _config.virtual_loss;
+            const double value = static_cast<double>(child.value.load(std::memory_order_relaxed)) / VALUE_SCALE;
+            const double score = value / n + _config.exploration * std::sqrt(log_visits / n);
+            if (score > best_score)
+            {
+                best_score = score;
+                best = c;
+            }
+        }
+        return best;
+    }
+
+    // One search thread: claims iteration numbers until the budget is spent.
+    void ParallelMcts::work(const Position &root, std::uint64_t stream, double seconds_left)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::uint32_t> path;
+        path.reserve(256);
+        double rewards[GameState::MAX_PLAYERS];
+        size_t local = 0;
+        while (!_stop.load(std::memory_order_relaxed))
+        {
+            if (seconds_left > 0.0 && local++ % CLOCK_INTERVAL == 0 &&
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= seconds_left)
+            {
+                _stop.store(true, std::memory_order_relaxed);
+                break;
+            }
+            const size_t iteration = _next_iteration.fetch_add(1, std::memory_order_relaxed);
+            if (_config.iterations != 0 && iteration >= _config.iterations)
+            {
+                break;
+            }
+
+            CounterRng rng(_config.seed, stream, static_cast<std::uint32_t>(iteration));
+            Position position = root;
+            std::uint32_t node = 0;
+            path.clear();
+            path.push_back(node);
+            _nodes[node].pending.fetch_add(1, std::memory_order_relaxed);
+
+            // Selection
+            while (_nodes[node].status.load(std::memory_order_acquire) == ParallelMctsNode::EXPANDED)
+            {
+                node = select_child(node);
+                _nodes[node].pending.fetch_add(1, std::memory_order_relaxed);
+                position.play(_nodes[node].action);
+                path.push_back(node);
+            }
+
+            // Expansion
+            if (!position.terminal() && _nodes[node].visits.load(std::memory_order_relaxed) > 0 &&
+                expand(node, position))
+            {
+                const ParallelMctsNode &leaf = _nodes[node];
+                node = leaf.first_child + rng.uniform(leaf.child_count);
+                _nodes[node].pending.fetch_add(1, std::memory_order_relaxed);
+                position.play(_nodes[node].action);
+                path.push_back(node);
+            }
+
+            mcts_playout(position, _config.playout_depth, rng, rewards);
+
+            for (std::uint32_t index : path)
+            {
+                ParallelMctsNode &n = _nodes[index];
+                n.value.fetch_add(static_cast<std::int64_t>(rewards[n.mover] * VALUE_SCALE), std::memory_order_relaxed);
+                n.visits.fetch_add(1, std::memory_order_relaxed);
+                n.pending.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Runs one search on the calling thread and the pooled helpers, and
+     *        returns the most visited root action.
+     *
+     * @throws std::runtime_error If the root position is terminal.
+     */
+    Action ParallelMcts::search(const Position &root, std::uint64_t stream)
+    {
+        if (root.terminal())
+        {
+            throw std::runtime_error("Cannot search a finished game.");
+        }
+        const auto start = std::chrono::steady_clock::now();
+        _nodes[0].reset({ActionType::None, NO_TARGET}, root.seat);
+        _used.store(1, std::memory_order_relaxed);
+        _next_iteration.store(0, std::memory_order_relaxed);
+        _stop.store(false, std::memory_order_relaxed);
+        expand(0, root);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            this->_job_root = &root;
+            this->_job_stream = stream;
+            this->_running = _workers.size();
+            ++_generation;
+        }
+        _wake.notify_all();
+        work(root, stream, _config.seconds);
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _done.wait(lock, [this]
+                       { return _running == 0; });
+        }
+
+        const ParallelMctsNode &parent = _nodes[0];
+        std::uint32_t best = parent.first_child;
+        for (std::uint32_t c = parent.first_child; c < parent.first_child + parent.child_count; ++c)
+        {
+            if (_nodes[c].visits.load(std::memory_order_relaxed) > _nodes[best].visits.load(std::memory_order_relaxed))
+            {
+                best = c;
+            }
+        }
+
+        _stats.iterations = parent.visits.load(std::memory_order_relaxed);
+        _stats.nodes = std::min(_used.load(std::memory_order_relaxed), _config.max_nodes);
+        _stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return _nodes[best].action;
+    }
+}
@@ -0,0 +1,165 @@
+//talgov44@gmail.com
+
+#include "PerfCounters.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace coup
+{
+    PerfSample &PerfSample::operator+=(const PerfSample &other)
+    {
+        this->cycles += other.cycles;
+        this->instructions += other.instructions;
+        this->cache_misses += other.cache_misses;
+        this->branch_misses += other.branch_misses;
+        return *this;
+    }
+
+    namespace
+    {
+        std::uint64_t minus(std::uint64_t after, std::uint64_t before, std::uint64_t overhead)
+        {
+            const std::uint64_t delta = after >= before ? after - before : 0;
+            return delta > overhead ? delta - overhead : 0;
+        }
+
+#ifdef __linux__
+        const std::uint64_t EVENTS[4] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                         PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+        int open_event(std::uint64_t config, int group)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = config;
+            attr.disabled = group < 0 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+        }
+#endif
+    }
+
+    PerfCounters::PerfCounters() : _group(-1), _members{-1, -1, -1}
+    {
+#ifdef __linux__
+        this->_group = open_event(EVENTS[0], -1);
+        for (size_t i = 0; i < 3 && _group >= 0; ++i)
+        {
+            this->_members[i] = open_event(EVENTS[i + 1], _group);
+            if (_members[i] < 0)
+            {
+                const int error = errno;
+                for (size_t j = 0; j < i; ++j)
+                {
+                    close(_members[j]);
+                    this->_members[j] = -1;
+                }
+                close(_group);
+                this->_group = -1;
+                errno = error;
+            }
+        }
+        if (_group < 0)
+        {
+            this->_error = std::string("perf_event_open failed: ") + std::strerror(errno);
+            return;
+        }
+        ioctl(_group, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(_group, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+        // The smallest of a few back-to-back reads is the cost of reading.
+        PerfSample overhead;
+        for (int i = 0; i < 16; ++i)
+        {
+            const PerfSample before = read();
+            const PerfSample after = read();
+            const PerfSample cost{after.cycles - before.cycles, after.instructions - before.instructions,
+                                  after.cache_misses - before.cache_misses, after.branch_misses - before.branch_misses};
+            overhead = i == 0 ? cost : PerfSample{std::min(overhead.cycles, cost.cycles),
+                                                  std::min(overhead.instructions, cost.instructions),
+                                                  std::min(overhead.cache_misses, cost.cache_misses),
+                                                  std::min(overhead.branch_misses, cost.branch_misses)};
+        }
+        this->_overhead = overhead;
+#else
+        this->_error = "perf_event_open is only available on Linux";
+#endif
+    }
+
+    PerfCounters::~PerfCounters()
+    {
+#ifdef __linux__
+        for (int fd : _members)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+        if (_group >= 0)
+        {
+            close(_group);
+        }
+#endif
+    }
+
+    PerfSample PerfCounters::read() const
+    {
+        PerfSample sample;
+#ifdef __linux__
+        if (_group < 0)
+        {
+            return sample;
+        }
+        std::uint64_t values[1 + 4] = {}; // PERF_FORMAT_GROUP: count, then one value per event.
+        if (::read(_group, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[0] != 4)
+        {
+            return sample;
+        }
+        sample.cycles = values[1];
+        sample.instructions = values[2];
+        sample.cache_misses = values[3];
+        sample.branch_misses = values[4];
+#endif
+        return sample;
+    }
+
+    PerfSample PerfCounters::since(const PerfSample &before) const
+    {
+        const PerfSample after = read();
+        PerfSample delta;
+        delta.cycles = minus(after.cycles, before.cycles, _overhead.cycles);
+        delta.instructions = minus(after.instructions, before.instructions, _overhead.instructions);
+        delta.cache_misses = minus(after.cache_misses, before.cache_misses, _overhead.cache_misses);
+        delta.branch_misses = minus(after.branch_misses, before.branch_misses, _overhead.branch_misses);
+        return delta;
+    }
+
+    void PerfByAction::record(ActionType type, const PerfSample &sample)
+    {
+        this->totals[static_cast<size_t>(type)] += sample;
+        ++this->calls[static_cast<size_t>(type)];
+    }
+
+    PerfByAction &PerfByAction::operator+=(const PerfByAction &other)
+    {
+        for (size_t i = 0; i < ACTION_TYPE_COUNT; ++i)
+        {
+            this->totals[i] += other.totals[i];
+            this->calls[i] += other.calls[i];
+        }
+        return *this;
+    }
+}
@@ -1,29 +1,26 @@
 //talgov44@gmail.com
 
 #include "Player.hpp"
+#include "Constants.hpp"
+#include "Instrument.hpp"
+#include "Trace.hpp"
+#include "Zobrist.hpp"
 #include <iostream>
 
 namespace coup
 {
 
-    const int BRIBE_COST = 4;
-    const int SANCTION_COST = 3;
-    const int COUP_COST = 7;
-    const int MUST_COUP_COINS = 10;
-    const int JUDGE_SANCTION_PENALTY = 1;
-    const int MERCHANT_ARREST_PENALTY = 2;
-    const int BARON_SANCTION_COMPENSATION = 1;
-
     Player::Player(Game &game, const std::string &name) : game(game),
                                                           _name(name),
                                                           _coins(0),
                                                           is_active(true),
-                                                          _role("player"),
-                                                          last_action(""),
-                                                          _last_arrested_target(nullptr),
+                                                          _role(Role::Player),
+                                                          last_action(ActionType::None),
+                                                          _last_arrested_seat(NO_TARGET),
                                                           _is_sanctioned(false),
                                                           _has_extra_action(false),
-                                                          _aggressor_in_last_coup(nullptr)
+                                                          _aggressor_seat(NO_TARGET),
+                                                          _seat(game.get_players().size())
     {
         this->game.add_player(this);
     }
@@ -35,34 +32,35 @@ namespace coup
      * must be active (not eliminated) and it must be their turn according to the
      * game state.
      *
-     * @throws std::runtime_error If the player is not active.
-     * @throws std::runtime_error If it is not the player's turn.
+     * @return ActionResult PlayerNotActive if the player is not active,
+     *                      NotYourTurn if it is not the player's turn, or the
+     *                      game's error if no turn can be taken at all.
      */
-    void Player::check_turn() const
+    ActionResult Player::check_turn() const
     {
         if (!this->is_active)
         {
-            throw std::runtime_error("Player " + this->_name + " is not active.");
+            return ActionResult::PlayerNotActive;
         }
-        if (this->game.turn() != this->_name)
+        Player *current = nullptr;
+        ActionResult result = this->game.try_current_player(current);
+        if (result != ActionResult::Ok)
         {
-            throw std::runtime_error("It's not " + this->_name + "'s turn!");
+            return result;
         }
+        return current == this ? ActionResult::Ok : ActionResult::NotYourTurn;
     }
 
-    void Player::must_coup() const
+    ActionResult Player::must_coup() const
     {
-        if (this->_coins >= MUST_COUP_COINS)
-        {
-            throw std::runtime_error("Player must perform a coup with 10 or more coins.");
-        }
+        return this->_coins >= MUST_COUP_COINS ? ActionResult::MustCoup : ActionResult::Ok;
     }
 
     void Player::end_turn_or_continue()
     {
         if (this->_has_extra_action)
         {
-            this->_has_extra_action = false;
+            setExtraAction(false);
         }
         else
         {
@@ -72,7 +70,71 @@ namespace coup
 
     void Player::cancelExtraAction()
     {
+        setExtraAction(false);
+    }
+
+    // Same values as the constructor. Only the name, role and seat are kept.
+    void Player::reset()
+    {
+        this->_coins = 0;
+        this->is_active = true;
+        this->last_action = ActionType::None;
+        this->_last_arrested_seat = NO_TARGET;
+        this->_is_sanctioned = false;
         this->_has_extra_action = false;
+        this->_aggressor_seat = NO_TARGET;
+    }
+
+    void Player::gather()
+    {
+        COUP_RECORD_LATENCY(Gather);
+        COUP_TRACK_ALLOCATIONS(Gather);
+        throw_action_error(try_gather());
+    }
+    void Player::tax()
+    {
+        COUP_RECORD_LATENCY(Tax);
+        COUP_TRACK_ALLOCATIONS(Tax);
+        throw_action_error(try_tax());
+    }
+    void Player::bribe()
+    {
+        COUP_RECORD_LATENCY(Bribe);
+        COUP_TRACK_ALLOCATIONS(Bribe);
+        throw_action_error(try_bribe());
+    }
+    void Player::arrest(Player &target)
+    {
+        COUP_RECORD_LATENCY(Arrest);
+        COUP_TRACK_ALLOCATIONS(Arrest);
+        throw_action_error(try_arrest(target));
+    }
+    void Player::sanction(Player &target)
+    {
+        COUP_RECORD_LATENCY(Sanction);
+        COUP_TRACK_ALLOCATIONS(Sanction);
+        throw_action_error(try_sanction(target));
+    }
+    void Player::coup(Player &target)
+    {
+        COUP_RECORD_LATENCY(Coup);
+        COUP_TRACK_ALLOCATIONS(Coup);
+        throw_action_error(try_coup(target));
+    }
+    void Player::undo(Player &target)
+    {
+        COUP_RECORD_UNDO_LATENCY(this->_role);
+        COUP_TRACK_ALLOCATIONS(Undo);
+        throw_action_error(try_undo(target));
+    }
+
+    void Player::throw_action_error(ActionResult result)
+    {
+        if (result != ActionResult::Ok)
+        {
+            COUP_TRACE_FLAG_LAST(TRACE_THREW);
+            throw_if_failed(result);
+        }
     }
 
     /**
@@ -84,23 +146,37 @@ namespace coup
      * If the player is sanctioned, this action will fail. The sanction will be
      * cleared, but the turn is still consumed, effectively wasting the turn.
      *
-     * @throws std::runtime_error If it is not the player's turn.
-     * @throws std::runtime_error If the player has 10 or more coins and is required to coup.
-     * @throws std::runtime_error If the player is sanctioned for the turn.
+     * @return ActionResult NotYourTurn (or another turn error) if it is not the player's turn,
+     *                      MustCoup if the player has 10 or more coins,
+     *                      Sanctioned if the player is sanctioned for the turn.
      */
-    void Player::gather()
+    ActionResult Player::try_gather()
     {
-        check_turn();
-        must_coup();
+        COUP_RECORD_LATENCY(Gather);
+        COUP_TRACK_ALLOCATIONS(Gather);
+        COUP_TRACE_SPAN("Player::try_gather");
+        ActionResult result = check_turn();
+        if (result == ActionResult::Ok)
+        {
+            result = must_coup();
+        }
+        if (result != ActionResult::Ok)
+        {
+            return result;
+        }
+        const int coins_before = this->_coins;
         if (this->_is_sanctioned)
         {
-            this->_is_sanctioned = false;
+            setSanctioned(false);
             end_turn_or_continue(); // Turn or extra action is wasted
-            throw std::runtime_error("Cannot use gather, you are sanctioned for this turn.");
+            report(EventKind::Action, ActionType::Gather, ActionResult::Sanctioned, nullptr, coins_before, 0);
+            return ActionResult::Sanctioned;
         }
-        this->_coins++;
-        this->last_action = "gather";
+        addCoins(1);
+        setLastAction(ActionType::Gather);
         end_turn_or_continue();
+        report(EventKind::Action, ActionType::Gather, ActionResult::Ok, nullptr, coins_before, 0);
+        return ActionResult::Ok;
     }
 
     /**
@@ -111,24 +187,38 @@ namespace coup
      * If the player is sanctioned, this action will fail. The sanction will be
      * cleared, but the turn is still consumed
      *
-     * @throws std::runtime_error If it is not the player's turn.
-     * @throws std::runtime_error If the player has 10 or more coins and is required to coup.
-     * @throws std::runtime_error If the player is sanctioned for the turn.
-     * @see Governor::tax()
+     * @return ActionResult NotYourTurn (or another turn error) if it is not the player's turn,
+     *                      MustCoup if the player has 10 or more coins,
+     *                      Sanctioned if the player is sanctioned for the turn.
+     * @see Governor::try_tax()
      */
-    void Player::tax()
+    ActionResult Player::try_tax()
     {
-        check_turn();
-        must_coup();
+        COUP_RECORD_LATENCY(Tax);
+        COUP_TRACK_ALLOCATIONS(Tax);
+        COUP_TRACE_SPAN("Player::try_tax");
+        ActionResult result = check_turn();
+        if (result == ActionResult::Ok)
+        {
+            result = must_coup();
+        }
+        if (result != ActionResult::Ok)
+        {
+            return result;
+        }
+        const int coins_before = this->_coins;
         if (this->_is_sanctioned)
         {
-            this->_is_sanctioned = false;
+            setSanctioned(false);
             end_turn_or_continue();
-            throw std::runtime_error("Cannot use tax, you are sanctioned for this turn.");
+            report(EventKind::Action, ActionType::Tax, ActionResult::Sanctioned, nullptr, coins_before, 0);
+            return ActionResult::Sanctioned;
         }
-        this->_coins += 2;
-        this->last_action = "tax";
+        addCoins(TAX_AMOUNT);
+        setLastAction(ActionType::Tax);
         end_turn_or_continue();
+        report(EventKind::Action, ActionType::Tax, ActionResult::Ok, nullptr, coins_before, 0);
+        return ActionResult::Ok;
     }
 
     /**
@@ -137,66 +227,88 @@ namespace coup
      * This action costs 4 coins and grants the player an immediate second action
      * within the same turn. It does not end the player's turn.
      *
-     * @throws std::runtime_error If it is not the player's turn.
-     * @throws std::runtime_error If the player has 10 or more coins and is required to coup.
-     * @throws std::runtime_error If the player has fewer than 4 coins.
+     * @return ActionResult NotYourTurn (or another turn error) if it is not the player's turn,
+     *                      MustCoup if the player has 10 or more coins,
+     *                      NotEnoughCoins if the player has fewer than 4 coins.
      */
-    void Player::bribe()
+    ActionResult Player::try_bribe()
     {
-        check_turn();
-        must_coup();
-        this->_is_sanctioned = false;
+        COUP_RECORD_LATENCY(Bribe);
+        COUP_TRACK_ALLOCATIONS(Bribe);
+        COUP_TRACE_SPAN("Player::try_bribe");
+        ActionResult result = check_turn();
+        if (result == ActionResult::Ok)
+        {
+            result = must_coup();
+        }
+        if (result != ActionResult::Ok)
+        {
+            return result;
+        }
+        const int coins_before = this->_coins;
         if (this->_coins < BRIBE_COST)
         {
-            throw std::runtime_error("Not enough coins for a bribe.");
+            return ActionResult::NotEnoughCoins;
         }
+        setSanctioned(false);
         this->removeCoins(BRIBE_COST);
-        this->_has_extra_action = true;
-        this->last_action = "bribe";
+        setExtraAction(true);
+        setLastAction(ActionType::Bribe);
+        report(EventKind::Action, ActionType::Bribe, ActionResult::Ok, nullptr, coins_before, 0);
+        return ActionResult::Ok;
     }
 
-    void Player::arrest(Player &target)
+    ActionResult Player::try_arrest(Player &target)
     {
-        this->game.clearSaveWindow();
-        check_turn();
-        must_coup();
-        this->_is_sanctioned = false;
+        COUP_RECORD_LATENCY(Arrest);
+        COUP_TRACK_ALLOCATIONS(Arrest);
+        COUP_TRACE_SPAN("Player::try_arrest");
+        ActionResult result = check_turn();
+        if (result == ActionResult::Ok)
+        {
+            result = must_coup();
+        }
+        if (result != ActionResult::Ok)
+        {
+            return result;
+        }
+        const int coins_before = this->_coins;
+        const int target_before = target.coins();
         if (this == &target || !target.isActive())
         {
-            throw std::runtime_error("Invalid target for arrest.");
+            return ActionResult::InvalidTarget;
+        }
+        if (static_cast<int>(target._seat) == this->_last_arrested_seat)
+        {
+            return ActionResult::RepeatArrest;
         }
-        if (&target == this->_last_arrested_target)
+        if (target.coins() < (target._role == Role::Merchant ? MERCHANT_ARREST_PENALTY : 1))
         {
-            throw std::runtime_error("Cannot arrest the same player twice in a row.");
+            return ActionResult::TargetCannotPay;
         }
 
-        if (target.role() == "Merchant")
+        this->game.clearSaveWindow();
+        setSanctioned(false);
+        if (target._role == Role::Merchant)
         {
-            if (target.coins() < MERCHANT_ARREST_PENALTY)
-            {
-                throw std::runtime_error("Merchant target does not have enough coins to pay the penalty.");
-            }
             target.removeCoins(MERCHANT_ARREST_PENALTY);
             // Arresting player gets nothing
         }
         else
         {
-
-            if (target.coins() < 1)
-            {
-                throw std::runtime_error("Target has no coins to take.");
-            }
             target.removeCoins(1);
             this->addCoins(1);
-            if (target.role() == "General")
+            if (target._role == Role::General)
             {
                 target.addCoins(1);
             }
         }
 
-        this->_last_arrested_target = &target;
-        this->last_action = "arrest";
+        setLastArrestedTarget(&target);
+        setLastAction(ActionType::Arrest);
         end_turn_or_continue();
+        report(EventKind::Action, ActionType::Arrest, ActionResult::Ok, &target, coins_before, target_before);
+        return ActionResult::Ok;
     }
 
     /**
@@ -207,38 +319,52 @@ namespace coup
      * wasting their turn.
      *
      * @param target The player to apply the sanction to.
-     * @throws std::runtime_error If it is not the player's turn.
-     * @throws std::runtime_error If the player has 10 or more coins and must coup.
-     * @throws std::runtime_error If the player cannot afford the sanction cost (including role-based penalties).
-     * @throws std::runtime_error If the target is invalid (e.g., self or inactive).
+     * @return ActionResult NotYourTurn (or another turn error) if it is not the player's turn,
+     *                      MustCoup if the player has 10 or more coins,
+     *                      NotEnoughCoins if the player cannot afford the sanction,
+     *                      InvalidTarget if the target is self or inactive.
      */
-    void Player::sanction(Player &target)
+    ActionResult Player::try_sanction(Player &target)
     {
-        check_turn();
-        must_coup();
-        this->_is_sanctioned = false;
+        COUP_RECORD_LATENCY(Sanction);
+        COUP_TRACK_ALLOCATIONS(Sanction);
+        COUP_TRACE_SPAN("Player::try_sanction");
+        ActionResult result = check_turn();
+        if (result == ActionResult::Ok)
+        {
+            result = must_coup();
+        }
+        if (result != ActionResult::Ok)
+        {
+            return result;
+        }
+        const int coins_before = this->_coins;
+        const int target_before = target.coins();
         if (this->coins() < SANCTION_COST)
         {
-            throw std::runtime_error("Not enough coins for a sanction.");
+            return ActionResult::NotEnoughCoins;
         }
         if (this == &target || !target.isActive())
         {
-            throw std::runtime_error("Invalid target for sanction.");
+            return ActionResult::InvalidTarget;
         }
+        setSanctioned(false);
         this->removeCoins(SANCTION_COST);
         // If the target is a Judge, the sanctioner pays an extra coin.
-        if (target.role() == "Judge")
+        if (target._role == Role::Judge)
         {
             this->removeCoins(JUDGE_SANCTION_PENALTY);
         }
-        if (target.role() == "Baron")
+        if (target._role == Role::Baron)
         {
             target.addCoins(BARON_SANCTION_COMPENSATION);
         }
 
         target.setSanctioned(true);
-        this->last_action = "sanction";
+        setLastAction(ActionType::Sanction);
         end_turn_or_continue();
+        report(EventKind::Action, ActionType::Sanction, ActionResult::Ok, &target, coins_before, target_before);
+        return ActionResult::Ok;
     }
 
     /**
@@ -252,55 +378,151 @@ namespace coup
      * undo the elimination before the next player's turn.
      *
      * @param target The player to be eliminated.
-     * @throws std::runtime_error If it is not the player's turn.
-     * @throws std::runtime_error If the player has fewer than 7 coins.
-     * @throws std::runtime_error If the player attempts to coup themselves.
-     * @throws std::runtime_error If the target player is already inactive.
+     * @return ActionResult NotYourTurn (or another turn error) if it is not the player's turn,
+     *                      NotEnoughCoins if the player has fewer than 7 coins,
+     *                      InvalidTarget if the target is self or already inactive.
      */
-    void Player::coup(Player &target)
+    ActionResult Player::try_coup(Player &target)
     {
-        check_turn();
-        this->_is_sanctioned = false;
-        if (this->_coins < COUP_COST)
+        COUP_RECORD_LATENCY(Coup);
+        COUP_TRACK_ALLOCATIONS(Coup);
+        COUP_TRACE_SPAN("Player::try_coup");
+        ActionResult result = check_turn();
+        if (result != ActionResult::Ok)
         {
-            throw std::runtime_error("Not enough coins for a coup (needs 7)!");
+            return result;
         }
-        if (this == &target)
+        const int coins_before = this->_coins;
+        const int target_before = target.coins();
+        if (this->_coins < COUP_COST)
         {
-            throw std::runtime_error("Cannot perform a coup on yourself.");
+            return ActionResult::NotEnoughCoins;
         }
-        if (!target.isActive())
+        if (this == &target || !target.isActive())
         {
-            throw std::runtime_error("Target player " + target.getName() + " is already out of the game.");
+            return ActionResult::InvalidTarget;
         }
-        this->_coins -= COUP_COST;
+        setSanctioned(false);
+        removeCoins(COUP_COST);
         target.eliminate();
         this->game.setPlayerToSave(&target);
-        this->last_action = "coup";
+        setLastAction(ActionType::Coup);
         end_turn_or_continue();
+        report(EventKind::Action, ActionType::Coup, ActionResult::Ok, &target, coins_before, target_before);
+        return ActionResult::Ok;
+    }
+
+    /**
+     * @brief Sends an Action or Undo event for this player to the game's event sink.
+     *
+     * Does nothing when the game has no sink attached.
+     */
+    void Player::report(EventKind kind, ActionType action, ActionResult result, const Player *target,
+                        int coins_before, int target_before) const
+    {
+        if (this->game.event_sink() == nullptr)
+        {
+            return;
+        }
+        GameEvent event{};
+        event.kind = kind;
+        event.action = action;
+        event.result = result;
+        event.actor = static_cast<std::uint16_t>(this->game.seat_of(*this));
+        event.target = target == nullptr ? NO_SEAT : static_cast<std::uint16_t>(this->game.seat_of(*target));
+        event.actor_delta = static_cast<std::int16_t>(this->_coins - coins_before);
+        event.target_delta = target == nullptr ? 0 : static_cast<std::int16_t>(target->_coins - target_before);
+        this->game.emit(event);
     }
 
-    std::string Player::role() const { return this->_role; }
+    Role Player::roleType() const { return this->_role; }
+    ActionType Player::lastActionType() const { return this->last_action; }
+    std::string Player::role() const
+    {
+        COUP_TRACK_ALLOCATIONS(RoleName);
+        return to_string(this->_role);
+    }
     int Player::coins() const { return this->_coins; }
-    std::string Player::getName() const { return this->_name; }
+    std::string Player::getName() const
+    {
+        COUP_TRACK_ALLOCATIONS(GetName);
+        return this->_name;
+    }
     bool Player::isActive() const { return this->is_active; }
-    std::string Player::getLastAction() const { return this->last_action; }
-    Player *Player::getLastArrestedTarget() const { return this->_last_arrested_target; }
-    Player *Player::getAggressorInLastCoup() const { return this->_aggressor_in_last_coup; }
-    void Player::addCoins(int amount) { this->_coins += amount; }
-    void Player::removeCoins(int amount) { this->_coins = std::max(0, this->_coins - amount); }
-    void Player::eliminate() { this->is_active = false; }
+    bool Player::isSanctioned() const { return this->_is_sanctioned; }
+    bool Player::hasExtraAction() const { return this->_has_extra_action; }
+    std::string Player::getLastAction() const
+    {
+        COUP_TRACK_ALLOCATIONS(LastActionName);
+        return to_string(this->last_action);
+    }
+    Player *Player::getLastArrestedTarget() const
+    {
+        return this->_last_arrested_seat == NO_TARGET ? nullptr : this->game.get_players()[this->_last_arrested_seat];
+    }
+    Player *Player::getAggressorInLastCoup() const
+    {
+        return this->_aggressor_seat == NO_TARGET ? nullptr : this->game.get_players()[this->_aggressor_seat];
+    }
+    size_t Player::seat() const { return this->_seat; }
+    void Player::addCoins(int amount) { setCoins(this->_coins + amount); }
+    void Player::removeCoins(int amount) { setCoins(std::max(0, this->_coins - amount)); }
+    void Player::eliminate()
+    {
+        this->game.toggle_hash(zobrist_delta(ZobristFeature::Active, this->_seat, this->is_active, false));
+        this->is_active = false;
+        this->game.set_active(this->_seat, false);
+    }
     void Player::revive()
     {
+        this->game.toggle_hash(zobrist_delta(ZobristFeature::Active, this->_seat, this->is_active, true));
         this->is_active = true;
-        this->_aggressor_in_last_coup = nullptr;
+        this->game.set_active(this->_seat, true);
+        this->_aggressor_seat = NO_TARGET;
+    }
+    void Player::setSanctioned(bool status)
+    {
+        this->game.toggle_hash(zobrist_delta(ZobristFeature::Sanctioned, this->_seat, this->_is_sanctioned, status));
+        this->_is_sanctioned = status;
     }
-    void Player::setSanctioned(bool status) { this->_is_sanctioned = status; }
 
-    void Player::undo(Player &target)
+    void Player::setCoins(int coins)
+    {
+        this->game.toggle_hash(zobrist_delta(ZobristFeature::Coins, this->_seat, this->_coins, coins));
+        if (coins != this->_coins && this->game.hidden_coins())
+        {
+            this->game.conceal_coins(this->_seat);
+        }
+        this->_coins = coins;
+    }
+
+    void Player::setLastAction(ActionType action)
+    {
+        this->game.toggle_hash(zobrist_delta(ZobristFeature::LastAction, this->_seat,
+                                             static_cast<int>(this->last_action), static_cast<int>(action)));
+        this->last_action = action;
+    }
+
+    void Player::setExtraAction(bool status)
+    {
+        this->game.toggle_hash(zobrist_delta(ZobristFeature::ExtraAction, this->_seat, this->_has_extra_action, status));
+        this->_has_extra_action = status;
+    }
+
+    void Player::setLastArrestedTarget(Player *target)
+    {
+        const std::int16_t seat = target == nullptr ? NO_TARGET : static_cast<std::int16_t>(target->_seat);
+        this->game.toggle_hash(zobrist_delta(ZobristFeature::LastArrested, this->_seat, this->_last_arrested_seat + 1, seat + 1));
+        this->_last_arrested_seat = seat;
+    }
+
+    ActionResult Player::try_undo(Player &target)
     {
+        COUP_RECORD_UNDO_LATENCY(this->_role);
+        COUP_TRACK_ALLOCATIONS(Undo);
+        COUP_TRACE_SPAN("Player::try_undo");
         (void)target;
-        throw std::runtime_error("This player (" + this->role() + ") cannot undo actions.");
+        return ActionResult::CannotUndo;
     }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,85 @@
+//talgov44@gmail.com
+
+#include "PlayerArena.hpp"
+#include "Baron.hpp"
+#include "Game.hpp"
+#include "General.hpp"
+#include "Governor.hpp"
+#include "Judge.hpp"
+#include "Merchant.hpp"
+#include "Spy.hpp"
+#include <new>
+#include <stdexcept>
+
+namespace coup
+{
+    static_assert(sizeof(Governor) == sizeof(Player) && sizeof(Spy) == sizeof(Player) &&
+                      sizeof(Baron) == sizeof(Player) && sizeof(General) == sizeof(Player) &&
+                      sizeof(Judge) == sizeof(Player) && sizeof(Merchant) == sizeof(Player),
+                  "Every role must fit a Player-sized arena slot");
+
+    PlayerArena::PlayerArena() : _capacity(0), _count(0) {}
+
+    PlayerArena::~PlayerArena()
+    {
+        clear();
+    }
+
+    /**
+     * @brief Constructs a player in the next slot and adds it to `game`.
+     *
+     * An empty arena first makes room for every seat of `game`.
+     *
+     * @throws std::runtime_error If the arena is full, or the game refuses the
+     *                            player (see Game::add_player()).
+     */
+    Player &PlayerArena::create(Game &game, Role role, const std::string &name)
+    {
+        if (_count == 0 && _capacity < game.max_players())
+        {
+            this->_slots.reset(new Slot[game.max_players()]);
+            this->_players.reset(new Player *[game.max_players()]);
+            this->_capacity = game.max_players();
+        }
+        if (_count == _capacity)
+        {
+            throw std::runtime_error("Player arena is full.");
+        }
+        void *slot = &_slots[_count];
+        Player *player = nullptr;
+        switch (role)
+        {
+        case Role::Governor:
+            player = new (slot) Governor(game, name);
+            break;
+        case Role::Spy:
+            player = new (slot) Spy(game, name);
+            break;
+        case Role::Baron:
+            player = new (slot) Baron(game, name);
+            break;
+        case Role::General:
+            player = new (slot) General(game, name);
+            break;
+        case Role::Judge:
+            player = new (slot) Judge(game, name);
+            break;
+        case Role::Merchant:
+            player = new (slot) Merchant(game, name);
+            break;
+        case Role::Player:
+            player = new (slot) Player(game, name);
+            break;
+        }
+        _players[_count++] = player;
+        return *player;
+    }
+
+    void PlayerArena::clear()
+    {
+        while (_count > 0)
+        {
+            _players[--_count]->~Player();
+        }
+    }
+}
@@ -0,0 +1,56 @@
+//talgov44@gmail.com
+
+#include "Role.hpp"
+#include "Baron.hpp"
+#include "General.hpp"
+#include "Governor.hpp"
+#include "Judge.hpp"
+#include "Merchant.hpp"
+#include "Spy.hpp"
+
+namespace coup
+{
+    const char *to_string(Role role)
+    {
+        switch (role)
+        {
+        case Role::Governor:
+            return "Governor";
+        case Role::Spy:
+            return "Spy";
+        case Role::Baron:
+            return "Baron";
+        case Role::General:
+            return "General";
+        case Role::Judge:
+            return "Judge";
+        case Role::Merchant:
+            return "Merchant";
+        case Role::Player:
+            break;
+        }
+        return "player";
+    }
+
+    std::unique_ptr<Player> make_player(Game &game, Role role, const std::string &name)
+    {
+        switch (role)
+        {
+        case Role::Governor:
+            return std::make_unique<Governor>(game, name);
+        case Role::Spy:
+            return std::make_unique<Spy>(game, name);
+        case Role::Baron:
+            return std::make_unique<Baron>(game, name);
+        case Role::General:
+            return std::make_unique<General>(game, name);
+        case Role::Judge:
+            return std::make_unique<Judge>(game, name);
+        case Role::Merchant:
+            return std::make_unique<Merchant>(game, name);
+        case Role::Player:
+            break;
+        }
+        return std::make_unique<Player>(game, name);
+    }
+}
@@ -0,0 +1,621 @@
+//talgov44@gmail.com
+
+#include "Rules.hpp"
+#include "Constants.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace coup
+{
+    namespace
+    {
+        void add_coins(PlayerState &player, int amount)
+        {
+            player.coins = static_cast<std::uint8_t>(player.coins + amount);
+        }
+
+        // Player::removeCoins(): never goes below zero.
+        void remove_coins(PlayerState &player, int amount)
+        {
+            player.coins = static_cast<std::uint8_t>(std::max(0, player.coins - amount));
+        }
+
+        bool valid_target(const GameState &state, size_t seat, int target)
+        {
+            return target >= 0 && static_cast<size_t>(target) < state.player_count &&
+                   static_cast<size_t>(target) != seat && state.players[target].has(PlayerState::ACTIVE);
+        }
+
+        // Game::next_turn()
+        void next_turn(GameState &state)
+        {
+            state.flags |= GameState::STARTED;
+            if (state.active_count() < 2)
+            {
+                return;
+            }
+            do
+            {
+                state.turn = static_cast<std::uint8_t>((state.turn + 1) % state.player_count);
+            } while (!state.players[state.turn].has(PlayerState::ACTIVE));
+
+            PlayerState &next = state.players[state.turn];
+            if (next.role == Role::Merchant && next.coins >= MERCHANT_BONUS_THRESHOLD)
+            {
+                add_coins(next, 1);
+            }
+        }
+
+        // Player::end_turn_or_continue()
+        void end_turn_or_continue(GameState &state, PlayerState &player)
+        {
+            if (player.has(PlayerState::EXTRA_ACTION))
+            {
+                player.set(PlayerState::EXTRA_ACTION, false);
+            }
+            else
+            {
+                next_turn(state);
+            }
+        }
+
+        // Game::try_current_player() followed by the checks of Player::check_turn()
+        // and, unless it is a coup, Player::must_coup().
+        ActionResult check_turn(GameState &state, size_t seat, bool coup)
+        {
+            if (!state.players[seat].has(PlayerState::ACTIVE))
+            {
+                return ActionResult::PlayerNotActive;
+            }
+            const bool started = (state.flags & GameState::STARTED) != 0;
+            if (state.player_count == 0)
+            {
+                return ActionResult::NoPlayers;
+            }
+            if (state.active_count() < 2 && started)
+            {
+                return ActionResult::GameOver;
+            }
+            if (!started && state.player_count < 2)
+            {
+                return ActionResult::NotEnoughPlayers;
+            }
+            state.turn = static_cast<std::uint8_t>(current_seat(state));
+            if (!started)
+            {
+                PlayerState &first = state.players[state.turn];
+                if (first.role == Role::Merchant && first.coins >= MERCHANT_BONUS_THRESHOLD)
+                {
+                    add_coins(first, 1);
+                }
+            }
+            state.flags |= GameState::STARTED;
+            if (state.turn != seat)
+            {
+                return ActionResult::NotYourTurn;
+            }
+            if (!coup && state.players[seat].coins >= MUST_COUP_COINS)
+            {
+                return ActionResult::MustCoup;
+            }
+            return ActionResult::Ok;
+        }
+
+        // Player::try_gather(), Player::try_tax(), Governor::try_tax() and Baron::try_invest()
+        ActionResult income(GameState &state, size_t seat, ActionType type)
+        {
+            PlayerState &self = state.players[seat];
+            if (type == ActionType::Invest)
+            {
+                if (self.role != Role::Baron)
+                {
+                    return ActionResult::InvalidTarget;
+                }
+            }
+            ActionResult result = check_turn(state, seat, false);
+            if (result != ActionResult::Ok)
+            {
+                return result;
+            }
+            if (type == ActionType::Invest)
+            {
+                if (!self.has(PlayerState::SANCTIONED) && self.coins < INVEST_COST)
+                {
+                    return ActionResult::NotEnoughCoins;
+                }
+                state.save_target = NO_TARGET;
+            }
+            if (self.has(PlayerState::SANCTIONED))
+            {
+                self.set(PlayerState::SANCTIONED, false);
+                end_turn_or_continue(state, self);
+                return ActionResult::Sanctioned;
+            }
+            switch (type)
+            {
+            case ActionType::Gather:
+                add_coins(self, 1);
+                break;
+            case ActionType::Tax:
+                add_coins(self, self.role == Role::Governor ? GOVERNOR_TAX_AMOUNT : TAX_AMOUNT);
+                break;
+            default:
+                remove_coins(self, INVEST_COST);
+                add_coins(self, INVEST_RETURN);
+                break;
+            }
+            self.last_action = type;
+            end_turn_or_continue(state, self);
+            return ActionResult::Ok;
+        }
+
+        ActionResult bribe(GameState &state, size_t seat)
+        {
+            ActionResult result = check_turn(state, seat, false);
+            if (result != ActionResult::Ok)
+            {
+                return result;
+            }
+            PlayerState &self = state.players[seat];
+            if (self.coins < BRIBE_COST)
+            {
+                return ActionResult::NotEnoughCoins;
+            }
+            self.set(PlayerState::SANCTIONED, false);
+            remove_coins(self, BRIBE_COST);
+            self.set(PlayerState::EXTRA_ACTION, true);
+            self.last_action = ActionType::Bribe;
+            return ActionResult::Ok;
+        }
+
+        ActionResult arrest(GameState &state, size_t seat, int target)
+        {
+            ActionResult result = check_turn(state, seat, false);
+            if (result != ActionResult::Ok)
+            {
+                return result;
+            }
+            PlayerState &self = state.players[seat];
+            if (!valid_target(state, seat, target))
+            {
+                return ActionResult::InvalidTarget;
+            }
+            if (target == self.last_arrested)
+            {
+                return ActionResult::RepeatArrest;
+            }
+            PlayerState &victim = state.players[target];
+            if (victim.coins < (victim.role == Role::Merchant ? MERCHANT_ARREST_PENALTY : 1))
+            {
+                return ActionResult::TargetCannotPay;
+            }
+            state.save_target = NO_TARGET;
+            self.set(PlayerState::SANCTIONED, false);
+            if (victim.role == Role::Merchant)
+            {
+                remove_coins(victim, MERCHANT_ARREST_PENALTY);
+            }
+            else
+            {
+                remove_coins(victim, 1);
+                add_coins(self, 1);
+                if (victim.role == Role::General)
+                {
+                    add_coins(victim, 1);
+                }
+            }
+            self.last_arrested = static_cast<std::int8_t>(target);
+            self.last_action = ActionType::Arrest;
+            end_turn_or_continue(state, self);
+            return ActionResult::Ok;
+        }
+
+        ActionResult sanction(GameState &state, size_t seat, int target)
+        {
+            ActionResult result = check_turn(state, seat, false);
+            if (result != ActionResult::Ok)
+            {
+                return result;
+            }
+            PlayerState &self = state.players[seat];
+            if (self.coins < SANCTION_COST)
+            {
+                return ActionResult::NotEnoughCoins;
+            }
+            if (!valid_target(state, seat, target))
+            {
+                return ActionResult::InvalidTarget;
+            }
+            self.set(PlayerState::SANCTIONED, false);
+            PlayerState &victim = state.players[target];
+            remove_coins(self, SANCTION_COST);
+            if (victim.role == Role::Judge)
+            {
+                remove_coins(self, JUDGE_SANCTION_PENALTY);
+            }
+            if (victim.role == Role::Baron)
+            {
+                add_coins(victim, BARON_SANCTION_COMPENSATION);
+            }
+            victim.set(PlayerState::SANCTIONED, true);
+            self.last_action = ActionType::Sanction;
+            end_turn_or_continue(state, self);
+            return ActionResult::Ok;
+        }
+
+        ActionResult coup(GameState &state, size_t seat, int target)
+        {
+            ActionResult result = check_turn(state, seat, true);
+            if (result != ActionResult::Ok)
+            {
+                return result;
+            }
+            PlayerState &self = state.players[seat];
+            if (self.coins < COUP_COST)
+            {
+                return ActionResult::NotEnoughCoins;
+            }
+            if (!valid_target(state, seat, target))
+            {
+                return ActionResult::InvalidTarget;
+            }
+            self.set(PlayerState::SANCTIONED, false);
+            remove_coins(self, COUP_COST);
+            state.players[target].set(PlayerState::ACTIVE, false);
+            state.save_target = static_cast<std::int8_t>(target);
+            self.last_action = ActionType::Coup;
+            end_turn_or_continue(state, self);
+            return ActionResult::Ok;
+        }
+
+        // The try_undo() override of the role in `seat`.
+        ActionResult undo(GameState &state, size_t seat, int target)
+        {
+            if (target < 0 || static_cast<size_t>(target) >= state.player_count)
+            {
+                return ActionResult::InvalidTarget;
+            }
+            PlayerState &self = state.players[seat];
+            PlayerState &other = state.players[target];
+            switch (self.role)
+            {
+            case Role::Governor:
+                if (!other.has(PlayerState::ACTIVE) || static_cast<size_t>(target) == seat)
+                {
+                    return ActionResult::InvalidTarget;
+                }
+                if (other.last_action != ActionType::Tax)
+                {
+                    return ActionResult::NothingToUndo;
+                }
+                remove_coins(other, TAX_AMOUNT);
+                return ActionResult::Ok;
+            case Role::Judge:
+                if (other.last_action != ActionType::Bribe)
+                {
+                    return ActionResult::NothingToUndo;
+                }
+                other.set(PlayerState::EXTRA_ACTION, false);
+                return ActionResult::Ok;
+            case Role::Spy:
+                if (other.last_action != ActionType::Arrest || other.last_arrested == NO_TARGET)
+                {
+                    return ActionResult::NothingToUndo;
+                }
+                if (state.players[other.last_arrested].role == Role::Merchant)
+                {
+                    add_coins(state.players[other.last_arrested], MERCHANT_ARREST_PENALTY);
+                }
+                else
+                {
+                    remove_coins(other, 1);
+                    add_coins(state.players[other.last_arrested], 1);
+                }
+                return ActionResult::Ok;
+            case Role::General:
+                if (self.coins < GENERAL_UNDO_COST)
+                {
+                    return ActionResult::NotEnoughCoins;
+                }
+                if (other.has(PlayerState::ACTIVE))
+                {
+                    return ActionResult::NothingToUndo;
+                }
+                if (target != state.save_target)
+                {
+                    return ActionResult::UndoWindowClosed;
+                }
+                remove_coins(self, GENERAL_UNDO_COST);
+                other.set(PlayerState::ACTIVE, true);
+                state.save_target = NO_TARGET;
+                return ActionResult::Ok;
+            default:
+                return ActionResult::CannotUndo;
+            }
+        }
+
+        // Undo window of Game::legal_actions(): whether the player in `seat` may
+        // undo against the player in `other_seat`.
+        bool can_undo(const GameState &state, size_t seat, size_t other_seat)
+        {
+            const PlayerState &self = state.players[seat];
+            const PlayerState &other = state.players[other_seat];
+            switch (self.role)
+            {
+            case Role::Governor:
+                return other_seat != seat && other.has(PlayerState::ACTIVE) && other.last_action == ActionType::Tax;
+            case Role::Judge:
+                return other.last_action == ActionType::Bribe;
+            case Role::Spy:
+                return other.last_action == ActionType::Arrest && other.last_arrested != NO_TARGET;
+            case Role::General:
+                return static_cast<int>(other_seat) == state.save_target && !other.has(PlayerState::ACTIVE) &&
+                       self.coins >= GENERAL_UNDO_COST;
+            default:
+                return false;
+            }
+        }
+
+        // Seat whose action `reactor` would undo in the simulator's reaction phase,
+        // or NO_TARGET. Mirrors undo_target() in Simulator.cpp.
+        int reaction_target(const GameState &state, size_t reactor, size_t actor, ActionType performed)
+        {
+            int target = static_cast<int>(actor);
+            switch (state.players[reactor].role)
+            {
+            case Role::Governor:
+                if (performed != ActionType::Tax)
+                {
+                    return NO_TARGET;
+                }
+                break;
+            case Role::Judge:
+                if (performed != ActionType::Bribe)
+                {
+                    return NO_TARGET;
+                }
+                break;
+            case Role::Spy:
+                if (performed != ActionType::Arrest)
+                {
+                    return NO_TARGET;
+                }
+                break;
+            case Role::General:
+                if (performed != ActionType::Coup || state.save_target == NO_TARGET)
+                {
+                    return NO_TARGET;
+                }
+                target = state.save_target;
+                break;
+            default:
+                return NO_TARGET;
+            }
+            return can_undo(state, reactor, static_cast<size_t>(target)) ? target : NO_TARGET;
+        }
+    }
+
+    size_t current_seat(const GameState &state)
+    {
+        size_t seat = state.turn;
+        for (size_t i = 0; i < state.player_count && !state.players[seat].has(PlayerState::ACTIVE); ++i)
+        {
+            seat = (seat + 1) % state.player_count;
+        }
+        return seat;
+    }
+
+    LegalActions legal_actions(const GameState &state, size_t seat)
+    {
+        LegalActions legal;
+        const PlayerState &self = state.players[seat];
+        for (size_t i = 0; i < state.player_count; ++i)
+        {
+            if (can_undo(state, seat, i))
+            {
+                legal.allow(ActionType::Undo, i);
+            }
+        }
+        if (!self.has(PlayerState::ACTIVE))
+        {
+            return legal;
+        }
+
+        const bool started = (state.flags & GameState::STARTED) != 0;
+        if (state.player_count < 2 || (started && state.active_count() < 2) || current_seat(state) != seat)
+        {
+            return legal;
+        }
+
+        int coins = self.coins;
+        if (!started && self.role == Role::Merchant && coins >= MERCHANT_BONUS_THRESHOLD)
+        {
+            coins += 1;
+        }
+        const bool must_coup = coins >= MUST_COUP_COINS;
+        if (!must_coup)
+        {
+            legal.allow(ActionType::Gather);
+            legal.allow(ActionType::Tax);
+            if (coins >= BRIBE_COST)
+            {
+                legal.allow(ActionType::Bribe);
+            }
+            if (self.role == Role::Baron && coins >= INVEST_COST)
+            {
+                legal.allow(ActionType::Invest);
+            }
+        }
+        for (size_t i = 0; i < state.player_count; ++i)
+        {
+            const PlayerState &target = state.players[i];
+            if (i == seat || !target.has(PlayerState::ACTIVE))
+            {
+                continue;
+            }
+            if (coins >= COUP_COST)
+            {
+                legal.allow(ActionType::Coup, i);
+            }
+            if (must_coup)
+            {
+                continue;
+            }
+            const int arrest_min = target.role == Role::Merchant ? MERCHANT_ARREST_PENALTY : 1;
+            if (static_cast<int>(i) != self.last_arrested && target.coins >= arrest_min)
+            {
+                legal.allow(ActionType::Arrest, i);
+            }
+            if (coins >= SANCTION_COST)
+            {
+                legal.allow(ActionType::Sanction, i);
+            }
+        }
+        return legal;
+    }
+
+    ActionResult apply_action(GameState &state, size_t seat, const Action &action)
+    {
+        if (seat >= state.player_count)
+        {
+            throw std::runtime_error("No player in this seat.");
+        }
+        switch (action.type)
+        {
+        case ActionType::Gather:
+        case ActionType::Tax:
+        case ActionType::Invest:
+            return income(state, seat, action.type);
+        case ActionType::Bribe:
+            return bribe(state, seat);
+        case ActionType::Arrest:
+            return arrest(state, seat, action.target);
+        case ActionType::Sanction:
+            return sanction(state, seat, action.target);
+        case ActionType::Coup:
+            return coup(state, seat, action.target);
+        case ActionType::Undo:
+            return undo(state, seat, action.target);
+        case ActionType::None:
+            break;
+        }
+        throw std::runtime_error("Unknown action.");
+    }
+
+    Position Position::turn(const GameState &state)
+    {
+        Position position;
+        position.state = state;
+        position.phase = TURN;
+        position.seat = static_cast<std::uint8_t>(current_seat(state));
+        position.actor = position.seat;
+        position.performed = ActionType::None;
+        position.undo_target = NO_TARGET;
+        return position;
+    }
+
+    Position Position::reaction(const GameState &state, size_t actor, ActionType performed, size_t reactor)
+    {
+        Position position;
+        position.state = state;
+        position.actor = static_cast<std::uint8_t>(actor);
+        position.performed = performed;
+        position.advance_reaction(reactor);
+        return position;
+    }
+
+    int Position::winner() const
+    {
+        if (!terminal())
+        {
+            return -1;
+        }
+        for (size_t i = 0; i < state.player_count; ++i)
+        {
+            if (state.players[i].has(PlayerState::ACTIVE))
+            {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Finds the first seat from `from` onward that can undo the pending action,
+    // or starts the next turn if there is none.
+    void Position::advance_reaction(size_t from)
+    {
+        for (size_t r = from; r < state.player_count; ++r)
+        {
+            if (r == actor || !state.players[r].has(PlayerState::ACTIVE))
+            {
+                continue;
+            }
+            const int target = reaction_target(state, r, actor, performed);
+            if (target != NO_TARGET)
+            {
+                phase = REACTION;
+                seat = static_cast<std::uint8_t>(r);
+                undo_target = static_cast<std::int8_t>(target);
+                return;
+            }
+        }
+        phase = TURN;
+        seat = static_cast<std::uint8_t>(current_seat(state));
+        performed = ActionType::None;
+        undo_target = NO_TARGET;
+    }
+
+    size_t Position::actions(Action *out, size_t capacity) const
+    {
+        if (terminal() || capacity == 0)
+        {
+            return 0;
+        }
+        if (phase == REACTION)
+        {
+            out[0] = {ActionType::Undo, undo_target};
+            if (capacity < 2)
+            {
+                return 1;
+            }
+            out[1] = {ActionType::None, NO_TARGET};
+            return 2;
+        }
+        LegalActions legal = legal_actions(state, seat);
+        legal.forbid(ActionType::Undo);
+        return legal.expand(out, capacity);
+    }
+
+    /**
+     * @brief Plays one decision and moves to the next one.
+     *
+     * A successful turn action opens the reaction phase; a forfeited one
+     * (Sanctioned) goes straight to the next turn, as in the simulator.
+     *
+     * @throws std::runtime_error If the action is refused for any other reason.
+     */
+    void Position::play(const Action &action)
+    {
+        if (phase == REACTION)
+        {
+            if (action.type == ActionType::Undo)
+            {
+                throw_if_failed(apply_action(state, seat, action));
+            }
+            advance_reaction(seat + 1);
+            return;
+        }
+
+        const size_t mover = seat;
+        const ActionResult result = apply_action(state, mover, action);
+        if (result == ActionResult::Sanctioned)
+        {
+            seat = static_cast<std::uint8_t>(current_seat(state));
+            return;
+        }
+        throw_if_failed(result);
+        actor = static_cast<std::uint8_t>(mover);
+        performed = action.type;
+        advance_reaction(0);
+    }
+}
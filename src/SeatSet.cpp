@@ -0,0 +1,87 @@
+//talgov44@gmail.com
+
+#include "SeatSet.hpp"
+#include <algorithm>
+
+namespace coup
+{
+    const size_t SeatSet::NONE;
+
+    SeatSet::SeatSet(size_t capacity) : _words((capacity + 63) / 64, 0),
+                                        _summary((capacity + 4095) / 4096, 0),
+                                        _capacity(capacity),
+                                        _count(0)
+    {
+    }
+
+    void SeatSet::insert(size_t seat)
+    {
+        std::uint64_t &word = _words[seat >> 6];
+        const std::uint64_t bit = std::uint64_t(1) << (seat & 63);
+        if ((word & bit) == 0)
+        {
+            word |= bit;
+            _summary[seat >> 12] |= std::uint64_t(1) << ((seat >> 6) & 63);
+            ++_count;
+        }
+    }
+
+    void SeatSet::erase(size_t seat)
+    {
+        std::uint64_t &word = _words[seat >> 6];
+        const std::uint64_t bit = std::uint64_t(1) << (seat & 63);
+        if ((word & bit) != 0)
+        {
+            word &= ~bit;
+            if (word == 0)
+            {
+                _summary[seat >> 12] &= ~(std::uint64_t(1) << ((seat >> 6) & 63));
+            }
+            --_count;
+        }
+    }
+
+    void SeatSet::clear()
+    {
+        std::fill(_words.begin(), _words.end(), 0);
+        std::fill(_summary.begin(), _summary.end(), 0);
+        this->_count = 0;
+    }
+
+    size_t SeatSet::find(size_t seat) const
+    {
+        if (seat >= _capacity)
+        {
+            return NONE;
+        }
+        const size_t w = seat >> 6;
+        const std::uint64_t here = _words[w] & (~std::uint64_t(0) << (seat & 63));
+        if (here != 0)
+        {
+            return (w << 6) + static_cast<size_t>(__builtin_ctzll(here));
+        }
+
+        // Next non-empty word after w, from the summary.
+        const size_t next = w + 1;
+        for (size_t s = next >> 6; s < _summary.size(); ++s)
+        {
+            std::uint64_t words = _summary[s];
+            if (s == next >> 6)
+            {
+                words &= ~std::uint64_t(0) << (next & 63);
+            }
+            if (words != 0)
+            {
+                const size_t found = (s << 6) + static_cast<size_t>(__builtin_ctzll(words));
+                return (found << 6) + static_cast<size_t>(__builtin_ctzll(_words[found]));
+            }
+        }
+        return NONE;
+    }
+
+    size_t SeatSet::find_circular(size_t seat) const
+    {
+        const size_t found = find(seat);
+        return found != NONE ? found : find(0);
+    }
+}
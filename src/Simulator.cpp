@@ -0,0 +1,431 @@
+//talgov44@gmail.com
+
+#include "Simulator.hpp"
+#include "Baron.hpp"
+#include "GameLog.hpp"
+#include "GameState.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace coup
+{
+    namespace
+    {
+        // Performs an action that Game::legal_actions() reported as legal. The only
+        // refusal expected here is Sanctioned, which forfeits the turn.
+        ActionResult perform(Player &self, const std::vector<Player *> &players, const Action &action)
+        {
+            switch (action.type)
+            {
+            case ActionType::Gather:
+                return self.try_gather();
+            case ActionType::Tax:
+                return self.try_tax();
+            case ActionType::Bribe:
+                return self.try_bribe();
+            case ActionType::Invest:
+                return static_cast<Baron &>(self).try_invest();
+            case ActionType::Arrest:
+                return self.try_arrest(*players.at(action.target));
+            case ActionType::Sanction:
+                return self.try_sanction(*players.at(action.target));
+            case ActionType::Coup:
+                return self.try_coup(*players.at(action.target));
+            default:
+                throw std::runtime_error("Simulator cannot perform this action.");
+            }
+        }
+
+        // Returns the player whose just-performed action the reactor is able to undo,
+        // or nullptr if it has no undo available against that action.
+        Player *undo_target(const Game &game, const Player &reactor, Player &actor, ActionType performed)
+        {
+            Player *target = &actor;
+            switch (reactor.roleType())
+            {
+            case Role::Governor:
+                if (performed != ActionType::Tax)
+                {
+                    return nullptr;
+                }
+                break;
+            case Role::Judge:
+                if (performed != ActionType::Bribe)
+                {
+                    return nullptr;
+                }
+                break;
+            case Role::Spy:
+                if (performed != ActionType::Arrest)
+                {
+                    return nullptr;
+                }
+                break;
+            case Role::General:
+                if (performed != ActionType::Coup || game.getPlayerToSave() == nullptr)
+                {
+                    return nullptr;
+                }
+                target = game.getPlayerToSave();
+                break;
+            default:
+                return nullptr;
+            }
+            return game.is_legal(reactor, {ActionType::Undo, static_cast<int>(target->seat())}) ? target : nullptr;
+        }
+
+        // The action a role's undo cancels, or None for roles without an undo.
+        ActionType undoable_action(Role role)
+        {
+            switch (role)
+            {
+            case Role::Governor:
+                return ActionType::Tax;
+            case Role::Judge:
+                return ActionType::Bribe;
+            case Role::Spy:
+                return ActionType::Arrest;
+            case Role::General:
+                return ActionType::Coup;
+            default:
+                return ActionType::None;
+            }
+        }
+
+        /**
+         * @brief Turn actions offered at tables too large to list every target.
+         *
+         * Every legal untargeted action, plus arrest, sanction and coup against
+         * up to SAMPLED_TARGETS distinct active opponents drawn from `rng`. A
+         * seat is drawn by picking a random seat and taking the next active one,
+         * which favours seats right after eliminated stretches but costs the
+         * same at any table size. Each candidate is checked with Game::is_legal().
+         */
+        size_t sample_actions(const Game &game, const Player &self, CounterRng &rng, Action *out)
+        {
+            size_t count = 0;
+            const ActionType untargeted[] = {ActionType::Gather, ActionType::Tax, ActionType::Bribe, ActionType::Invest};
+            for (ActionType type : untargeted)
+            {
+                if (game.is_legal(self, {type, NO_TARGET}))
+                {
+                    out[count++] = {type, NO_TARGET};
+                }
+            }
+
+            const SeatSet &active = game.active_seats();
+            const size_t seats = game.get_players().size();
+            size_t drawn[SAMPLED_TARGETS];
+            size_t distinct = 0;
+            for (size_t k = 0; k < SAMPLED_TARGETS && distinct + 1 < active.size(); ++k)
+            {
+                size_t seat = active.find_circular(rng.uniform(static_cast<std::uint32_t>(seats)));
+                if (seat == self.seat())
+                {
+                    seat = active.find_circular((seat + 1) % seats);
+                }
+                if (std::find(drawn, drawn + distinct, seat) == drawn + distinct)
+                {
+                    drawn[distinct++] = seat;
+                }
+            }
+            const ActionType targeted[] = {ActionType::Arrest, ActionType::Sanction, ActionType::Coup};
+            for (ActionType type : targeted)
+            {
+                for (size_t i = 0; i < distinct; ++i)
+                {
+                    const Action action{type, static_cast<int>(drawn[i])};
+                    if (game.is_legal(self, action))
+                    {
+                        out[count++] = action;
+                    }
+                }
+            }
+            return count;
+        }
+    }
+
+    bool Policy::react(const Game &game, const Player &self, const Player &actor, CounterRng &rng)
+    {
+        (void)game;
+        (void)self;
+        (void)actor;
+        (void)rng;
+        return false;
+    }
+
+    RandomPolicy::RandomPolicy(double react_probability) : _react_probability(react_probability) {}
+
+    Action RandomPolicy::choose(const Game &game, const Player &self,
+                                const Action *legal, size_t count, CounterRng &rng)
+    {
+        (void)game;
+        (void)self;
+        return legal[rng.uniform(static_cast<std::uint32_t>(count))];
+    }
+
+    bool RandomPolicy::react(const Game &game, const Player &self, const Player &actor, CounterRng &rng)
+    {
+        (void)game;
+        (void)self;
+        (void)actor;
+        return rng.bernoulli(_react_probability);
+    }
+
+    Action GreedyPolicy::choose(const Game &game, const Player &self,
+                                const Action *legal, size_t count, CounterRng &rng)
+    {
+        (void)self;
+        (void)rng;
+        const std::vector<Player *> &players = game.get_players();
+        const Action *best = &legal[0];
+        int best_score = -1;
+        for (size_t i = 0; i < count; ++i)
+        {
+            int score = 0;
+            switch (legal[i].type)
+            {
+            case ActionType::Coup:
+                score = 100 + players.at(legal[i].target)->coins();
+                break;
+            case ActionType::Invest:
+                score = 30;
+                break;
+            case ActionType::Tax:
+                score = 20;
+                break;
+            case ActionType::Gather:
+                score = 10;
+                break;
+            default:
+                break;
+            }
+            if (score > best_score)
+            {
+                best_score = score;
+                best = &legal[i];
+            }
+        }
+        return *best;
+    }
+
+    bool GreedyPolicy::react(const Game &game, const Player &self, const Player &actor, CounterRng &rng)
+    {
+        (void)game;
+        (void)self;
+        (void)actor;
+        (void)rng;
+        return true;
+    }
+
+    double SimulationStats::games_per_second() const
+    {
+        return this->seconds > 0.0 ? static_cast<double>(this->games) / this->seconds : 0.0;
+    }
+
+    double SimulationStats::actions_per_second() const
+    {
+        return this->seconds > 0.0 ? static_cast<double>(this->actions) / this->seconds : 0.0;
+    }
+
+    Simulator::Simulator(const SimulationConfig &config, const std::vector<Policy *> &policies)
+    {
+        this->configure(config, policies);
+    }
+
+    /**
+     * @throws std::runtime_error If the lineup has fewer than 2 seats or the
+     *                            policies do not match it one to one.
+     */
+    void Simulator::configure(const SimulationConfig &config, const std::vector<Policy *> &policies)
+    {
+        if (config.lineup.size() < 2)
+        {
+            throw std::runtime_error("Simulation needs at least 2 players.");
+        }
+        if (policies.size() != config.lineup.size())
+        {
+            throw std::runtime_error("Simulation needs exactly one policy per seat.");
+        }
+        _config = config;
+        _policies = policies;
+        for (SeatSet &reactors : _reactors)
+        {
+            reactors = SeatSet(_config.lineup.size());
+        }
+        for (size_t seat = 0; seat < _config.lineup.size(); ++seat)
+        {
+            const ActionType undoes = undoable_action(_config.lineup[seat]);
+            if (undoes != ActionType::None)
+            {
+                _reactors[static_cast<size_t>(undoes)].insert(seat);
+            }
+        }
+    }
+
+    // Adds or removes a player who was revived or eliminated in the current
+    // game from the reactors of its role.
+    void Simulator::set_live_reactor(const Player &player, bool live)
+    {
+        const ActionType undoes = undoable_action(player.roleType());
+        if (undoes == ActionType::None)
+        {
+            return;
+        }
+        SeatSet &reactors = _live_reactors[static_cast<size_t>(undoes)];
+        if (live)
+        {
+            reactors.insert(player.seat());
+        }
+        else
+        {
+            reactors.erase(player.seat());
+        }
+    }
+
+    /**
+     * @brief Plays the configured number of games and reports throughput.
+     *
+     * Games are numbered 0..games-1 and every decision draws from a stream
+     * keyed by (seed, game, turn), so any single game of a run can be replayed
+     * on its own with play_one().
+     */
+    SimulationStats Simulator::run()
+    {
+        SimulationStats stats;
+        stats.wins_by_seat.assign(_config.lineup.size(), 0);
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t g = 0; g < _config.games; ++g)
+        {
+            play_one(g, stats);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        stats.seconds = std::chrono::duration<double>(stop - start).count();
+        return stats;
+    }
+
+    /**
+     * @brief Plays one game to completion and records it in the stats.
+     *
+     * @param game_id Selects the game's random streams together with the seed.
+     * @return int The winning seat, or -1 if the game hit the action limit.
+     */
+    int Simulator::play_one(std::uint64_t game_id, SimulationStats &stats)
+    {
+        std::unique_ptr<PooledGame> table = _pool.acquire(_config.lineup);
+        Game &game = table->game;
+        const std::vector<Player *> &players = game.get_players();
+        game.set_hidden_coins(_config.hidden_coins);
+        if (stats.wins_by_seat.size() < players.size())
+        {
+            stats.wins_by_seat.resize(players.size(), 0);
+        }
+
+        if (_config.log != nullptr)
+        {
+            _config.log->begin(game);
+        }
+        for (size_t t = 0; t < ACTION_TYPE_COUNT; ++t)
+        {
+            _live_reactors[t] = _reactors[t];
+        }
+        const bool sampled = players.size() > GameState::MAX_PLAYERS;
+
+        if (_config.perf_counters && !_perf)
+        {
+            this->_perf.reset(new PerfCounters());
+        }
+        const PerfCounters *perf = _perf && _perf->available() ? _perf.get() : nullptr;
+
+        Action legal[MAX_ACTIONS];
+        size_t actions = 0;
+        while (game.active_players_count() > 1 && actions < _config.max_actions)
+        {
+            CounterRng rng(_config.seed, game_id, static_cast<std::uint32_t>(actions));
+            Player *actor = game.current_player();
+            const size_t seat = actor->seat();
+
+            // Undos are offered in the reaction phase below, not as turn actions.
+            size_t count = 0;
+            if (!sampled)
+            {
+                LegalActions turn_actions = game.legal_actions(*actor);
+                turn_actions.forbid(ActionType::Undo);
+                count = turn_actions.expand(legal, MAX_ACTIONS);
+            }
+            else
+            {
+                count = sample_actions(game, *actor, rng, legal);
+            }
+            const Action action = _policies[seat]->choose(game, *actor, legal, count, rng);
+            const PerfSample before = perf != nullptr ? perf->read() : PerfSample();
+            const ActionResult result = perform(*actor, players, action);
+            if (perf != nullptr)
+            {
+                stats.perf.record(action.type, perf->since(before));
+            }
+            ++actions;
+            if (result == ActionResult::Sanctioned)
+            {
+                continue;
+            }
+            throw_if_failed(result);
+            if (action.type == ActionType::Coup)
+            {
+                set_live_reactor(*players[action.target], false);
+            }
+
+            // Only active seats whose role undoes this action type are asked:
+            // all of them in seat order, or at most SAMPLED_REACTORS at large tables.
+            const SeatSet &reactors = _live_reactors[static_cast<size_t>(action.type)];
+            if (reactors.empty())
+            {
+                continue;
+            }
+            const size_t limit = sampled ? std::min(reactors.size(), SAMPLED_REACTORS) : SeatSet::NONE;
+            size_t r = sampled ? reactors.find_circular(rng.uniform(static_cast<std::uint32_t>(players.size())))
+                               : reactors.find(0);
+            for (size_t asked = 0; asked < limit && r != SeatSet::NONE; ++asked)
+            {
+                Player *reactor = players[r];
+                Player *target = reactor == actor ? nullptr : undo_target(game, *reactor, *actor, action.type);
+                if (target != nullptr && _policies[r]->react(game, *reactor, *actor, rng))
+                {
+                    const PerfSample before = perf != nullptr ? perf->read() : PerfSample();
+                    throw_if_failed(reactor->try_undo(*target));
+                    if (perf != nullptr)
+                    {
+                        stats.perf.record(ActionType::Undo, perf->since(before));
+                    }
+                    ++stats.undos;
+                    if (action.type == ActionType::Coup)
+                    {
+                        set_live_reactor(*target, true);
+                    }
+                }
+                r = sampled ? reactors.find_circular(r + 1) : reactors.find(r + 1);
+            }
+        }
+
+        if (_config.log != nullptr)
+        {
+            _config.log->end();
+        }
+        ++stats.games;
+        stats.actions += actions;
+        int winner = -1;
+        if (game.active_players_count() == 1)
+        {
+            const size_t seat = game.active_seats().find(0);
+            winner = static_cast<int>(seat);
+            ++stats.wins_by_seat[seat];
+        }
+        else
+        {
+            ++stats.draws;
+        }
+        _pool.release(std::move(table));
+        return winner;
+    }
+}
@@ -1,36 +1,43 @@
 //talgov44@gmail.com
 
 #include "Spy.hpp"
+#include "Constants.hpp"
+#include "Instrument.hpp"
+#include "Trace.hpp"
 
 namespace coup
 {
-    const int MERCHANT_ARREST_PENALTY = 2;
-
     Spy::Spy(Game &game, const std::string &name) : Player(game, name)
     {
-        this->_role = "Spy";
+        this->_role = Role::Spy;
     }
 
     /**
      * @brief A Spy can undo an 'arrest' action performed by another player.
      * This reverses the coin transfer, accounting for special roles.
      * @param arresting_player The player who performed the arrest.
+     * @return ActionResult NothingToUndo if the player's last action was not an arrest.
      */
-    void Spy::undo(Player &arresting_player)
+    ActionResult Spy::try_undo(Player &arresting_player)
     {
-        if (arresting_player.getLastAction() != "arrest")
+        COUP_RECORD_LATENCY(UndoSpy);
+        COUP_TRACK_ALLOCATIONS(Undo);
+        COUP_TRACE_SPAN("Spy::try_undo");
+        if (arresting_player.lastActionType() != ActionType::Arrest)
         {
-            throw std::runtime_error("Spy can only undo an 'arrest' action.");
+            return ActionResult::NothingToUndo;
         }
 
         Player *arrested_player = arresting_player.getLastArrestedTarget();
         if (arrested_player == nullptr)
         {
-            throw std::runtime_error("No recent arrest to undo.");
+            return ActionResult::NothingToUndo;
         }
 
+        const int coins_before = this->_coins;
+        const int target_before = arresting_player.coins();
         // Handle the reversal based on the role of the player who was arrested.
-        if (arrested_player->role() == "Merchant")
+        if (arrested_player->roleType() == Role::Merchant)
         {
             // The Merchant paid a 2-coin penalty directly to the bank.
             // The undo action gives those 2 coins back to the Merchant.
@@ -43,16 +50,30 @@ namespace coup
             arresting_player.removeCoins(1);
             arrested_player->addCoins(1);
         }
+        report(EventKind::Undo, ActionType::Undo, ActionResult::Ok, &arresting_player, coins_before, target_before);
+        return ActionResult::Ok;
     }
 
     /**
      * @brief Allows the spy to see how many coins another player has.
-     * This is purely for information and does not consume a turn.
+     * This is purely for information and does not consume a turn. In
+     * imperfect-information mode it reveals the target's coins to the spy. The
+     * report goes to the game's event sink, if one is attached.
      * @param target The player to spy on.
      */
     void Spy::spyOn(const Player &target) const
     {
-        std::cout << "[SPY REPORT] " << this->getName() << " sees that "
-                  << target.getName() << " has " << target.coins() << " coins." << std::endl;
+        this->game.reveal_coins(*this, target);
+        if (this->game.event_sink() == nullptr)
+        {
+            return;
+        }
+        GameEvent event{};
+        event.kind = EventKind::SpyReport;
+        event.result = ActionResult::Ok;
+        event.actor = static_cast<std::uint16_t>(this->game.seat_of(*this));
+        event.target = static_cast<std::uint16_t>(this->game.seat_of(target));
+        event.target_delta = static_cast<std::int16_t>(target.coins());
+        this->game.emit(event);
     }
 }
\ No newline at end of file
@@ -0,0 +1,572 @@
+//talgov44@gmail.com
+
+#include "Tablebase.hpp"
+#include "GameState.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace coup
+{
+    namespace
+    {
+        const size_t COIN_VALUES = TABLEBASE_MAX_COINS + 1;
+        const size_t PHASES = 4; // Turn, or reaction to a tax, a bribe or an arrest.
+        const size_t PAIRS = ROLE_COUNT * ROLE_COUNT;
+        const size_t NO_INDEX = ~size_t(0);
+
+        // Entry byte: 0 is a draw, 1..127 a win and 129..255 a loss in (byte - 128).
+        const std::uint8_t LOSS_BASE = 128;
+        const unsigned MAX_DISTANCE = 127;
+
+        struct TablebaseHeader
+        {
+            std::uint32_t magic;
+            std::uint16_t version;
+            std::uint16_t max_coins;
+            std::uint32_t entries_per_table;
+            std::uint32_t offsets[PAIRS];
+        };
+
+        // The fields that identify a two-player position. Seat 0 of a table is
+        // the player whose role comes first in Role order.
+        struct Fields
+        {
+            size_t phase;
+            size_t decider;   // Table seat that decides.
+            size_t turn;      // Table seat whose turn it is; during a reaction, not always the actor.
+            size_t extra;     // Extra action of the player on turn.
+            size_t sanctions; // Bit per table seat.
+            size_t arrests;   // Bit s: table seat s last arrested the other seat.
+            size_t coins[2];
+        };
+
+        size_t index_of(const Fields &f)
+        {
+            size_t index = f.phase;
+            index = index * 2 + f.decider;
+            index = index * 2 + f.turn;
+            index = index * 2 + f.extra;
+            index = index * 4 + f.sanctions;
+            index = index * 4 + f.arrests;
+            index = index * COIN_VALUES + f.coins[0];
+            return index * COIN_VALUES + f.coins[1];
+        }
+
+        Fields fields_of(size_t index)
+        {
+            Fields f;
+            f.coins[1] = index % COIN_VALUES;
+            index /= COIN_VALUES;
+            f.coins[0] = index % COIN_VALUES;
+            index /= COIN_VALUES;
+            f.arrests = index % 4;
+            index /= 4;
+            f.sanctions = index % 4;
+            index /= 4;
+            f.extra = index % 2;
+            index /= 2;
+            f.turn = index % 2;
+            index /= 2;
+            f.decider = index % 2;
+            f.phase = index / 2;
+            return f;
+        }
+
+        size_t pair_index(Role a, Role b)
+        {
+            if (b < a)
+            {
+                std::swap(a, b);
+            }
+            return static_cast<size_t>(a) * ROLE_COUNT + static_cast<size_t>(b);
+        }
+
+        ActionType performed_in(size_t phase)
+        {
+            const ActionType performed[PHASES] = {ActionType::None, ActionType::Tax, ActionType::Bribe, ActionType::Arrest};
+            return performed[phase];
+        }
+
+        /**
+         * @brief Table index of a position with exactly two active players.
+         *
+         * @param pair Set to the role pair whose table holds the position.
+         * @param seats Set to the game seats of table seats 0 and 1.
+         * @return size_t The index, or NO_INDEX if the position is not tabled.
+         */
+        size_t encode(const Position &position, size_t &pair, size_t seats[2])
+        {
+            const GameState &state = position.state;
+            size_t found = 0;
+            for (size_t i = 0; i < state.player_count; ++i)
+            {
+                if (state.players[i].has(PlayerState::ACTIVE))
+                {
+                    if (found == 2)
+                    {
+                        return NO_INDEX;
+                    }
+                    seats[found++] = i;
+                }
+            }
+            // A General can only revive a player while reacting to the coup,
+            // which is not a tabled phase, so save_target is irrelevant here.
+            if (found != 2)
+            {
+                return NO_INDEX;
+            }
+            if (state.players[seats[1]].role < state.players[seats[0]].role)
+            {
+                std::swap(seats[0], seats[1]);
+            }
+
+            Fields f;
+            if (position.phase == Position::TURN)
+            {
+                f.phase = 0;
+            }
+            else if (position.performed == ActionType::Tax)
+            {
+                f.phase = 1;
+            }
+            else if (position.performed == ActionType::Bribe)
+            {
+                f.phase = 2;
+            }
+            else if (position.performed == ActionType::Arrest)
+            {
+                f.phase = 3;
+            }
+            else
+            {
+                return NO_INDEX;
+            }
+
+            // Before the first turn only a Merchant's opening bonus differs
+            // from a started game.
+            const size_t holder = current_seat(state);
+            if ((state.flags & GameState::STARTED) == 0 && state.players[holder].role == Role::Merchant)
+            {
+                return NO_INDEX;
+            }
+            if (position.seat != seats[0] && position.seat != seats[1])
+            {
+                return NO_INDEX;
+            }
+            f.decider = position.seat == seats[0] ? 0 : 1;
+            f.turn = holder == seats[0] ? 0 : 1;
+            f.extra = state.players[holder].has(PlayerState::EXTRA_ACTION) ? 1 : 0;
+            f.sanctions = 0;
+            f.arrests = 0;
+            for (size_t s = 0; s < 2; ++s)
+            {
+                const PlayerState &player = state.players[seats[s]];
+                if (player.coins > TABLEBASE_MAX_COINS ||
+                    (seats[s] != holder && player.has(PlayerState::EXTRA_ACTION)))
+                {
+                    return NO_INDEX;
+                }
+                f.coins[s] = player.coins;
+                f.sanctions |= player.has(PlayerState::SANCTIONED) ? size_t(1) << s : 0;
+                f.arrests |= player.last_arrested == static_cast<int>(seats[1 - s]) ? size_t(1) << s : 0;
+            }
+            pair = pair_index(state.players[seats[0]].role, state.players[seats[1]].role);
+            return index_of(f);
+        }
+
+        // Two-seat position for a table entry, or false if the entry cannot occur.
+        bool decode(Role a, Role b, size_t index, Position &position)
+        {
+            const Fields f = fields_of(index);
+            const size_t holder = f.turn;
+            if (f.phase == 0 && f.turn != f.decider)
+            {
+                return false;
+            }
+
+            GameState state;
+            std::memset(&state, 0, sizeof(state));
+            state.player_count = 2;
+            state.turn = static_cast<std::uint8_t>(holder);
+            state.save_target = NO_TARGET;
+            state.flags = GameState::STARTED;
+            const Role roles[2] = {a, b};
+            for (size_t s = 0; s < 2; ++s)
+            {
+                PlayerState &player = state.players[s];
+                player.role = roles[s];
+                player.coins = static_cast<std::uint8_t>(f.coins[s]);
+                player.set(PlayerState::ACTIVE, true);
+                player.set(PlayerState::SANCTIONED, (f.sanctions >> s & 1) != 0);
+                player.set(PlayerState::EXTRA_ACTION, s == holder && f.extra != 0);
+                player.last_action = ActionType::None;
+                player.last_arrested = (f.arrests >> s & 1) != 0 ? static_cast<std::int8_t>(1 - s) : NO_TARGET;
+            }
+
+            if (f.phase == 0)
+            {
+                position = Position::turn(state);
+                return true;
+            }
+            const size_t actor = 1 - f.decider;
+            state.players[actor].last_action = performed_in(f.phase);
+            position = Position::reaction(state, actor, performed_in(f.phase), f.decider);
+            return position.phase == Position::REACTION && position.seat == f.decider;
+        }
+
+        EndgameValue value_of(std::uint8_t entry)
+        {
+            if (entry == 0)
+            {
+                return {EndgameResult::Draw, 0};
+            }
+            if (entry < LOSS_BASE)
+            {
+                return {EndgameResult::Win, entry};
+            }
+            return {EndgameResult::Loss, static_cast<std::uint8_t>(entry - LOSS_BASE)};
+        }
+
+        int score(const EndgameValue &value)
+        {
+            switch (value.result)
+            {
+            case EndgameResult::Win:
+                return 1000 - value.distance;
+            case EndgameResult::Loss:
+                return -1000 + value.distance;
+            case EndgameResult::Draw:
+                break;
+            }
+            return 0;
+        }
+
+        /**
+         * @brief Solves one role pair by retrograde analysis.
+         *
+         * Forward pass: every valid position plays each of its actions once; a
+         * coup that ends the game is an immediate win, and every other successor
+         * gets a reverse edge. Backward pass: positions are resolved in order of
+         * distance. A predecessor wins as soon as one successor is good for it,
+         * and loses once every successor has turned out bad; a successor outside
+         * the table never resolves, so it can only make a position a draw.
+         */
+        std::vector<std::uint8_t> solve(Role a, Role b)
+        {
+            const size_t n = Tablebase::ENTRIES_PER_TABLE;
+            std::vector<std::uint8_t> decider(n, 0);
+            std::vector<std::uint8_t> resolved(n, 0);
+            std::vector<std::uint16_t> remaining(n, 0);
+            std::vector<std::uint16_t> distance(n, 0);
+            std::vector<std::uint8_t> result(n, static_cast<std::uint8_t>(EndgameResult::Draw));
+            std::vector<std::uint32_t> queue;
+            std::vector<std::uint64_t> edges; // (successor << 32) | predecessor
+
+            Action actions[MAX_ACTIONS];
+            size_t successors[MAX_ACTIONS];
+            for (size_t index = 0; index < n; ++index)
+            {
+                Position position;
+                if (!decode(a, b, index, position))
+                {
+                    resolved[index] = 1; // Never reached: stays a draw and has no edges.
+                    continue;
+                }
+                decider[index] = fields_of(index).decider;
+                const size_t count = position.actions(actions, MAX_ACTIONS);
+                size_t unique = 0;
+                bool wins = false;
+                bool unknown = false;
+                for (size_t i = 0; i < count && !wins; ++i)
+                {
+                    Position next = position;
+                    next.play(actions[i]);
+                    if (next.terminal())
+                    {
+                        wins = next.winner() == position.seat;
+                        continue;
+                    }
+                    size_t pair = 0;
+                    size_t seats[2];
+                    const size_t successor = encode(next, pair, seats);
+                    if (successor == NO_INDEX)
+                    {
+                        unknown = true;
+                        continue;
+                    }
+                    successors[unique++] = successor;
+                }
+                if (wins)
+                {
+                    resolved[index] = 1;
+                    result[index] = static_cast<std::uint8_t>(EndgameResult::Win);
+                    distance[index] = 1;
+                    queue.push_back(static_cast<std::uint32_t>(index));
+                    continue;
+                }
+                std::sort(successors, successors + unique);
+                unique = static_cast<size_t>(std::unique(successors, successors + unique) - successors);
+                for (size_t i = 0; i < unique; ++i)
+                {
+                    edges.push_back(static_cast<std::uint64_t>(successors[i]) << 32 | index);
+                }
+                remaining[index] = static_cast<std::uint16_t>(unique + (unknown ? 1 : 0));
+                if (remaining[index] == 0)
+                {
+                    // Every action ends the game in the opponent's favour.
+                    resolved[index] = 1;
+                    result[index] = static_cast<std::uint8_t>(EndgameResult::Loss);
+                    distance[index] = 1;
+                    queue.push_back(static_cast<std::uint32_t>(index));
+                }
+            }
+
+            // Reverse edges, grouped by successor.
+            std::sort(edges.begin(), edges.end());
+            std::vector<std::uint32_t> first(n + 1, 0);
+            for (std::uint64_t edge : edges)
+            {
+                first[(edge >> 32) + 1]++;
+            }
+            for (size_t i = 0; i < n; ++i)
+            {
+                first[i + 1] += first[i];
+            }
+
+            for (size_t head = 0; head < queue.size(); ++head)
+            {
+                const std::uint32_t t = queue[head];
+                const bool t_wins = result[t] == static_cast<std::uint8_t>(EndgameResult::Win);
+                for (std::uint32_t e = first[t]; e < first[t + 1]; ++e)
+                {
+                    const std::uint32_t s = static_cast<std::uint32_t>(edges[e]);
+                    if (resolved[s])
+                    {
+                        continue;
+                    }
+                    const bool good = decider[s] == decider[t] ? t_wins : !t_wins;
+                    if (good || --remaining[s] == 0)
+                    {
+                        resolved[s] = 1;
+                        result[s] = static_cast<std::uint8_t>(good ? EndgameResult::Win : EndgameResult::Loss);
+                        distance[s] = static_cast<std::uint16_t>(distance[t] + 1);
+                        queue.push_back(s);
+                    }
+                }
+            }
+
+            std::vector<std::uint8_t> table(n, 0);
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (result[i] == static_cast<std::uint8_t>(EndgameResult::Draw))
+                {
+                    continue;
+                }
+                if (distance[i] > MAX_DISTANCE)
+                {
+                    throw std::runtime_error("Tablebase distance does not fit in an entry.");
+                }
+                table[i] = static_cast<std::uint8_t>(result[i] == static_cast<std::uint8_t>(EndgameResult::Win)
+                                                         ? distance[i]
+                                                         : LOSS_BASE + distance[i]);
+            }
+            return table;
+        }
+    }
+
+    const size_t Tablebase::ENTRIES_PER_TABLE = PHASES * 2 * 2 * 2 * 4 * 4 * COIN_VALUES * COIN_VALUES;
+
+    bool better(const EndgameValue &a, const EndgameValue &b)
+    {
+        return score(a) > score(b);
+    }
+
+    /**
+     * @brief Solves every pair of the given roles (each role also against itself)
+     *        and writes the tables to a file.
+     *
+     * @throws std::runtime_error If the file cannot be written.
+     */
+    void Tablebase::build(const std::string &path, const std::vector<Role> &roles)
+    {
+        std::vector<Role> unique = roles;
+        std::sort(unique.begin(), unique.end());
+        unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+        TablebaseHeader header;
+        std::memset(&header, 0, sizeof(header));
+        header.magic = TABLEBASE_MAGIC;
+        header.version = TABLEBASE_VERSION;
+        header.max_coins = TABLEBASE_MAX_COINS;
+        header.entries_per_table = static_cast<std::uint32_t>(ENTRIES_PER_TABLE);
+
+        std::FILE *file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Cannot open tablebase for writing: " + path);
+        }
+        std::fwrite(&header, sizeof(header), 1, file);
+        size_t offset = sizeof(header);
+        for (size_t i = 0; i < unique.size(); ++i)
+        {
+            for (size_t j = i; j < unique.size(); ++j)
+            {
+                const std::vector<std::uint8_t> table = solve(unique[i], unique[j]);
+                std::fwrite(table.data(), 1, table.size(), file);
+                header.offsets[pair_index(unique[i], unique[j])] = static_cast<std::uint32_t>(offset);
+                offset += table.size();
+            }
+        }
+        std::fseek(file, 0, SEEK_SET);
+        std::fwrite(&header, sizeof(header), 1, file);
+        const bool failed = std::ferror(file) != 0;
+        std::fclose(file);
+        if (failed)
+        {
+            throw std::runtime_error("Cannot write tablebase: " + path);
+        }
+    }
+
+    /**
+     * @brief Maps a tablebase file read-only.
+     *
+     * @throws std::runtime_error If the file cannot be mapped or is not a tablebase
+     *                            built with the current table layout.
+     */
+    Tablebase::Tablebase(const std::string &path) : _data(nullptr), _size(0), _offsets(nullptr)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open tablebase: " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TablebaseHeader))
+        {
+            ::close(fd);
+            throw std::runtime_error("Not a tablebase: " + path);
+        }
+        _size = static_cast<size_t>(info.st_size);
+        void *mapping = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error("Cannot map tablebase: " + path);
+        }
+        _data = static_cast<const unsigned char *>(mapping);
+
+        const TablebaseHeader *header = reinterpret_cast<const TablebaseHeader *>(_data);
+        bool valid = header->magic == TABLEBASE_MAGIC && header->version == TABLEBASE_VERSION &&
+                     header->max_coins == TABLEBASE_MAX_COINS && header->entries_per_table == ENTRIES_PER_TABLE;
+        for (size_t i = 0; valid && i < PAIRS; ++i)
+        {
+            valid = header->offsets[i] == 0 || header->offsets[i] + ENTRIES_PER_TABLE <= _size;
+        }
+        if (!valid)
+        {
+            ::munmap(const_cast<unsigned char *>(_data), _size);
+            throw std::runtime_error("Not a tablebase, or built for a different layout: " + path);
+        }
+        _offsets = header->offsets;
+    }
+
+    Tablebase::~Tablebase()
+    {
+        ::munmap(const_cast<unsigned char *>(_data), _size);
+    }
+
+    bool Tablebase::has(Role a, Role b) const
+    {
+        return _offsets[pair_index(a, b)] != 0;
+    }
+
+    bool Tablebase::lookup(const Position &position, EndgameValue &value) const
+    {
+        size_t pair = 0;
+        size_t seats[2];
+        const size_t index = encode(position, pair, seats);
+        if (index == NO_INDEX || _offsets[pair] == 0)
+        {
+            return false;
+        }
+        value = value_of(_data[_offsets[pair] + index]);
+        return true;
+    }
+
+    EndgamePolicy::EndgamePolicy(const Tablebase &tablebase, Policy &fallback)
+        : _tablebase(tablebase), _fallback(fallback)
+    {
+    }
+
+    // Picks the action with the best tabled value for the player deciding at
+    // `root`. Returns false if `root` is not in the table.
+    bool EndgamePolicy::best_action(const Position &root, const Action *legal, size_t count, Action &best) const
+    {
+        EndgameValue here;
+        if (!_tablebase.lookup(root, here))
+        {
+            return false;
+        }
+        EndgameValue best_value = {EndgameResult::Loss, 0};
+        best = legal[0];
+        for (size_t i = 0; i < count; ++i)
+        {
+            Position next = root;
+            next.play(legal[i]);
+            EndgameValue value = {EndgameResult::Draw, 0};
+            if (next.terminal())
+            {
+                value.result = next.winner() == root.seat ? EndgameResult::Win : EndgameResult::Loss;
+                value.distance = 1;
+            }
+            else if (_tablebase.lookup(next, value))
+            {
+                if (next.seat != root.seat && value.result != EndgameResult::Draw)
+                {
+                    value.result = value.result == EndgameResult::Win ? EndgameResult::Loss : EndgameResult::Win;
+                }
+                value.distance = static_cast<std::uint8_t>(value.distance + 1);
+            }
+            if (i == 0 || better(value, best_value))
+            {
+                best_value = value;
+                best = legal[i];
+            }
+        }
+        return true;
+    }
+
+    Action EndgamePolicy::choose(const Game &game, const Player &self,
+                                 const Action *legal, size_t count, CounterRng &rng)
+    {
+        Action best;
+        if (best_action(Position::turn(GameState::capture(game)), legal, count, best))
+        {
+            return best;
+        }
+        return _fallback.choose(game, self, legal, count, rng);
+    }
+
+    bool EndgamePolicy::react(const Game &game, const Player &self, const Player &actor, CounterRng &rng)
+    {
+        const size_t seat = game.seat_of(self);
+        const Position root = Position::reaction(GameState::capture(game), game.seat_of(actor),
+                                                 actor.lastActionType(), seat);
+        if (root.phase == Position::REACTION && root.seat == seat)
+        {
+            const Action options[] = {{ActionType::Undo, root.undo_target}, {ActionType::None, NO_TARGET}};
+            Action best;
+            if (best_action(root, options, 2, best))
+            {
+                return best.type == ActionType::Undo;
+            }
+        }
+        return _fallback.react(game, self, actor, rng);
+    }
+}
@@ -0,0 +1,278 @@
+//talgov44@gmail.com
+
+#include "Tournament.hpp"
+#include "WorkStealingDeque.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace coup
+{
+    double TournamentStats::win_rate() const
+    {
+        return this->games > 0 ? static_cast<double>(this->wins) / static_cast<double>(this->games) : 0.0;
+    }
+
+    void TournamentResult::merge(const TournamentResult &other)
+    {
+        this->matches += other.matches;
+        this->games += other.games;
+        this->actions += other.actions;
+        this->undos += other.undos;
+        this->draws += other.draws;
+        if (this->by_entrant.size() < other.by_entrant.size())
+        {
+            this->by_entrant.resize(other.by_entrant.size());
+        }
+        for (size_t i = 0; i < other.by_entrant.size(); ++i)
+        {
+            this->by_entrant[i].games += other.by_entrant[i].games;
+            this->by_entrant[i].wins += other.by_entrant[i].wins;
+        }
+        if (this->by_role.size() < other.by_role.size())
+        {
+            this->by_role.resize(other.by_role.size());
+        }
+        for (size_t i = 0; i < other.by_role.size(); ++i)
+        {
+            this->by_role[i].games += other.by_role[i].games;
+            this->by_role[i].wins += other.by_role[i].wins;
+        }
+    }
+
+    double TournamentResult::games_per_second() const
+    {
+        return this->seconds > 0.0 ? static_cast<double>(this->games) / this->seconds : 0.0;
+    }
+
+    Tournament::Tournament(size_t max_actions) : _max_actions(max_actions) {}
+
+    size_t Tournament::add_entrant(const std::string &name, PolicyFactory make_policy)
+    {
+        _entrants.push_back({name, std::move(make_policy)});
+        return _entrants.size() - 1;
+    }
+
+    /**
+     * @brief Schedules a match.
+     *
+     * @throws std::runtime_error If the lineup and entrant lists differ in size
+     *                            or name an unknown entrant.
+     */
+    void Tournament::add_match(const Match &match)
+    {
+        if (match.lineup.size() != match.entrants.size() || match.lineup.size() < 2)
+        {
+            throw std::runtime_error("Match needs one entrant per seat and at least 2 seats.");
+        }
+        for (size_t entrant : match.entrants)
+        {
+            if (entrant >= _entrants.size())
+            {
+                throw std::runtime_error("Match refers to an unknown entrant.");
+            }
+        }
+        _matches.push_back(match);
+    }
+
+    /**
+     * @brief Schedules `rounds` passes in which the lineup is rotated through
+     *        every seat, so no role or entrant keeps the first-move advantage.
+     *
+     * Seat i of rotation k gets roles[(i + k) % n] played by entrants[(i + k) % n].
+     * Every match gets its own seed, derived from `seed` and its position.
+     */
+    void Tournament::add_rotations(const std::vector<Role> &roles, const std::vector<size_t> &entrants,
+                                   size_t games_per_match, size_t rounds, std::uint64_t seed)
+    {
+        const size_t n = roles.size();
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            for (size_t shift = 0; shift < n; ++shift)
+            {
+                Match match;
+                match.games = games_per_match;
+                match.seed = seed + round * n + shift;
+                for (size_t seat = 0; seat < n; ++seat)
+                {
+                    match.lineup.push_back(roles[(seat + shift) % n]);
+                    match.entrants.push_back(entrants.at((seat + shift) % n));
+                }
+                add_match(match);
+            }
+        }
+    }
+
+    const std::vector<Entrant> &Tournament::entrants() const
+    {
+        return _entrants;
+    }
+
+    const std::vector<Match> &Tournament::matches() const
+    {
+        return _matches;
+    }
+
+    void Tournament::play_match(const Match &match, std::vector<std::unique_ptr<Policy>> &policies,
+                                std::unique_ptr<Simulator> &simulator, TournamentResult &result) const
+    {
+        std::vector<Policy *> seats;
+        for (size_t entrant : match.entrants)
+        {
+            if (!policies[entrant])
+            {
+                policies[entrant] = _entrants[entrant].make_policy();
+            }
+            seats.push_back(policies[entrant].get());
+        }
+
+        SimulationConfig config;
+        config.lineup = match.lineup;
+        config.games = match.games;
+        config.seed = match.seed;
+        config.max_actions = _max_actions;
+        if (simulator)
+        {
+            simulator->configure(config, seats);
+        }
+        else
+        {
+            simulator = std::make_unique<Simulator>(config, seats);
+        }
+
+        SimulationStats stats;
+        for (size_t g = 0; g < match.games; ++g)
+        {
+            const int winner = simulator->play_one(g, stats);
+            for (size_t seat = 0; seat < match.lineup.size(); ++seat)
+            {
+                result.by_entrant[match.entrants[seat]].games++;
+                result.by_role[static_cast<size_t>(match.lineup[seat])].games++;
+            }
+            if (winner >= 0)
+            {
+                result.by_entrant[match.entrants[winner]].wins++;
+                result.by_role[static_cast<size_t>(match.lineup[winner])].wins++;
+            }
+        }
+        result.matches++;
+        result.games += stats.games;
+        result.actions += stats.actions;
+        result.undos += stats.undos;
+        result.draws += stats.draws;
+    }
+
+    /**
+     * @brief Plays every scheduled match and returns the merged results.
+     *
+     * Results do not depend on the number of threads: every match is seeded
+     * on its own and is always played start to finish by a single worker.
+     */
+    TournamentResult Tournament::run(size_t threads) const
+    {
+        if (threads == 0)
+        {
+            threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, std::max<size_t>(1, _matches.size()));
+
+        std::vector<std::unique_ptr<WorkStealingDeque>> queues;
+        for (size_t w = 0; w < threads; ++w)
+        {
+            queues.push_back(std::make_unique<WorkStealingDeque>(_matches.size() / threads + 1));
+        }
+        for (size_t m = 0; m < _matches.size(); ++m)
+        {
+            queues[m % threads]->push(m);
+        }
+
+        std::vector<TournamentResult> partial(threads);
+        std::atomic<bool> failed(false);
+        std::exception_ptr failure;
+        std::mutex failure_mutex;
+        auto play_all = [&](size_t self)
+        {
+            TournamentResult &result = partial[self];
+            result.by_entrant.resize(_entrants.size());
+            result.by_role.resize(ROLE_COUNT);
+            std::vector<std::unique_ptr<Policy>> policies(_entrants.size());
+            std::unique_ptr<Simulator> simulator;
+
+            size_t task = 0;
+            while (!failed.load(std::memory_order_relaxed))
+            {
+                if (queues[self]->take(task))
+                {
+                    play_match(_matches[task], policies, simulator, result);
+                    continue;
+                }
+                // Own deque is empty: sweep the others until every one reports empty.
+                bool stole = false;
+                bool retry = false;
+                for (size_t i = 1; i < threads && !stole; ++i)
+                {
+                    WorkStealingDeque::Status status = queues[(self + i) % threads]->steal(task);
+                    stole = status == WorkStealingDeque::Status::Success;
+                    retry = retry || status == WorkStealingDeque::Status::Retry;
+                }
+                if (stole)
+                {
+                    play_match(_matches[task], policies, simulator, result);
+                }
+                else if (!retry)
+                {
+                    return;
+                }
+            }
+        };
+        // An exception must not leave a std::thread, so each worker keeps the
+        // first one for run() to rethrow and tells the others to stop.
+        auto worker = [&](size_t self)
+        {
+            try
+            {
+                play_all(self);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(failure_mutex);
+                if (!failure)
+                {
+                    failure = std::current_exception();
+                }
+                failed.store(true, std::memory_order_relaxed);
+            }
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (size_t w = 1; w < threads; ++w)
+        {
+            workers.emplace_back(worker, w);
+        }
+        worker(0);
+        for (std::thread &t : workers)
+        {
+            t.join();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+
+        TournamentResult total;
+        total.by_entrant.resize(_entrants.size());
+        total.by_role.resize(ROLE_COUNT);
+        for (const TournamentResult &result : partial)
+        {
+            total.merge(result);
+        }
+        total.seconds = std::chrono::duration<double>(stop - start).count();
+        return total;
+    }
+}
@@ -0,0 +1,144 @@
+//talgov44@gmail.com
+
+#include "Trace.hpp"
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace coup
+{
+    namespace
+    {
+        struct TraceRing
+        {
+            TraceEvent events[TRACE_RING_SIZE];
+            std::uint64_t written = 0; // Total spans recorded; the ring holds the last TRACE_RING_SIZE.
+            size_t thread = 0;         // Track number in the exported trace.
+        };
+
+        // Rings are owned here rather than by their threads, so spans of
+        // threads that have exited can still be written out.
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<TraceRing>> rings;
+            std::uint64_t start_ticks = trace_clock();
+            std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+        };
+
+        Registry &registry()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        thread_local TraceRing *ring = nullptr;
+
+        TraceRing *create_ring()
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.rings.emplace_back(new TraceRing());
+            r.rings.back()->thread = r.rings.size() - 1;
+            return r.rings.back().get();
+        }
+
+        // Writes `text` as a JSON string; span names are identifiers, but quote anyway.
+        void write_json_string(std::ostream &out, const char *text)
+        {
+            out << '"';
+            for (const char *c = text; *c != '\0'; ++c)
+            {
+                if (*c == '"' || *c == '\\')
+                {
+                    out << '\\';
+                }
+                out << *c;
+            }
+            out << '"';
+        }
+    }
+
+    void record_trace(const char *name, std::uint64_t begin, std::uint64_t end)
+    {
+        if (ring == nullptr)
+        {
+            ring = create_ring();
+        }
+        ring->events[ring->written % TRACE_RING_SIZE] = {name, begin, end, 0};
+        ++ring->written;
+    }
+
+    void flag_last_trace(std::uint32_t flags)
+    {
+        if (ring != nullptr && ring->written > 0)
+        {
+            ring->events[(ring->written - 1) % TRACE_RING_SIZE].flags |= flags;
+        }
+    }
+
+    void write_chrome_trace(std::ostream &out)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        // Convert counter ticks to microseconds with the rate seen since start-up.
+        const std::uint64_t ticks = trace_clock() - r.start_ticks;
+        const double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - r.start_time).count();
+        const double ticks_per_micro = micros > 0.0 && ticks > 0 ? static_cast<double>(ticks) / micros : 1.0;
+
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (const std::unique_ptr<TraceRing> &thread : r.rings)
+        {
+            const std::uint64_t count = thread->written < TRACE_RING_SIZE ? thread->written : TRACE_RING_SIZE;
+            for (std::uint64_t i = thread->written - count; i < thread->written; ++i)
+            {
+                const TraceEvent &event = thread->events[i % TRACE_RING_SIZE];
+                // Signed: a thread's first span may start just before the registry existed.
+                const double begin = static_cast<double>(static_cast<std::int64_t>(event.begin - r.start_ticks)) / ticks_per_micro;
+                const double duration = static_cast<double>(event.end - event.begin) / ticks_per_micro;
+                out << (first ? "\n" : ",\n") << "{\"name\":";
+                write_json_string(out, event.name);
+                out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->thread
+                    << ",\"ts\":" << begin << ",\"dur\":" << duration;
+                if ((event.flags & TRACE_THREW) != 0)
+                {
+                    out << ",\"args\":{\"threw\":true}";
+                }
+                out << "}";
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    void clear_trace()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const std::unique_ptr<TraceRing> &thread : r.rings)
+        {
+            thread->written = 0;
+        }
+    }
+
+    size_t trace_size()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        size_t size = 0;
+        for (const std::unique_ptr<TraceRing> &thread : r.rings)
+        {
+            size += thread->written < TRACE_RING_SIZE ? thread->written : TRACE_RING_SIZE;
+        }
+        return size;
+    }
+}
@@ -0,0 +1,197 @@
+//talgov44@gmail.com
+
+#include "VecEnv.hpp"
+#include "Constants.hpp"
+#include "Game.hpp"
+#include "PlayerArena.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace coup
+{
+    const size_t VecEnv::OBSERVATION_SIZE;
+
+    namespace
+    {
+        std::uint64_t slot_bit(ActionType type)
+        {
+            return std::uint64_t(1) << (static_cast<size_t>(type) * GameState::MAX_PLAYERS);
+        }
+
+        // Same actions as Position::actions(), but built from the legal bitmasks
+        // directly instead of through an Action array.
+        std::uint64_t legal_mask(const Position &position)
+        {
+            if (position.terminal())
+            {
+                return 0;
+            }
+            if (position.phase == Position::REACTION)
+            {
+                return slot_bit(ActionType::Undo) << position.undo_target | slot_bit(ActionType::None);
+            }
+            const LegalActions legal = legal_actions(position.state, position.seat);
+            std::uint64_t mask = 0;
+            const ActionType untargeted[] = {ActionType::Gather, ActionType::Tax, ActionType::Bribe, ActionType::Invest};
+            for (ActionType type : untargeted)
+            {
+                mask |= legal.can(type) ? slot_bit(type) : 0;
+            }
+            const ActionType targeted[] = {ActionType::Arrest, ActionType::Sanction, ActionType::Coup};
+            for (ActionType type : targeted)
+            {
+                mask |= legal.can(type) ? legal.targets(type) << (static_cast<size_t>(type) * GameState::MAX_PLAYERS) : 0;
+            }
+            return mask;
+        }
+    }
+
+    std::uint32_t action_index(const Action &action)
+    {
+        const std::uint32_t slot = action.target == NO_TARGET ? 0 : static_cast<std::uint32_t>(action.target);
+        return static_cast<std::uint32_t>(action.type) * GameState::MAX_PLAYERS + slot;
+    }
+
+    Action action_at(std::uint32_t index)
+    {
+        const ActionType type = static_cast<ActionType>(index / GameState::MAX_PLAYERS);
+        switch (type)
+        {
+        case ActionType::Arrest:
+        case ActionType::Sanction:
+        case ActionType::Coup:
+        case ActionType::Undo:
+            return {type, static_cast<int>(index % GameState::MAX_PLAYERS)};
+        default:
+            return {type, NO_TARGET};
+        }
+    }
+
+    /**
+     * @throws std::runtime_error If there are no games, or the lineup does not
+     *                            fit a GameState.
+     */
+    VecEnv::VecEnv(const VecEnvConfig &config) : _config(config)
+    {
+        if (_config.envs == 0)
+        {
+            throw std::runtime_error("VecEnv needs at least one game.");
+        }
+        if (_config.lineup.size() < 2 || _config.lineup.size() > GameState::MAX_PLAYERS)
+        {
+            throw std::runtime_error("VecEnv lineup must have 2 to 6 players.");
+        }
+        Game game;
+        PlayerArena players;
+        for (size_t i = 0; i < _config.lineup.size(); ++i)
+        {
+            players.create(game, _config.lineup[i], "P" + std::to_string(i));
+        }
+        _start = GameState::capture(game);
+        _positions.assign(_config.envs, Position::turn(_start));
+        _steps.assign(_config.envs, 0);
+        _legal.assign(_config.envs, 0);
+    }
+
+    size_t VecEnv::envs() const
+    {
+        return _positions.size();
+    }
+
+    const Position &VecEnv::position(size_t env) const
+    {
+        return _positions.at(env);
+    }
+
+    // Observation row and legal-action mask of one game.
+    void VecEnv::write(size_t env, float *observation, std::uint64_t &mask)
+    {
+        const Position &position = _positions[env];
+        const GameState &state = position.state;
+        for (size_t i = 0; i < OBSERVATION_SIZE; ++i)
+        {
+            observation[i] = 0.0f;
+        }
+        for (size_t k = 0; k < state.player_count; ++k)
+        {
+            const PlayerState &player = state.players[(position.seat + k) % state.player_count];
+            float *row = observation + k * SEAT_FEATURES;
+            row[0] = player.has(PlayerState::ACTIVE) ? 1.0f : 0.0f;
+            row[1] = static_cast<float>(player.coins) / MUST_COUP_COINS;
+            row[2] = player.has(PlayerState::SANCTIONED) ? 1.0f : 0.0f;
+            row[3] = player.has(PlayerState::EXTRA_ACTION) ? 1.0f : 0.0f;
+            row[4 + static_cast<size_t>(player.role)] = 1.0f;
+        }
+        float *tail = observation + SEAT_FEATURES * GameState::MAX_PLAYERS;
+        if (position.phase == Position::REACTION)
+        {
+            tail[0] = 1.0f;
+            tail[1 + static_cast<size_t>(position.performed)] = 1.0f;
+        }
+
+        _legal[env] = legal_mask(position);
+        mask = _legal[env];
+    }
+
+    void VecEnv::reset(float *observations, std::uint64_t *masks)
+    {
+        for (size_t env = 0; env < _positions.size(); ++env)
+        {
+            _positions[env] = Position::turn(_start);
+            _steps[env] = 0;
+            write(env, observations + env * OBSERVATION_SIZE, masks[env]);
+        }
+    }
+
+    /**
+     * @brief Plays one decision in every game.
+     *
+     * Each action is checked against the legal mask the engine computed for
+     * its game, not against `masks`, which is only written. An action outside
+     * it is refused: that game is not stepped, gets illegal_reward and is
+     * flagged in `refused`; the other games are stepped as usual.
+     */
+    size_t VecEnv::step(const std::uint32_t *actions, float *observations, float *rewards,
+                        std::uint8_t *dones, std::uint64_t *masks, std::uint8_t *refused)
+    {
+        size_t refusals = 0;
+        for (size_t env = 0; env < _positions.size(); ++env)
+        {
+            const bool legal = actions[env] < VEC_ACTION_COUNT && (_legal[env] >> actions[env] & 1) != 0;
+            if (refused != nullptr)
+            {
+                refused[env] = legal ? 0 : 1;
+            }
+            dones[env] = 0;
+            if (!legal)
+            {
+                ++refusals;
+                rewards[env] = _config.illegal_reward;
+                write(env, observations + env * OBSERVATION_SIZE, masks[env]);
+                continue;
+            }
+            Position &position = _positions[env];
+            const std::uint8_t mover = position.seat;
+            position.play(action_at(actions[env]));
+            ++_steps[env];
+
+            rewards[env] = 0.0f;
+            if (position.terminal())
+            {
+                rewards[env] = position.winner() == mover ? 1.0f : -1.0f;
+                dones[env] = 1;
+            }
+            else if (_steps[env] >= _config.max_actions)
+            {
+                dones[env] = 1;
+            }
+            if (dones[env])
+            {
+                position = Position::turn(_start);
+                _steps[env] = 0;
+            }
+            write(env, observations + env * OBSERVATION_SIZE, masks[env]);
+        }
+        return refusals;
+    }
+}
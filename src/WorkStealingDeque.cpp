@@ -0,0 +1,91 @@
+//talgov44@gmail.com
+
+#include "WorkStealingDeque.hpp"
+
+namespace coup
+{
+    WorkStealingDeque::WorkStealingDeque(size_t capacity)
+        : _buffer(new std::atomic<size_t>[capacity == 0 ? 1 : capacity]),
+          _capacity(capacity == 0 ? 1 : capacity),
+          _top(0),
+          _bottom(0)
+    {
+    }
+
+    /**
+     * @brief Adds a task at the bottom of the deque.
+     *
+     * @return bool false if the deque is full.
+     */
+    bool WorkStealingDeque::push(size_t task)
+    {
+        const std::int64_t b = _bottom.load(std::memory_order_relaxed);
+        const std::int64_t t = _top.load(std::memory_order_acquire);
+        if (b - t >= static_cast<std::int64_t>(_capacity))
+        {
+            return false;
+        }
+        _buffer[static_cast<size_t>(b) % _capacity].store(task, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Removes the most recently pushed task.
+     *
+     * @return bool false if the deque was empty or the last task was stolen.
+     */
+    bool WorkStealingDeque::take(size_t &task)
+    {
+        const std::int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = _top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        task = _buffer[static_cast<size_t>(b) % _capacity].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // Last element: race against thieves for it.
+            const bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                          std::memory_order_relaxed);
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest task on behalf of another thread.
+     */
+    WorkStealingDeque::Status WorkStealingDeque::steal(size_t &task)
+    {
+        std::int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = _bottom.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return Status::Empty;
+        }
+
+        task = _buffer[static_cast<size_t>(t) % _capacity].load(std::memory_order_relaxed);
+        if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return Status::Retry;
+        }
+        return Status::Success;
+    }
+
+    size_t WorkStealingDeque::size() const
+    {
+        const std::int64_t b = _bottom.load(std::memory_order_relaxed);
+        const std::int64_t t = _top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+}
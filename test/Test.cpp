@@ -11,10 +11,35 @@
 #include "Merchant.hpp"
 #include "Spy.hpp"
 #include "Baron.hpp"
+#include "Simulator.hpp"
+#include "GameState.hpp"
+#include "Tournament.hpp"
+#include "WorkStealingDeque.hpp"
+#include "Rng.hpp"
+#include "GameLog.hpp"
+#include "Rules.hpp"
+#include "Mcts.hpp"
+#include "ParallelMcts.hpp"
+#include "Ismcts.hpp"
+#include "InformationSet.hpp"
+#include "Tablebase.hpp"
+#include "VecEnv.hpp"
+#include "BatchEngine.hpp"
+#include "GamePool.hpp"
+#include "PlayerArena.hpp"
+#include "SeatSet.hpp"
+#include "Instrument.hpp"
+#include "PerfCounters.hpp"
+#include "Trace.hpp"
 
 #include <vector>
 #include <string>
 #include <stdexcept>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include <thread>
 
 using namespace coup;
 using namespace std;
@@ -337,3 +362,1954 @@ TEST_CASE("Complex Interactions")
         CHECK(game.turn() == "Gov");
     }
 }
+
+TEST_CASE("Headless Simulator")
+{
+    SimulationConfig config;
+    config.lineup = {Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge, Role::Merchant};
+    config.games = 50;
+    config.seed = 7;
+
+    RandomPolicy random_policy;
+    GreedyPolicy greedy_policy;
+
+    SUBCASE("Every game ends in a win or a draw")
+    {
+        Simulator simulator(config, vector<Policy *>(config.lineup.size(), &random_policy));
+        SimulationStats stats = simulator.run();
+        CHECK(stats.games == 50);
+        size_t wins = 0;
+        for (size_t w : stats.wins_by_seat)
+        {
+            wins += w;
+        }
+        CHECK(wins + stats.draws == stats.games);
+        CHECK(stats.actions >= stats.games);
+    }
+
+    SUBCASE("Runs are reproducible from the seed")
+    {
+        Simulator first(config, vector<Policy *>(config.lineup.size(), &random_policy));
+        Simulator second(config, vector<Policy *>(config.lineup.size(), &random_policy));
+        SimulationStats a = first.run();
+        SimulationStats b = second.run();
+        CHECK(a.actions == b.actions);
+        CHECK(a.wins_by_seat == b.wins_by_seat);
+    }
+
+    SUBCASE("Greedy policies finish every game")
+    {
+        Simulator simulator(config, vector<Policy *>(config.lineup.size(), &greedy_policy));
+        SimulationStats stats = simulator.run();
+        CHECK(stats.draws == 0);
+    }
+
+    SUBCASE("Needs one policy per seat")
+    {
+        CHECK_THROWS_AS(Simulator(config, vector<Policy *>(2, &random_policy)), std::runtime_error);
+    }
+}
+
+TEST_CASE("GameState Snapshot")
+{
+    Game game;
+    Governor gov(game, "Gov");
+    Spy spy(game, "Spy");
+    Baron baron(game, "Baron");
+
+    gov.tax();
+    spy.addCoins(4);
+    spy.arrest(gov);
+    GameState saved = GameState::capture(game);
+
+    CHECK(saved.player_count == 3);
+    CHECK(saved.turn == 2);
+    CHECK(saved.players[0].coins == 2);
+    CHECK(saved.players[0].role == Role::Governor);
+    CHECK(saved.players[1].last_action == ActionType::Arrest);
+    CHECK(saved.players[1].last_arrested == 0);
+    CHECK(saved.active_count() == 3);
+
+    SUBCASE("Restore rewinds the game")
+    {
+        baron.addCoins(7);
+        baron.coup(gov);
+        CHECK_FALSE(gov.isActive());
+        CHECK(GameState::capture(game) != saved);
+
+        saved.restore(game);
+        CHECK(gov.isActive());
+        CHECK(baron.coins() == 0);
+        CHECK(game.getPlayerToSave() == nullptr);
+        CHECK(game.current_player() == &baron);
+        CHECK(spy.getLastArrestedTarget() == &gov);
+        CHECK(GameState::capture(game) == saved);
+    }
+
+    SUBCASE("Copies are independent values")
+    {
+        GameState copy = saved;
+        copy.players[0].coins = 9;
+        CHECK(saved.players[0].coins == 2);
+        CHECK(copy != saved);
+    }
+
+    SUBCASE("Restore rejects a different lineup")
+    {
+        Game other;
+        Governor a(other, "A");
+        Spy b(other, "B");
+        CHECK_THROWS_AS(saved.restore(other), std::runtime_error);
+        Judge c(other, "C");
+        CHECK_THROWS_AS(saved.restore(other), std::runtime_error);
+    }
+}
+
+TEST_CASE("Role and Action Enums")
+{
+    Game game;
+    Baron baron(game, "Barry");
+    Merchant merch(game, "Manny");
+    Player plain(game, "Plain");
+
+    CHECK(baron.roleType() == Role::Baron);
+    CHECK(merch.roleType() == Role::Merchant);
+    CHECK(plain.roleType() == Role::Player);
+    CHECK(baron.role() == "Baron");
+    CHECK(plain.role() == "player");
+
+    CHECK(baron.lastActionType() == ActionType::None);
+    CHECK(baron.getLastAction() == "");
+    baron.addCoins(3);
+    baron.invest();
+    CHECK(baron.lastActionType() == ActionType::Invest);
+    CHECK(baron.getLastAction() == "invest");
+}
+
+TEST_CASE("Legal Actions")
+{
+    Game game;
+    Governor gov(game, "Gov");
+    Baron baron(game, "Barry");
+    Merchant merch(game, "Manny");
+    General gen(game, "Gen");
+
+    SUBCASE("Only the current player gets turn actions")
+    {
+        LegalActions legal = game.legal_actions(gov);
+        CHECK(legal.can(ActionType::Gather));
+        CHECK(legal.can(ActionType::Tax));
+        CHECK_FALSE(legal.can(ActionType::Bribe));
+        CHECK_FALSE(legal.can(ActionType::Coup));
+        CHECK_FALSE(legal.can(ActionType::Invest));
+        CHECK(game.legal_actions(baron).empty());
+    }
+
+    SUBCASE("Costs and targets")
+    {
+        gov.addCoins(7);
+        merch.addCoins(1);
+        baron.addCoins(1);
+        LegalActions legal = game.legal_actions(gov);
+        CHECK(legal.can(ActionType::Bribe));
+        CHECK(legal.can(ActionType::Sanction, 1));
+        CHECK(legal.can(ActionType::Coup, 3));
+        CHECK_FALSE(legal.can(ActionType::Coup, 0));
+        CHECK(legal.can(ActionType::Arrest, 1));
+        CHECK_FALSE(legal.can(ActionType::Arrest, 2)); // Merchant cannot pay the penalty
+        CHECK_FALSE(legal.can(ActionType::Arrest, 3)); // No coins to take
+
+        Action actions[MAX_ACTIONS];
+        size_t count = legal.expand(actions, MAX_ACTIONS);
+        CHECK(count == 3 + 1 + 3 + 3);
+    }
+
+    SUBCASE("Must coup at 10 coins and no repeat arrest")
+    {
+        gov.addCoins(10);
+        LegalActions legal = game.legal_actions(gov);
+        CHECK(legal.mask == LegalActions::bit(ActionType::Coup));
+        CHECK(legal.coup_targets == 0b1110);
+
+        gov.removeCoins(10);
+        baron.addCoins(2);
+        gov.arrest(baron);
+        baron.gather();
+        merch.gather();
+        gen.gather();
+        CHECK_FALSE(game.legal_actions(gov).can(ActionType::Arrest, 1));
+    }
+
+    SUBCASE("Undo windows")
+    {
+        gov.gather();
+        baron.tax();
+        CHECK(game.legal_actions(gov).can(ActionType::Undo, 1));
+        merch.addCoins(7);
+        merch.coup(baron);
+        CHECK_FALSE(game.legal_actions(gen).can(ActionType::Undo, 1));
+        gen.addCoins(5);
+        CHECK(game.legal_actions(gen).can(ActionType::Undo, 1));
+        CHECK_FALSE(game.legal_actions(gov).can(ActionType::Undo, 1));
+    }
+
+    SUBCASE("Agrees with the throwing API")
+    {
+        gov.addCoins(3);
+        LegalActions legal = game.legal_actions(gov);
+        CHECK_FALSE(legal.can(ActionType::Bribe));
+        CHECK_THROWS_AS(gov.bribe(), std::runtime_error);
+        CHECK(legal.can(ActionType::Sanction, 2));
+        CHECK_NOTHROW(gov.sanction(merch));
+    }
+
+    SUBCASE("Undo mask agrees with try_undo() for every role")
+    {
+        const vector<vector<Role>> lineups = {
+            {Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge, Role::Merchant},
+            {Role::Judge, Role::Baron, Role::Judge, Role::Spy},
+            {Role::General, Role::Spy, Role::General, Role::Governor, Role::Merchant}};
+        size_t allowed = 0;
+        for (uint64_t g = 0; g < 30; ++g)
+        {
+            const vector<Role> &lineup = lineups[g % lineups.size()];
+            Game table;
+            vector<unique_ptr<Player>> seats;
+            for (size_t i = 0; i < lineup.size(); ++i)
+            {
+                seats.push_back(make_player(table, lineup[i], "P" + std::to_string(i)));
+                seats.back()->addCoins(static_cast<int>((g + i) % 6));
+            }
+            const vector<Player *> &players = table.get_players();
+            Position position = Position::turn(GameState::capture(table));
+
+            Action actions[MAX_ACTIONS];
+            for (uint32_t step = 0; step < 200 && !position.terminal(); ++step)
+            {
+                const GameState before = GameState::capture(table);
+                for (size_t seat = 0; seat < players.size(); ++seat)
+                {
+                    const LegalActions legal = table.legal_actions(*players[seat]);
+                    for (size_t target = 0; target < players.size(); ++target)
+                    {
+                        const Action undo = {ActionType::Undo, static_cast<int>(target)};
+                        const bool expected = table.is_legal(*players[seat], undo);
+                        CHECK(legal.can(ActionType::Undo, target) == expected);
+
+                        GameState state = before;
+                        CHECK((apply_action(state, seat, undo) == ActionResult::Ok) == expected);
+                        CHECK((players[seat]->try_undo(*players[target]) == ActionResult::Ok) == expected);
+                        allowed += expected ? 1 : 0;
+                        before.restore(table);
+                    }
+                }
+
+                CounterRng rng(17, g, step);
+                const size_t count = position.actions(actions, MAX_ACTIONS);
+                REQUIRE(count > 0);
+                position.play(actions[rng.uniform(static_cast<uint32_t>(count))]);
+                position.state.restore(table);
+            }
+        }
+        CHECK(allowed > 0);
+    }
+}
+
+TEST_CASE("Non-throwing try_* Actions")
+{
+    Game game;
+    Governor gov(game, "Gov");
+    Baron baron(game, "Barry");
+    Spy spy(game, "Spy");
+
+    CHECK(baron.try_gather() == ActionResult::NotYourTurn);
+    CHECK(gov.try_bribe() == ActionResult::NotEnoughCoins);
+    CHECK(gov.try_tax() == ActionResult::Ok);
+    CHECK(gov.coins() == 3);
+    CHECK(gov.try_undo(baron) == ActionResult::NothingToUndo);
+
+    CHECK(baron.try_invest() == ActionResult::NotEnoughCoins);
+    CHECK(baron.try_arrest(baron) == ActionResult::InvalidTarget);
+    CHECK(baron.try_arrest(spy) == ActionResult::TargetCannotPay);
+    CHECK(baron.try_coup(gov) == ActionResult::NotEnoughCoins);
+    CHECK(baron.try_arrest(gov) == ActionResult::Ok);
+    CHECK(spy.try_undo(baron) == ActionResult::Ok);
+    CHECK(gov.coins() == 3);
+
+    spy.addCoins(3);
+    CHECK(spy.try_sanction(gov) == ActionResult::Ok);
+    CHECK(gov.try_tax() == ActionResult::Sanctioned);
+    CHECK(game.current_player() == &baron);
+
+    baron.addCoins(10);
+    CHECK(baron.try_gather() == ActionResult::MustCoup);
+
+    SUBCASE("Throwing wrappers report the static message")
+    {
+        try
+        {
+            baron.gather();
+            FAIL("gather should throw");
+        }
+        catch (const std::runtime_error &e)
+        {
+            CHECK(string(e.what()) == describe(ActionResult::MustCoup));
+        }
+        CHECK_THROWS_AS(gov.undo(spy), std::runtime_error);
+    }
+}
+
+TEST_CASE("Event Sinks")
+{
+    Game game;
+    Spy spy(game, "Spy");
+    Baron baron(game, "Barry");
+
+    SUBCASE("No sink means no output")
+    {
+        CHECK(game.event_sink() == nullptr);
+        CHECK_NOTHROW(game.turn());
+        CHECK_NOTHROW(spy.spyOn(baron));
+    }
+
+    SUBCASE("Binary sink records fixed-width events")
+    {
+        BinaryEventSink sink;
+        game.set_event_sink(&sink);
+        game.turn();
+        spy.gather();
+        baron.addCoins(2);
+        baron.tax();
+        spy.spyOn(baron);
+
+        const vector<GameEvent> &events = sink.events();
+        REQUIRE(events.size() == 4);
+        CHECK(events[0].kind == EventKind::Turn);
+        CHECK(events[1].kind == EventKind::Action);
+        CHECK(events[1].action == ActionType::Gather);
+        CHECK(events[1].actor_delta == 1);
+        CHECK(events[2].actor == 1);
+        CHECK(events[2].actor_delta == 2);
+        CHECK(events[3].kind == EventKind::SpyReport);
+        CHECK(events[3].target_delta == 4);
+
+        spy.gather();
+        CHECK(events.back().action == ActionType::Gather);
+        CHECK(spy.try_arrest(baron) == ActionResult::NotYourTurn);
+        baron.tax();
+        spy.arrest(baron);
+        CHECK(events.back().action == ActionType::Arrest);
+        CHECK(events.back().target == 1);
+        CHECK(events.back().actor_delta == 1);
+        CHECK(events.back().target_delta == -1);
+
+        std::ostringstream out;
+        sink.write(out);
+        CHECK(out.str().size() == events.size() * sizeof(GameEvent));
+        game.set_event_sink(nullptr);
+    }
+
+    SUBCASE("Text sink buffers until flushed")
+    {
+        std::ostringstream out;
+        TextEventSink sink(out);
+        game.set_event_sink(&sink);
+        game.turn();
+        spy.addCoins(3);
+        spy.sanction(baron);
+        CHECK(baron.try_gather() == ActionResult::Sanctioned);
+        spy.spyOn(baron);
+        CHECK(out.str().empty());
+        sink.flush();
+        CHECK(out.str() == "Spy\n"
+                           "Spy sanction Barry\n"
+                           "Barry gather (" + string(describe(ActionResult::Sanctioned)) + ")\n"
+                           "[SPY REPORT] Spy sees that Barry has 1 coins.\n");
+        game.set_event_sink(nullptr);
+    }
+}
+
+TEST_CASE("Work-Stealing Deque")
+{
+    WorkStealingDeque deque(4);
+    size_t task = 0;
+    CHECK_FALSE(deque.take(task));
+    CHECK(deque.steal(task) == WorkStealingDeque::Status::Empty);
+
+    CHECK(deque.push(1));
+    CHECK(deque.push(2));
+    CHECK(deque.push(3));
+    CHECK(deque.push(4));
+    CHECK_FALSE(deque.push(5));
+    CHECK(deque.size() == 4);
+
+    CHECK(deque.take(task));
+    CHECK(task == 4);
+    CHECK(deque.steal(task) == WorkStealingDeque::Status::Success);
+    CHECK(task == 1);
+    CHECK(deque.push(5));
+    CHECK(deque.size() == 3);
+}
+
+TEST_CASE("Tournament Runner")
+{
+    Tournament tournament(500);
+    size_t random_bot = tournament.add_entrant("random", []
+                                               { return unique_ptr<Policy>(new RandomPolicy()); });
+    size_t greedy_bot = tournament.add_entrant("greedy", []
+                                               { return unique_ptr<Policy>(new GreedyPolicy()); });
+    vector<Role> roles = {Role::Governor, Role::Baron, Role::Merchant, Role::Spy};
+    tournament.add_rotations(roles, {random_bot, greedy_bot, random_bot, greedy_bot}, 10, 3, 99);
+    CHECK(tournament.matches().size() == 12);
+
+    TournamentResult single = tournament.run(1);
+    TournamentResult parallel = tournament.run(4);
+
+    CHECK(single.matches == 12);
+    CHECK(single.games == 120);
+    CHECK(parallel.games == single.games);
+    CHECK(parallel.actions == single.actions);
+    CHECK(parallel.draws == single.draws);
+    CHECK(parallel.by_entrant[random_bot].wins == single.by_entrant[random_bot].wins);
+    CHECK(parallel.by_role[static_cast<size_t>(Role::Baron)].wins == single.by_role[static_cast<size_t>(Role::Baron)].wins);
+    CHECK(single.by_entrant[greedy_bot].games == 240);
+
+    CHECK_THROWS_AS(tournament.add_match(Match{{Role::Governor, Role::Spy}, {random_bot}, 1, 1}), std::runtime_error);
+    CHECK_THROWS_AS(tournament.add_match(Match{{Role::Governor, Role::Spy}, {random_bot, 7}, 1, 1}), std::runtime_error);
+
+    // A worker that fails hands its exception to run() instead of terminating.
+    size_t broken_bot = tournament.add_entrant("broken", []() -> unique_ptr<Policy>
+                                               { throw std::runtime_error("no policy"); });
+    tournament.add_match(Match{{Role::Governor, Role::Spy}, {random_bot, broken_bot}, 1, 1});
+    CHECK_THROWS_AS(tournament.run(1), std::runtime_error);
+    CHECK_THROWS_AS(tournament.run(4), std::runtime_error);
+}
+
+TEST_CASE("Counter-Based RNG")
+{
+    SUBCASE("Philox4x32-10 known answers")
+    {
+        PhiloxBlock zero = philox4x32({0, 0, 0, 0}, {0, 0});
+        CHECK(zero == PhiloxBlock{0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u});
+        PhiloxBlock ones = philox4x32({0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu}, {0xffffffffu, 0xffffffffu});
+        CHECK(ones == PhiloxBlock{0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu});
+    }
+
+    SUBCASE("Streams depend only on (seed, game, turn)")
+    {
+        CounterRng a(42, 7, 3);
+        CounterRng b(42, 7, 3);
+        CounterRng other_turn(42, 7, 4);
+        CounterRng other_game(42, 8, 3);
+        bool differs_turn = false;
+        bool differs_game = false;
+        for (int i = 0; i < 16; ++i)
+        {
+            uint32_t x = a();
+            CHECK(x == b());
+            differs_turn = differs_turn || x != other_turn();
+            differs_game = differs_game || x != other_game();
+        }
+        CHECK(differs_turn);
+        CHECK(differs_game);
+    }
+
+    SUBCASE("Bounded draws stay in range")
+    {
+        CounterRng rng(1, 2, 3);
+        for (int i = 0; i < 200; ++i)
+        {
+            CHECK(rng.uniform(6) < 6u);
+            double r = rng.uniform_real();
+            CHECK((r >= 0.0 && r < 1.0));
+        }
+    }
+
+    SUBCASE("A game from a batch replays alone")
+    {
+        SimulationConfig config;
+        config.lineup = {Role::Governor, Role::Spy, Role::Baron, Role::General};
+        config.games = 20;
+        config.seed = 5;
+        RandomPolicy policy;
+        Simulator batch(config, vector<Policy *>(4, &policy));
+
+        vector<int> winners;
+        vector<size_t> lengths;
+        SimulationStats stats;
+        for (uint64_t g = 0; g < config.games; ++g)
+        {
+            size_t before = stats.actions;
+            winners.push_back(batch.play_one(g, stats));
+            lengths.push_back(stats.actions - before);
+        }
+
+        Simulator alone(config, vector<Policy *>(4, &policy));
+        SimulationStats single;
+        CHECK(alone.play_one(13, single) == winners[13]);
+        CHECK(single.actions == lengths[13]);
+    }
+}
+
+TEST_CASE("Binary Game Log")
+{
+    const string path = "coup_test_log.bin";
+    SimulationConfig config;
+    config.lineup = {Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge, Role::Merchant};
+    config.games = 25;
+    config.seed = 9;
+    RandomPolicy policy;
+
+    vector<int> winners;
+    size_t logged_actions = 0;
+    {
+        GameLogWriter writer(path);
+        config.log = &writer;
+        Simulator simulator(config, vector<Policy *>(config.lineup.size(), &policy));
+        SimulationStats stats;
+        for (size_t g = 0; g < config.games; ++g)
+        {
+            winners.push_back(simulator.play_one(g, stats));
+        }
+        logged_actions = stats.actions + stats.undos;
+    }
+
+    GameLogReader reader(path);
+    REQUIRE(reader.games().size() == config.games);
+    size_t replayed = 0;
+    for (size_t g = 0; g < config.games; ++g)
+    {
+        const LoggedGame &logged = reader.games()[g];
+        CHECK(logged.player_count == config.lineup.size());
+        Game game;
+        vector<unique_ptr<Player>> seats;
+        for (size_t i = 0; i < config.lineup.size(); ++i)
+        {
+            seats.push_back(make_player(game, logged.roles[i], "P" + std::to_string(i)));
+        }
+        replayed += reader.replay(logged, game);
+        if (winners[g] >= 0)
+        {
+            CHECK(game.winner() == "P" + std::to_string(winners[g]));
+        }
+    }
+    CHECK(replayed == logged_actions);
+
+    SUBCASE("Mismatched roles are rejected")
+    {
+        Game game;
+        Governor a(game, "A");
+        Governor b(game, "B");
+        CHECK_THROWS_AS(reader.replay(reader.games()[0], game), std::runtime_error);
+    }
+
+    SUBCASE("Files that are not logs are rejected")
+    {
+        {
+            std::ofstream junk("coup_test_junk.bin", std::ios::binary);
+            junk << "definitely not a game log";
+        }
+        CHECK_THROWS_AS(GameLogReader("coup_test_junk.bin"), std::runtime_error);
+        std::remove("coup_test_junk.bin");
+    }
+
+    SUBCASE("A sink already attached keeps its events")
+    {
+        Game game;
+        Governor gov(game, "Gov");
+        Spy spy(game, "Spy");
+        BinaryEventSink sink;
+        game.set_event_sink(&sink);
+        {
+            GameLogWriter writer(path);
+            writer.begin(game);
+            gov.gather();
+            spy.tax();
+            gov.undo(spy);
+            CHECK(sink.events().size() >= 3);
+            writer.end();
+            CHECK(game.event_sink() == &sink);
+        }
+        GameLogReader chained(path);
+        REQUIRE(chained.games().size() == 1);
+        CHECK(chained.games()[0].record_count == 3);
+    }
+
+    SUBCASE("Refused actions leave nothing unlogged")
+    {
+        {
+            Game game;
+            Governor gov(game, "Gov");
+            Baron baron(game, "Baron");
+            GameLogWriter writer(path);
+            writer.begin(game);
+            gov.addCoins(3);
+            gov.sanction(baron);
+            CHECK(baron.try_arrest(baron) == ActionResult::InvalidTarget);
+            CHECK(baron.try_bribe() == ActionResult::NotEnoughCoins);
+            CHECK(baron.isSanctioned());
+            CHECK(baron.try_gather() == ActionResult::Sanctioned);
+            writer.end();
+        }
+        GameLogReader refused(path);
+        REQUIRE(refused.games().size() == 1);
+        Game game;
+        Governor gov(game, "Gov");
+        Baron baron(game, "Baron");
+        gov.addCoins(3); // Set-up coins are not logged.
+        CHECK(refused.replay(refused.games()[0], game) == 2);
+        CHECK_FALSE(baron.isSanctioned());
+    }
+
+    SUBCASE("Failed writes are reported by end()")
+    {
+        std::FILE *probe = std::fopen("/dev/full", "wb");
+        if (probe != nullptr)
+        {
+            std::fclose(probe);
+            Game game;
+            Governor gov(game, "Gov");
+            Spy spy(game, "Spy");
+            GameLogWriter full("/dev/full");
+            full.begin(game);
+            gov.gather();
+            CHECK_THROWS_AS(full.end(), std::runtime_error);
+            CHECK(game.event_sink() == nullptr);
+            CHECK_NOTHROW(full.end());
+        }
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Zobrist Hash")
+{
+    SUBCASE("Incremental hash matches a full rehash after every action")
+    {
+        for (uint64_t g = 0; g < 20; ++g)
+        {
+            Game game;
+            vector<unique_ptr<Player>> seats;
+            const vector<Role> lineup = {Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge, Role::Merchant};
+            for (size_t i = 0; i < lineup.size(); ++i)
+            {
+                seats.push_back(make_player(game, lineup[i], "P" + std::to_string(i)));
+            }
+            const vector<Player *> &players = game.get_players();
+            CHECK(game.hash() == GameState::capture(game).hash());
+
+            Action legal[MAX_ACTIONS];
+            for (uint32_t step = 0; step < 300 && game.active_players_count() > 1; ++step)
+            {
+                CounterRng rng(3, g, step);
+                Player &actor = *game.current_player();
+                LegalActions turn_actions = game.legal_actions(actor);
+                turn_actions.forbid(ActionType::Undo);
+                const Action action = legal[rng.uniform(static_cast<uint32_t>(turn_actions.expand(legal, MAX_ACTIONS)))];
+                switch (action.type)
+                {
+                case ActionType::Gather:
+                    actor.try_gather();
+                    break;
+                case ActionType::Tax:
+                    actor.try_tax();
+                    break;
+                case ActionType::Bribe:
+                    actor.try_bribe();
+                    break;
+                case ActionType::Invest:
+                    static_cast<Baron &>(actor).try_invest();
+                    break;
+                case ActionType::Arrest:
+                    actor.try_arrest(*players[action.target]);
+                    break;
+                case ActionType::Sanction:
+                    actor.try_sanction(*players[action.target]);
+                    break;
+                default:
+                    actor.try_coup(*players[action.target]);
+                    break;
+                }
+                REQUIRE(game.hash() == GameState::capture(game).hash());
+
+                for (Player *reactor : players)
+                {
+                    LegalActions undos = game.legal_actions(*reactor);
+                    if (reactor != &actor && undos.can(ActionType::Undo) && rng.bernoulli(0.5))
+                    {
+                        reactor->try_undo(*players[__builtin_ctzll(undos.targets(ActionType::Undo))]);
+                        REQUIRE(game.hash() == GameState::capture(game).hash());
+                    }
+                }
+            }
+        }
+    }
+
+    SUBCASE("Equal states hash equal, different states differ")
+    {
+        Game game;
+        Governor governor(game, "Gov");
+        Spy spy(game, "Spy");
+        const uint64_t start = game.hash();
+        GameState before = GameState::capture(game);
+
+        governor.gather();
+        CHECK(game.hash() != start);
+        spy.gather();
+        const uint64_t after_two = game.hash();
+
+        before.restore(game);
+        CHECK(game.hash() == start);
+        governor.gather();
+        spy.gather();
+        CHECK(game.hash() == after_two);
+
+        spy.setSanctioned(true);
+        CHECK(game.hash() != after_two);
+        spy.setSanctioned(false);
+        CHECK(game.hash() == after_two);
+    }
+}
+
+TEST_CASE("State Rules Engine")
+{
+    SUBCASE("Positions follow Game move for move")
+    {
+        const vector<vector<Role>> lineups = {
+            {Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge, Role::Merchant},
+            {Role::Merchant, Role::Governor, Role::Judge},
+            {Role::General, Role::Spy, Role::Governor, Role::Baron}};
+        for (uint64_t g = 0; g < 30; ++g)
+        {
+            const vector<Role> &lineup = lineups[g % lineups.size()];
+            Game game;
+            vector<unique_ptr<Player>> seats;
+            for (size_t i = 0; i < lineup.size(); ++i)
+            {
+                seats.push_back(make_player(game, lineup[i], "P" + std::to_string(i)));
+                // Rich starts exercise the Merchant bonus and the must-coup rule early.
+                seats.back()->addCoins(static_cast<int>((g + i) % 5));
+            }
+            const vector<Player *> &players = game.get_players();
+            Position position = Position::turn(GameState::capture(game));
+
+            Action actions[MAX_ACTIONS];
+            for (uint32_t step = 0; step < 400 && !position.terminal(); ++step)
+            {
+                if (position.phase == Position::TURN)
+                {
+                    Player &actor = *game.current_player();
+                    REQUIRE(game.seat_of(actor) == position.seat);
+                    LegalActions expected = game.legal_actions(actor);
+                    expected.forbid(ActionType::Undo);
+                    LegalActions got = legal_actions(position.state, position.seat);
+                    got.forbid(ActionType::Undo);
+                    CHECK(got.mask == expected.mask);
+                    CHECK(got.arrest_targets == expected.arrest_targets);
+                    CHECK(got.sanction_targets == expected.sanction_targets);
+                    CHECK(got.coup_targets == expected.coup_targets);
+                }
+
+                CounterRng rng(11, g, step);
+                const size_t count = position.actions(actions, MAX_ACTIONS);
+                REQUIRE(count > 0);
+                const Action action = actions[rng.uniform(static_cast<uint32_t>(count))];
+                Player &mover = *players[position.seat];
+                Player *target = action.target == NO_TARGET ? nullptr : players[action.target];
+                ActionResult result = ActionResult::Ok;
+                switch (action.type)
+                {
+                case ActionType::Gather:
+                    result = mover.try_gather();
+                    break;
+                case ActionType::Tax:
+                    result = mover.try_tax();
+                    break;
+                case ActionType::Bribe:
+                    result = mover.try_bribe();
+                    break;
+                case ActionType::Invest:
+                    result = static_cast<Baron &>(mover).try_invest();
+                    break;
+                case ActionType::Arrest:
+                    result = mover.try_arrest(*target);
+                    break;
+                case ActionType::Sanction:
+                    result = mover.try_sanction(*target);
+                    break;
+                case ActionType::Coup:
+                    result = mover.try_coup(*target);
+                    break;
+                case ActionType::Undo:
+                    result = mover.try_undo(*target);
+                    break;
+                case ActionType::None:
+                    break;
+                }
+                CHECK((result == ActionResult::Ok || result == ActionResult::Sanctioned));
+                position.play(action);
+                REQUIRE(GameState::capture(game) == position.state);
+            }
+        }
+    }
+
+    SUBCASE("Refusals match the try_* actions")
+    {
+        Game game;
+        Governor governor(game, "Gov");
+        Baron baron(game, "Baron");
+        GameState state = GameState::capture(game);
+
+        CHECK(apply_action(state, 1, {ActionType::Gather, NO_TARGET}) == baron.try_gather());
+        CHECK(apply_action(state, 0, {ActionType::Bribe, NO_TARGET}) == governor.try_bribe());
+        CHECK(apply_action(state, 0, {ActionType::Coup, 1}) == governor.try_coup(baron));
+        CHECK(apply_action(state, 0, {ActionType::Arrest, 0}) == governor.try_arrest(governor));
+        CHECK(apply_action(state, 0, {ActionType::Undo, 1}) == governor.try_undo(baron));
+        CHECK(apply_action(state, 0, {ActionType::Invest, NO_TARGET}) == ActionResult::InvalidTarget);
+        CHECK(GameState::capture(game) == state);
+    }
+}
+
+TEST_CASE("MCTS Bot")
+{
+    MctsConfig config;
+    config.iterations = 2000;
+
+    SUBCASE("Takes a winning coup")
+    {
+        Game game;
+        Governor governor(game, "Gov");
+        Spy spy(game, "Spy");
+        governor.addCoins(8);
+        spy.addCoins(7); // Anything but a coup lets the spy coup first.
+        Mcts search(config);
+        const Action best = search.search(Position::turn(GameState::capture(game)), 0);
+        CHECK(best.type == ActionType::Coup);
+        CHECK(best.target == 1);
+        CHECK(search.stats().iterations == 2000);
+        CHECK(search.stats().nodes > 1);
+    }
+
+    SUBCASE("Searches are reproducible")
+    {
+        Game game;
+        Baron baron(game, "Baron");
+        Judge judge(game, "Judge");
+        General general(game, "General");
+        baron.addCoins(3);
+        const Position root = Position::turn(GameState::capture(game));
+        Mcts a(config);
+        Mcts b(config);
+        const Action first = a.search(root, 42);
+        const Action second = b.search(root, 42);
+        CHECK(first.type == second.type);
+        CHECK(first.target == second.target);
+        CHECK(a.node(0).visits == b.node(0).visits);
+    }
+
+    SUBCASE("Beats random play heads-up")
+    {
+        config.iterations = 300;
+        SimulationConfig sim;
+        sim.lineup = {Role::Baron, Role::Spy};
+        sim.games = 20;
+        MctsPolicy mcts(config);
+        RandomPolicy random;
+        Simulator simulator(sim, {&mcts, &random});
+        SimulationStats stats = simulator.run();
+        CHECK(stats.wins_by_seat[0] > stats.wins_by_seat[1]);
+    }
+
+    SUBCASE("Needs a budget and room for the root")
+    {
+        MctsConfig bad;
+        bad.iterations = 0;
+        CHECK_THROWS_AS(Mcts{bad}, std::runtime_error);
+        bad.iterations = 10;
+        bad.max_nodes = 4;
+        CHECK_THROWS_AS(Mcts{bad}, std::runtime_error);
+    }
+}
+
+TEST_CASE("Tree-Parallel MCTS")
+{
+    MctsConfig config;
+    config.iterations = 4000;
+    config.threads = 4;
+
+    SUBCASE("Threads share one tree and spend the budget exactly")
+    {
+        Game game;
+        Governor governor(game, "Gov");
+        Spy spy(game, "Spy");
+        governor.addCoins(8);
+        spy.addCoins(7);
+        ParallelMcts search(config);
+        const Action best = search.search(Position::turn(GameState::capture(game)), 0);
+        CHECK(best.type == ActionType::Coup);
+        CHECK(best.target == 1);
+        CHECK(search.stats().iterations == 4000);
+
+        // Every virtual loss was taken back and the children add up to the root.
+        const ParallelMctsNode &root = search.node(0);
+        CHECK(root.pending.load() == 0);
+        uint32_t children = 0;
+        for (uint32_t c = root.first_child; c < root.first_child + root.child_count; ++c)
+        {
+            CHECK(search.node(c).pending.load() == 0);
+            children += search.node(c).visits.load();
+        }
+        CHECK(children == root.visits.load());
+        CHECK(search.node(root.first_child).mean() >= 0.0);
+
+        // The same pooled workers serve every later search.
+        for (std::uint64_t move = 1; move <= 20; ++move)
+        {
+            CHECK(search.search(Position::turn(GameState::capture(game)), move).type == ActionType::Coup);
+            CHECK(search.stats().iterations == 4000);
+            CHECK(search.node(0).pending.load() == 0);
+        }
+    }
+
+    SUBCASE("Time budget")
+    {
+        config.iterations = 0;
+        config.seconds = 0.05;
+        Game game;
+        Baron baron(game, "Baron");
+        Merchant merchant(game, "Merchant");
+        ParallelMcts search(config);
+        search.search(Position::turn(GameState::capture(game)), 1);
+        CHECK(search.stats().iterations > 0);
+        CHECK(search.stats().seconds < 1.0);
+    }
+
+    SUBCASE("MctsPolicy uses the parallel search")
+    {
+        config.iterations = 200;
+        SimulationConfig sim;
+        sim.lineup = {Role::Governor, Role::Judge};
+        sim.games = 2;
+        MctsPolicy mcts(config);
+        RandomPolicy random;
+        Simulator simulator(sim, {&mcts, &random});
+        simulator.run();
+        CHECK(mcts.last_search().iterations == 200);
+    }
+}
+
+TEST_CASE("Hidden Coins and ISMCTS")
+{
+    SUBCASE("Coins are only visible to their owner and to a spy who looked")
+    {
+        Game game;
+        Spy spy(game, "Spy");
+        Baron baron(game, "Baron");
+        Judge judge(game, "Judge");
+        CHECK(game.can_see_coins(judge, baron));
+
+        game.set_hidden_coins(true);
+        CHECK(game.can_see_coins(baron, baron));
+        CHECK_FALSE(game.can_see_coins(judge, baron));
+        CHECK_FALSE(game.can_see_coins(spy, baron));
+
+        spy.spyOn(baron);
+        CHECK(game.can_see_coins(spy, baron));
+        CHECK_FALSE(game.can_see_coins(judge, baron));
+        CHECK_FALSE(game.can_see_coins(baron, spy));
+
+        spy.gather(); // The spy's coins change, the baron's do not.
+        CHECK(game.can_see_coins(spy, baron));
+        baron.gather();
+        CHECK_FALSE(game.can_see_coins(spy, baron));
+    }
+
+    SUBCASE("Information sets hide what the observer cannot see")
+    {
+        Game game;
+        Spy spy(game, "Spy");
+        Governor governor(game, "Gov");
+        General general(game, "General");
+        governor.addCoins(4);
+        general.addCoins(6);
+        spy.addCoins(2);
+        game.set_hidden_coins(true);
+        spy.spyOn(general);
+
+        InformationSet info = InformationSet::observe(game, spy);
+        CHECK(info.observer == 0);
+        CHECK_FALSE(info.is_hidden(0));
+        CHECK(info.is_hidden(1));
+        CHECK_FALSE(info.is_hidden(2));
+        CHECK(info.state.players[0].coins == 2);
+        CHECK(info.state.players[1].coins == 0);
+        CHECK(info.state.players[2].coins == 6);
+
+        const InformationSet spied = InformationSet::observe(game, spy, true);
+        CHECK(spied.hidden == 0);
+        CHECK(spied.state.players[1].coins == 4);
+        CHECK(InformationSet::observe(game, governor, true).hidden == InformationSet::observe(game, governor).hidden);
+        CHECK_FALSE(game.can_see_coins(spy, governor));
+
+        // A governor can end its turn with 12 coins (tax from 9), and no more.
+        int most = 0;
+        for (uint32_t i = 0; i < 300; ++i)
+        {
+            CounterRng rng(1, 2, i);
+            GameState guess = info.state;
+            info.determinize(guess, rng);
+            most = std::max<int>(most, guess.players[1].coins);
+            guess.players[1].coins = 0;
+            CHECK(guess == info.state);
+        }
+        CHECK(most == MUST_COUP_COINS - 1 + GOVERNOR_TAX_AMOUNT);
+
+        // Restoring a snapshot may change the coins, so earlier reveals go stale.
+        CHECK(game.can_see_coins(spy, general));
+        GameState::capture(game).restore(game);
+        CHECK_FALSE(game.can_see_coins(spy, general));
+    }
+
+    SUBCASE("Searches one tree over many guesses")
+    {
+        Game game;
+        Governor governor(game, "Gov");
+        Spy spy(game, "Spy");
+        governor.addCoins(8);
+        spy.addCoins(7);
+        game.set_hidden_coins(true);
+
+        MctsConfig config;
+        config.iterations = 3000;
+        config.determinizations = 10;
+        Ismcts search(config);
+        const InformationSet info = InformationSet::observe(game, governor);
+        const Action best = search.search(Position::turn(info.state), info, 7);
+        CHECK(best.type == ActionType::Coup);
+        CHECK(search.stats().iterations == 3000);
+        CHECK(search.node(0).visits == 3000);
+
+        const Action legal[] = {{ActionType::Gather, NO_TARGET}, {ActionType::Coup, 1}};
+        CHECK(search.best_of(legal, 2).type == ActionType::Coup);
+    }
+
+    SUBCASE("A spy chooses without touching the game")
+    {
+        Game game;
+        Spy spy(game, "Spy");
+        Governor governor(game, "Gov");
+        Baron baron(game, "Baron");
+        governor.addCoins(5);
+        game.set_hidden_coins(true);
+        BinaryEventSink sink;
+        game.set_event_sink(&sink);
+        const uint64_t hash = game.hash();
+
+        MctsConfig config;
+        config.iterations = 200;
+        IsmctsPolicy ismcts(config);
+        Action legal[MAX_ACTIONS];
+        const size_t count = game.legal_actions(spy).expand(legal, MAX_ACTIONS);
+        CounterRng rng(4, 0, 0);
+        ismcts.choose(game, spy, legal, count, rng);
+        CHECK(ismcts.last_search().iterations > 0);
+        CHECK(game.hash() == hash);
+        CHECK(sink.events().empty());
+        CHECK_FALSE(game.can_see_coins(spy, governor));
+        CHECK_FALSE(game.can_see_coins(spy, baron));
+    }
+
+    SUBCASE("Plays full hidden-coin games")
+    {
+        MctsConfig config;
+        config.iterations = 300;
+        config.determinizations = 5;
+        SimulationConfig sim;
+        sim.lineup = {Role::Spy, Role::Governor};
+        sim.games = 10;
+        sim.hidden_coins = true;
+        IsmctsPolicy ismcts(config);
+        RandomPolicy random;
+        Simulator simulator(sim, {&ismcts, &random});
+        SimulationStats stats = simulator.run();
+        CHECK(stats.games == 10);
+        CHECK(stats.wins_by_seat[0] > stats.wins_by_seat[1]);
+        CHECK(ismcts.last_search().iterations > 0);
+    }
+}
+
+TEST_CASE("Endgame Tablebase")
+{
+    const string path = "coup_test_tablebase.bin";
+    Tablebase::build(path, {Role::Spy, Role::Governor});
+    Tablebase tablebase(path);
+    CHECK(tablebase.has(Role::Governor, Role::Spy));
+    CHECK(tablebase.has(Role::Spy, Role::Governor));
+    CHECK(tablebase.has(Role::Spy, Role::Spy));
+    CHECK_FALSE(tablebase.has(Role::Governor, Role::Baron));
+
+    // A player who can afford a coup wins with it.
+    Game game;
+    Spy spy(game, "Spy");
+    Governor governor(game, "Gov");
+    spy.addCoins(7);
+    spy.gather();
+    EndgameValue value;
+    REQUIRE(tablebase.lookup(Position::turn(GameState::capture(game)), value));
+    CHECK(value.result == EndgameResult::Loss);
+    governor.addCoins(7);
+    REQUIRE(tablebase.lookup(Position::turn(GameState::capture(game)), value));
+    CHECK(value.result == EndgameResult::Win);
+    CHECK(value.distance == 1);
+
+    // Every tabled value agrees with the best value among its successors.
+    size_t checked = 0;
+    for (std::uint32_t g = 0; g < 40; ++g)
+    {
+        GameState start = GameState::capture(game);
+        start.players[0].coins = static_cast<std::uint8_t>(g % 8);
+        start.players[1].coins = static_cast<std::uint8_t>(g / 8);
+        Position position = Position::turn(start);
+        CounterRng rng(5, g, 0);
+        Action actions[MAX_ACTIONS];
+        for (size_t ply = 0; ply < 60 && !position.terminal(); ++ply)
+        {
+            const size_t count = position.actions(actions, MAX_ACTIONS);
+            EndgameValue here;
+            if (tablebase.lookup(position, here))
+            {
+                EndgameValue best = {EndgameResult::Loss, 0};
+                for (size_t i = 0; i < count; ++i)
+                {
+                    Position next = position;
+                    next.play(actions[i]);
+                    EndgameValue after = {EndgameResult::Win, 0};
+                    if (!next.terminal())
+                    {
+                        REQUIRE(tablebase.lookup(next, after));
+                        if (next.seat != position.seat && after.result != EndgameResult::Draw)
+                        {
+                            after.result = after.result == EndgameResult::Win ? EndgameResult::Loss : EndgameResult::Win;
+                        }
+                    }
+                    after.distance = static_cast<std::uint8_t>(after.distance + 1);
+                    if (i == 0 || better(after, best))
+                    {
+                        best = after;
+                    }
+                }
+                CHECK(best.result == here.result);
+                if (here.result != EndgameResult::Draw)
+                {
+                    CHECK(best.distance == here.distance);
+                }
+                ++checked;
+            }
+            position.play(actions[rng.uniform(static_cast<std::uint32_t>(count))]);
+        }
+    }
+    CHECK(checked > 100);
+
+    // The Governor moving first has a forced win, and the tablebase never lets it slip.
+    {
+        Game opening;
+        Governor first(opening, "Gov");
+        Spy second(opening, "Spy");
+        REQUIRE(tablebase.lookup(Position::turn(GameState::capture(opening)), value));
+        CHECK(value.result == EndgameResult::Win);
+        CHECK(value.distance == 10);
+    }
+    RandomPolicy random;
+    EndgamePolicy endgame(tablebase, random);
+    SimulationConfig sim;
+    sim.lineup = {Role::Governor, Role::Spy};
+    sim.games = 20;
+    Simulator simulator(sim, {&endgame, &random});
+    SimulationStats stats = simulator.run();
+    CHECK(stats.wins_by_seat[0] == sim.games);
+
+    SUBCASE("Files that are not tablebases are rejected")
+    {
+        {
+            std::ofstream junk("coup_test_junk.bin", std::ios::binary);
+            junk << "definitely not a tablebase";
+        }
+        CHECK_THROWS_AS(Tablebase("coup_test_junk.bin"), std::runtime_error);
+        std::remove("coup_test_junk.bin");
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Vectorized Environment")
+{
+    for (std::uint32_t i = 0; i < VEC_ACTION_COUNT; ++i)
+    {
+        const Action action = action_at(i);
+        if (action.target != NO_TARGET || i % GameState::MAX_PLAYERS == 0)
+        {
+            CHECK(action_index(action) == i);
+        }
+    }
+
+    VecEnvConfig config;
+    config.envs = 64;
+    config.lineup = {Role::Governor, Role::Spy, Role::Judge};
+    config.max_actions = 100;
+    VecEnv env(config);
+    REQUIRE(env.envs() == 64);
+
+    const size_t n = env.envs();
+    vector<float> observations(n * VecEnv::OBSERVATION_SIZE);
+    vector<float> rewards(n);
+    vector<std::uint8_t> dones(n);
+    vector<std::uint64_t> masks(n);
+    vector<std::uint32_t> actions(n);
+    env.reset(observations.data(), masks.data());
+    const vector<float> first(observations.begin(), observations.begin() + VecEnv::OBSERVATION_SIZE);
+    // Seat 0 decides first: it is active and plays the Governor.
+    CHECK(first[0] == 1.0f);
+    CHECK(first[4 + size_t(Role::Governor)] == 1.0f);
+
+    // Replays game 0 on its own Position alongside the batch.
+    Position shadow = env.position(0);
+    size_t finished = 0;
+    size_t wins = 0;
+    for (std::uint32_t step = 0; step < 2000; ++step)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            REQUIRE(masks[i] != 0);
+            CounterRng rng(3, i, step);
+            std::uint32_t pick = rng.uniform(static_cast<std::uint32_t>(__builtin_popcountll(masks[i])));
+            std::uint64_t bits = masks[i];
+            while (pick-- > 0)
+            {
+                bits &= bits - 1;
+            }
+            actions[i] = static_cast<std::uint32_t>(__builtin_ctzll(bits));
+        }
+        shadow.play(action_at(actions[0]));
+        env.step(actions.data(), observations.data(), rewards.data(), dones.data(), masks.data());
+        if (dones[0])
+        {
+            shadow = env.position(0);
+            CHECK(std::equal(first.begin(), first.end(), observations.begin()));
+        }
+        CHECK(shadow.state == env.position(0).state);
+        Action legal[MAX_ACTIONS];
+        const size_t count = shadow.actions(legal, MAX_ACTIONS);
+        std::uint64_t expected = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            expected |= std::uint64_t(1) << action_index(legal[i]);
+        }
+        CHECK(masks[0] == expected);
+        for (size_t i = 0; i < n; ++i)
+        {
+            finished += dones[i];
+            wins += rewards[i] == 1.0f;
+            CHECK((rewards[i] == 0.0f || dones[i]));
+        }
+    }
+    CHECK(finished > 100);
+    CHECK(wins > 0);
+
+    // Illegal actions are refused per game, even when the caller's mask allows them.
+    env.reset(observations.data(), masks.data());
+    const std::uint64_t legal_first = masks[0];
+    actions.assign(n, action_index({ActionType::Coup, 1}));
+    actions[1] = action_index({ActionType::Gather, NO_TARGET});
+    actions[2] = static_cast<std::uint32_t>(VEC_ACTION_COUNT);
+    masks.assign(n, ~std::uint64_t(0));
+    vector<std::uint8_t> refused(n);
+    CHECK(env.step(actions.data(), observations.data(), rewards.data(), dones.data(), masks.data(), refused.data()) == n - 1);
+    CHECK(refused[0] == 1);
+    CHECK(refused[1] == 0);
+    CHECK(refused[2] == 1);
+    CHECK(rewards[0] == config.illegal_reward);
+    CHECK(rewards[1] == 0.0f);
+    CHECK(dones[0] == 0);
+    CHECK(masks[0] == legal_first);
+    CHECK(std::equal(first.begin(), first.end(), observations.begin()));
+    CHECK(env.position(0).state == env.position(3).state);
+    CHECK(!(env.position(1).state == env.position(0).state));
+}
+
+TEST_CASE("SIMD Batch Engine")
+{
+    const vector<Role> lineup = {Role::Baron, Role::Governor, Role::Merchant, Role::Judge, Role::Spy};
+    const ActionType economic[] = {ActionType::Gather, ActionType::Tax, ActionType::Invest, ActionType::Bribe,
+                                   ActionType::Coup};
+    const size_t games = 101; // Leaves a scalar tail after the vector blocks.
+    const BatchIsa isas[] = {BatchIsa::Scalar, BatchIsa::Sse2, BatchIsa::Avx2};
+
+    for (BatchIsa isa : isas)
+    {
+        BatchEngine batch(games, lineup);
+        if (isa != BatchIsa::Scalar && BatchEngine::best_isa() < isa)
+        {
+            CHECK_THROWS_AS(batch.set_isa(isa), std::runtime_error);
+            continue;
+        }
+        batch.set_isa(isa);
+        CAPTURE(string(to_string(isa)));
+
+        // Random started positions, so forfeits, extra actions and forced coups all occur.
+        vector<GameState> reference(games);
+        for (size_t g = 0; g < games; ++g)
+        {
+            CounterRng rng(11, g, 0);
+            GameState state = batch.store(g);
+            for (size_t s = 0; s < lineup.size(); ++s)
+            {
+                state.players[s].coins = static_cast<std::uint8_t>(rng.uniform(12));
+                state.players[s].set(PlayerState::SANCTIONED, rng.bernoulli(0.3));
+            }
+            state.turn = static_cast<std::uint8_t>(rng.uniform(static_cast<std::uint32_t>(lineup.size())));
+            state.players[state.turn].set(PlayerState::EXTRA_ACTION, rng.bernoulli(0.3));
+            batch.load(g, state);
+            reference[g] = state;
+        }
+
+        vector<ActionType> actions(games);
+        vector<std::int8_t> targets(games);
+        vector<ActionResult> results(games);
+        size_t refused = 0;
+        for (std::uint32_t step = 1; step < 300; ++step)
+        {
+            for (size_t g = 0; g < games; ++g)
+            {
+                CounterRng rng(11, g, step);
+                actions[g] = economic[rng.uniform(5)];
+                targets[g] = static_cast<std::int8_t>(static_cast<int>(rng.uniform(7)) - 1);
+            }
+            batch.step(actions.data(), targets.data(), results.data());
+            for (size_t g = 0; g < games; ++g)
+            {
+                GameState &expected = reference[g];
+                const ActionResult result = apply_action(expected, current_seat(expected),
+                                                         {actions[g], targets[g]});
+                REQUIRE(results[g] == result);
+                refused += result != ActionResult::Ok;
+                const GameState actual = batch.store(g);
+                CHECK(batch.turn(g) == current_seat(expected));
+                for (size_t s = 0; s < lineup.size(); ++s)
+                {
+                    CHECK(actual.players[s].coins == expected.players[s].coins);
+                    CHECK(actual.players[s].flags == expected.players[s].flags);
+                }
+                if (expected.active_count() < 2)
+                {
+                    expected = actual;
+                    expected.players[(current_seat(actual) + 1) % lineup.size()].set(PlayerState::ACTIVE, true);
+                    batch.load(g, expected);
+                }
+            }
+        }
+        CHECK(refused > 0);
+    }
+
+    BatchEngine batch(4, {Role::Governor, Role::Spy});
+    CHECK(batch.coins(3, 1) == 0);
+    CHECK(batch.is_active(3, 1));
+    const ActionType arrests[] = {ActionType::Gather, ActionType::Arrest, ActionType::Gather, ActionType::Gather};
+    const std::int8_t targets[] = {NO_TARGET, 1, NO_TARGET, NO_TARGET};
+    ActionResult results[4];
+    CHECK_THROWS_AS(batch.step(arrests, targets, results), std::runtime_error);
+    CHECK(batch.coins(0, 0) == 0);
+}
+
+TEST_CASE("Game Reset and Pooling")
+{
+    Game game;
+    Governor governor(game, "Gov");
+    Spy spy(game, "Spy");
+    Merchant merchant(game, "Merchant");
+    const GameState fresh = GameState::capture(game);
+    const std::uint64_t fresh_hash = game.hash();
+
+    game.set_hidden_coins(true);
+    governor.tax();
+    spy.gather();
+    spy.spyOn(merchant);
+    merchant.gather();
+    governor.arrest(spy);
+    spy.undo(governor);
+    CHECK(GameState::capture(game) != fresh);
+
+    game.reset();
+    CHECK(GameState::capture(game) == fresh);
+    CHECK(game.hash() == fresh_hash);
+    CHECK(game.hidden_coins());
+    CHECK_FALSE(game.can_see_coins(spy, merchant));
+    CHECK(game.turn() == "Gov");
+    CHECK(governor.getLastArrestedTarget() == nullptr);
+    governor.gather();
+    CHECK(game.hash() == GameState::capture(game).hash());
+
+    SUBCASE("A pool hands back the same game for the same lineup")
+    {
+        GamePool pool;
+        std::unique_ptr<PooledGame> first = pool.acquire({Role::Spy, Role::Judge});
+        const Game *address = &first->game;
+        first->players[0].gather();
+        pool.release(std::move(first));
+        CHECK(pool.available() == 1);
+
+        std::unique_ptr<PooledGame> other = pool.acquire({Role::Judge, Role::Spy});
+        CHECK(&other->game != address);
+        std::unique_ptr<PooledGame> again = pool.acquire({Role::Spy, Role::Judge});
+        CHECK(&again->game == address);
+        CHECK(again->players[0].coins() == 0);
+        CHECK(again->game.turn() == "P0");
+        CHECK(pool.created() == 2);
+    }
+
+    SUBCASE("Pooled simulations match fresh games")
+    {
+        SimulationConfig config;
+        config.lineup = {Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge, Role::Merchant};
+        config.games = 50;
+        RandomPolicy policy;
+        Simulator pooled(config, vector<Policy *>(config.lineup.size(), &policy));
+        SimulationStats stats;
+        for (size_t g = 0; g < config.games; ++g)
+        {
+            // A new simulator never reuses a game, so this is the unpooled result.
+            Simulator fresh_simulator(config, vector<Policy *>(config.lineup.size(), &policy));
+            SimulationStats unused;
+            CHECK(pooled.play_one(g, stats) == fresh_simulator.play_one(g, unused));
+        }
+    }
+}
+
+TEST_CASE("Player Arena")
+{
+    Game game;
+    PlayerArena arena;
+    const Role lineup[] = {Role::Governor, Role::Spy, Role::Baron, Role::General, Role::Judge, Role::Merchant};
+    for (size_t i = 0; i < 6; ++i)
+    {
+        Player &player = arena.create(game, lineup[i], "P" + std::to_string(i));
+        CHECK(player.roleType() == lineup[i]);
+        CHECK(player.seat() == i);
+        CHECK(game.get_players()[i] == &player);
+    }
+    REQUIRE(arena.size() == 6);
+    for (size_t i = 1; i < 6; ++i)
+    {
+        const char *previous = reinterpret_cast<const char *>(&arena[i - 1]);
+        CHECK(reinterpret_cast<const char *>(&arena[i]) - previous == static_cast<std::ptrdiff_t>(sizeof(Player)));
+    }
+    CHECK_THROWS_AS(arena.create(game, Role::Spy, "Extra"), std::runtime_error);
+
+    // Cross-references are seat handles that resolve back to the arena's players.
+    Player &governor = arena[0];
+    Player &spy = arena[1];
+    Player &general = arena[3];
+    governor.addCoins(7);
+    spy.addCoins(1);
+    governor.arrest(spy);
+    CHECK(governor.getLastArrestedTarget() == &spy);
+    spy.gather();
+    arena[2].gather();
+    general.gather();
+    arena[4].gather();
+    arena[5].gather();
+    governor.coup(general);
+    CHECK(game.getPlayerToSave() == &general);
+    CHECK(governor.getAggressorInLastCoup() == nullptr);
+
+    const GameState saved = GameState::capture(game);
+    CHECK(saved.players[0].last_arrested == 1);
+    CHECK(saved.save_target == 3);
+    CHECK(game.hash() == saved.hash());
+    game.reset();
+    CHECK(governor.getLastArrestedTarget() == nullptr);
+    CHECK(game.getPlayerToSave() == nullptr);
+    saved.restore(game);
+    CHECK(governor.getLastArrestedTarget() == &spy);
+    CHECK(game.getPlayerToSave() == &general);
+}
+
+TEST_CASE("Active Player Tracking")
+{
+    Game game;
+    PlayerArena arena;
+    const Role lineup[] = {Role::Governor, Role::Spy, Role::General, Role::Judge};
+    for (size_t i = 0; i < 4; ++i)
+    {
+        arena.create(game, lineup[i], "P" + std::to_string(i));
+    }
+    Player &governor = arena[0];
+    Player &spy = arena[1];
+    Player &general = arena[2];
+    CHECK(game.active_players_count() == 4);
+
+    governor.addCoins(7);
+    general.addCoins(5);
+    const GameState before = GameState::capture(game);
+    governor.coup(spy);
+    CHECK(game.active_players_count() == 3);
+    CHECK(game.players() == std::vector<std::string>{"P0", "P2", "P3"});
+    CHECK(game.turn() == "P2"); // The eliminated seat is skipped.
+
+    general.undo(spy);
+    CHECK(game.active_players_count() == 4);
+    CHECK(game.players().size() == 4);
+
+    // Restoring a snapshot rebuilds the tracking from the player flags.
+    const GameState after = GameState::capture(game);
+    before.restore(game);
+    CHECK(game.active_players_count() == 4);
+    CHECK(game.turn() == "P0");
+    after.restore(game);
+    CHECK(game.turn() == "P2");
+
+    // Eliminate everyone but the Judge; the turn wraps around to the survivor.
+    governor.eliminate();
+    spy.eliminate();
+    general.eliminate();
+    CHECK(game.active_players_count() == 1);
+    CHECK(game.winner() == "P3");
+    CHECK_THROWS_AS(game.turn(), std::runtime_error);
+
+    game.reset();
+    CHECK(game.active_players_count() == 4);
+    CHECK(game.turn() == "P0");
+}
+
+TEST_CASE("Large Lobby")
+{
+    SUBCASE("Seat set")
+    {
+        SeatSet seats(10000);
+        CHECK(seats.empty());
+        CHECK(seats.find(0) == SeatSet::NONE);
+        seats.insert(5);
+        seats.insert(4100);
+        seats.insert(9999);
+        seats.insert(4100);
+        CHECK(seats.size() == 3);
+        CHECK(seats.find(0) == 5);
+        CHECK(seats.find(6) == 4100);
+        CHECK(seats.find(4101) == 9999);
+        CHECK(seats.find(10000) == SeatSet::NONE);
+        CHECK(seats.find_circular(9999) == 9999);
+        seats.erase(9999);
+        CHECK(seats.find_circular(4101) == 5);
+        CHECK(seats.contains(4100));
+        CHECK_FALSE(seats.contains(9999));
+        seats.clear();
+        CHECK(seats.size() == 0);
+        CHECK(seats.find(0) == SeatSet::NONE);
+    }
+
+    SUBCASE("Configurable size")
+    {
+        CHECK_THROWS_AS(Game(1), std::runtime_error);
+        CHECK_THROWS_AS(Game(MAX_LOBBY_PLAYERS + 1), std::runtime_error);
+        Game table;
+        CHECK(table.max_players() == DEFAULT_MAX_PLAYERS);
+        std::vector<std::unique_ptr<Player>> six;
+        for (size_t i = 0; i < 6; ++i)
+        {
+            six.push_back(make_player(table, Role::Governor, "P" + std::to_string(i)));
+        }
+        CHECK_THROWS_AS(Governor(table, "Seventh"), std::runtime_error);
+    }
+
+    SUBCASE("A thousand players")
+    {
+        const size_t count = 1000;
+        Game lobby(count);
+        std::vector<std::unique_ptr<Player>> players;
+        for (size_t i = 0; i < count; ++i)
+        {
+            players.push_back(make_player(lobby, i == 0 ? Role::Spy : Role::Governor, "P" + std::to_string(i)));
+        }
+        CHECK(lobby.active_players_count() == count);
+        CHECK(lobby.players().size() == count);
+        CHECK_THROWS_AS(lobby.legal_actions(*players[0]), std::runtime_error);
+
+        // Turns skip long runs of eliminated seats, across word boundaries.
+        for (size_t i = 1; i < 900; ++i)
+        {
+            players[i]->eliminate();
+        }
+        CHECK(lobby.active_players_count() == count - 899);
+        CHECK(lobby.turn() == "P0");
+        players[0]->gather();
+        CHECK(lobby.turn() == "P900");
+        for (size_t i = 900; i < count; ++i)
+        {
+            players[i]->gather();
+        }
+        CHECK(lobby.turn() == "P0");
+
+        // Seat handles reach past the 8-bit range.
+        players[0]->arrest(*players[950]);
+        CHECK(players[0]->getLastArrestedTarget() == players[950].get());
+
+        // Single actions are checked without a target mask.
+        CHECK(lobby.is_legal(*players[900], {ActionType::Gather, NO_TARGET}));
+        CHECK_FALSE(lobby.is_legal(*players[901], {ActionType::Gather, NO_TARGET}));
+        CHECK_FALSE(lobby.is_legal(*players[900], {ActionType::Coup, 950}));
+        CHECK_FALSE(lobby.is_legal(*players[900], {ActionType::Arrest, 5}));
+        CHECK(lobby.is_legal(*players[998], {ActionType::Undo, 0}) == false);
+
+        // Coin reveals go stale when the coins change, at any seat.
+        lobby.set_hidden_coins(true);
+        const Spy &spy = static_cast<const Spy &>(*players[0]);
+        CHECK_FALSE(lobby.can_see_coins(spy, *players[999]));
+        spy.spyOn(*players[999]);
+        CHECK(lobby.can_see_coins(spy, *players[999]));
+        CHECK_FALSE(lobby.can_see_coins(*players[998], *players[999]));
+        players[999]->addCoins(1);
+        CHECK_FALSE(lobby.can_see_coins(spy, *players[999]));
+        spy.spyOn(*players[999]);
+        CHECK(lobby.can_see_coins(spy, *players[999]));
+
+        for (size_t i = 900; i < count - 1; ++i)
+        {
+            players[i]->eliminate();
+        }
+        players[0]->eliminate();
+        CHECK(lobby.winner() == "P999");
+
+        lobby.reset();
+        CHECK(lobby.active_players_count() == count);
+        CHECK_FALSE(lobby.can_see_coins(spy, *players[999]));
+        CHECK(lobby.turn() == "P0");
+    }
+
+    SUBCASE("is_legal() matches legal_actions()")
+    {
+        GamePool pool;
+        std::unique_ptr<PooledGame> table = pool.acquire({Role::Governor, Role::Spy, Role::Baron,
+                                                          Role::General, Role::Judge, Role::Merchant});
+        Game &game = table->game;
+        CounterRng rng(3, 0, 0);
+        for (size_t step = 0; step < 300 && game.active_players_count() > 1; ++step)
+        {
+            for (Player *player : game.get_players())
+            {
+                const LegalActions legal = game.legal_actions(*player);
+                for (size_t type = 1; type < ACTION_TYPE_COUNT; ++type)
+                {
+                    const ActionType action = static_cast<ActionType>(type);
+                    if (action == ActionType::Gather || action == ActionType::Tax ||
+                        action == ActionType::Bribe || action == ActionType::Invest)
+                    {
+                        CHECK(game.is_legal(*player, {action, NO_TARGET}) == legal.can(action));
+                        continue;
+                    }
+                    CHECK_FALSE(game.is_legal(*player, {action, NO_TARGET}));
+                    for (size_t seat = 0; seat < game.get_players().size(); ++seat)
+                    {
+                        CHECK(game.is_legal(*player, {action, static_cast<int>(seat)}) == legal.can(action, seat));
+                    }
+                }
+            }
+            Player *actor = game.current_player();
+            Action options[MAX_ACTIONS];
+            const size_t count = game.legal_actions(*actor).expand(options, MAX_ACTIONS);
+            const Action pick = options[rng.uniform(static_cast<std::uint32_t>(count))];
+            if (pick.type == ActionType::Undo)
+            {
+                actor->try_undo(*game.get_players()[pick.target]);
+                continue;
+            }
+            switch (pick.type)
+            {
+            case ActionType::Gather:
+                actor->try_gather();
+                break;
+            case ActionType::Tax:
+                actor->try_tax();
+                break;
+            case ActionType::Bribe:
+                actor->try_bribe();
+                break;
+            case ActionType::Invest:
+                static_cast<Baron *>(actor)->try_invest();
+                break;
+            case ActionType::Arrest:
+                actor->try_arrest(*game.get_players()[pick.target]);
+                break;
+            case ActionType::Sanction:
+                actor->try_sanction(*game.get_players()[pick.target]);
+                break;
+            default:
+                actor->try_coup(*game.get_players()[pick.target]);
+                break;
+            }
+        }
+    }
+
+    SUBCASE("Simulated lobby")
+    {
+        SimulationConfig config;
+        for (size_t i = 0; i < 150; ++i)
+        {
+            const Role roles[] = {Role::Player, Role::Governor, Role::Spy, Role::Baron,
+                                  Role::General, Role::Judge, Role::Merchant};
+            config.lineup.push_back(roles[i % 7]);
+        }
+        config.games = 3;
+        config.max_actions = 20000;
+        RandomPolicy policy;
+        Simulator simulator(config, std::vector<Policy *>(config.lineup.size(), &policy));
+        const SimulationStats stats = simulator.run();
+        CHECK(stats.games == 3);
+        CHECK(stats.actions > 150);
+        CHECK(stats.undos > 0);
+        size_t wins = 0;
+        for (size_t count : stats.wins_by_seat)
+        {
+            wins += count;
+        }
+        CHECK(wins + stats.draws == 3);
+
+        Simulator again(config, std::vector<Policy *>(config.lineup.size(), &policy));
+        SimulationStats first;
+        SimulationStats second;
+        CHECK(again.play_one(1, first) == simulator.play_one(1, second));
+        CHECK(first.actions == second.actions);
+
+        // Every seat may cancel a bribe, but only a bounded sample is asked.
+        struct BribeCounter : RandomPolicy
+        {
+            size_t bribes = 0;
+            BribeCounter() : RandomPolicy(1.0) {}
+            Action choose(const Game &game, const Player &self, const Action *legal, size_t count,
+                          CounterRng &rng) override
+            {
+                const Action action = RandomPolicy::choose(game, self, legal, count, rng);
+                bribes += action.type == ActionType::Bribe ? 1 : 0;
+                return action;
+            }
+        };
+        SimulationConfig judges;
+        judges.lineup.assign(300, Role::Judge);
+        judges.games = 1;
+        judges.max_actions = 5000;
+        BribeCounter counter;
+        Simulator bribes(judges, std::vector<Policy *>(judges.lineup.size(), &counter));
+        const SimulationStats bounded = bribes.run();
+        CHECK(counter.bribes > 0);
+        CHECK(bounded.undos > 0);
+        CHECK(bounded.undos <= counter.bribes * SAMPLED_REACTORS);
+    }
+}
+
+TEST_CASE("Allocation Tracking")
+{
+    reset_allocation_stats();
+    {
+        AllocationScope outer(EntryPoint::Turn);
+        AllocationScope inner(EntryPoint::Turn); // Already open: not counted again.
+        AllocationScope other(EntryPoint::Players);
+    }
+    CHECK(allocation_stats(EntryPoint::Turn).calls == 1);
+    CHECK(allocation_stats(EntryPoint::Players).calls == 1);
+    CHECK(std::string(to_string(EntryPoint::LastActionName)) == "getLastAction");
+
+    Game game;
+    PlayerArena arena;
+    arena.create(game, Role::Governor, "A player name too long for small-string storage");
+    arena.create(game, Role::Baron, "B");
+    reset_allocation_stats();
+    arena[0].gather();
+    arena[1].tax();
+    arena[0].undo(arena[1]);
+    arena[0].addCoins(3);
+    arena[0].sanction(arena[1]);
+    const std::vector<std::string> names = game.players();
+    const std::string name = arena[0].getName();
+
+    if (!allocation_tracking_enabled())
+    {
+        CHECK(allocation_stats(EntryPoint::Gather).calls == 0);
+        CHECK(total_allocations() == 0);
+        return;
+    }
+    // Actions allocate nothing; the string-returning queries do.
+    for (EntryPoint point : {EntryPoint::Gather, EntryPoint::Tax, EntryPoint::Undo, EntryPoint::Sanction})
+    {
+        CAPTURE(std::string(to_string(point)));
+        CHECK(allocation_stats(point).calls == 1);
+        CHECK(allocation_stats(point).allocations == 0);
+    }
+    CHECK(allocation_stats(EntryPoint::Players).allocations >= 2); // The vector and the long name.
+    CHECK(allocation_stats(EntryPoint::GetName).calls == 3);       // Once per name in players(), once directly.
+    CHECK(allocation_stats(EntryPoint::GetName).allocations == 2);
+    CHECK(total_allocations() >= allocation_stats(EntryPoint::Players).allocations);
+
+    // Over-aligned objects go through the aligned operator new, counted too.
+    struct alignas(64) CacheLine
+    {
+        char bytes[64];
+    };
+    const std::uint64_t before = total_allocations();
+    CacheLine *line = new CacheLine();
+    CHECK(reinterpret_cast<std::uintptr_t>(line) % 64 == 0);
+    delete line;
+    CHECK(total_allocations() == before + 1);
+}
+
+TEST_CASE("Hardware Performance Counters")
+{
+    PerfByAction by_action;
+    by_action.record(ActionType::Tax, PerfSample{100, 200, 3, 4});
+    by_action.record(ActionType::Tax, PerfSample{10, 20, 0, 1});
+    PerfByAction merged;
+    merged += by_action;
+    CHECK(merged.calls[static_cast<size_t>(ActionType::Tax)] == 2);
+    CHECK(merged.totals[static_cast<size_t>(ActionType::Tax)].instructions == 220);
+    CHECK(merged.totals[static_cast<size_t>(ActionType::Tax)].branch_misses == 5);
+
+    SimulationConfig config;
+    config.lineup = {Role::Governor, Role::Spy, Role::Baron, Role::Judge};
+    config.games = 20;
+    config.perf_counters = true;
+    RandomPolicy policy;
+    Simulator simulator(config, std::vector<Policy *>(config.lineup.size(), &policy));
+    const SimulationStats stats = simulator.run();
+
+    PerfCounters counters;
+    size_t recorded = 0;
+    for (size_t i = 0; i < ACTION_TYPE_COUNT; ++i)
+    {
+        recorded += stats.perf.calls[i];
+    }
+    if (!counters.available())
+    {
+        // Not permitted here (container, VM, or perf_event_paranoid); runs go on uncounted.
+        CHECK_FALSE(counters.error().empty());
+        CHECK(counters.read().cycles == 0);
+        CHECK(recorded == 0);
+        return;
+    }
+    CHECK(counters.error().empty());
+    const PerfSample before = counters.read();
+    volatile std::uint64_t sum = 0;
+    for (std::uint64_t i = 0; i < 100000; ++i)
+    {
+        sum += i;
+    }
+    const PerfSample work = counters.since(before);
+    CHECK(work.instructions >= 100000);
+    CHECK(work.cycles > 0);
+    CHECK(recorded == stats.actions + stats.undos);
+}
+
+TEST_CASE("Trace Spans")
+{
+    clear_trace();
+    {
+        TraceSpan span("unit \"span\"");
+    }
+    std::thread worker([]
+                       { TraceSpan span("worker"); });
+    worker.join();
+    CHECK(trace_size() == 2);
+    flag_last_trace(TRACE_THREW);
+
+    Game game;
+    PlayerArena arena;
+    arena.create(game, Role::Governor, "A");
+    arena.create(game, Role::Spy, "B");
+    const size_t before = trace_size();
+    arena[0].gather();
+#ifdef COUP_TRACE
+    CHECK(trace_size() == before + 2); // try_gather and the next_turn inside it, not the wrapper.
+#else
+    CHECK(trace_size() == before);
+#endif
+    CHECK_THROWS(arena[0].gather()); // Not A's turn.
+    game.turn();
+
+    std::ostringstream json;
+    write_chrome_trace(json);
+    const std::string text = json.str();
+    CHECK(text.find("\"traceEvents\":[") != std::string::npos);
+    CHECK(text.find("{\"name\":\"unit \\\"span\\\"\",\"ph\":\"X\",\"pid\":1,\"tid\":") != std::string::npos);
+    CHECK(text.find("\"name\":\"worker\"") != std::string::npos);
+    const std::string threw = "\"args\":{\"threw\":true}";
+    CHECK(text.find(threw) != std::string::npos);
+#ifdef COUP_TRACE
+    CHECK(text.find("\"name\":\"Player::gather\"") == std::string::npos);
+    CHECK(text.find("\"name\":\"Player::try_gather\"") != std::string::npos);
+    CHECK(text.find(threw, text.find(threw) + 1) != std::string::npos); // The failed gather's try_gather span.
+    CHECK(text.find("\"name\":\"Game::next_turn\"") != std::string::npos);
+    CHECK(text.find("\"name\":\"Game::turn\"") != std::string::npos);
+#else
+    CHECK(trace_size() == 2); // Engine spans are compiled out.
+#endif
+
+    // A full ring keeps the newest spans.
+    clear_trace();
+    for (size_t i = 0; i < TRACE_RING_SIZE + 10; ++i)
+    {
+        record_trace("filler", i, i + 1);
+    }
+    CHECK(trace_size() == TRACE_RING_SIZE);
+    clear_trace();
+    CHECK(trace_size() == 0);
+}
+
+TEST_CASE("Latency Histograms")
+{
+    LatencyHistogram histogram;
+    CHECK(histogram.percentile(99.9) == 0);
+    for (std::uint64_t ns = 1; ns <= 1000; ++ns)
+    {
+        histogram.record(ns);
+    }
+    histogram.record(5000000); // One exception-path outlier.
+    CHECK(histogram.count() == 1001);
+    CHECK(histogram.min() == 1);
+    CHECK(histogram.max() == 5000000);
+    // Buckets keep values to within 1/64 of their size.
+    CHECK(histogram.percentile(50) >= 501);
+    CHECK(histogram.percentile(50) <= 501 + 501 / 64);
+    CHECK(histogram.percentile(99) >= 991);
+    CHECK(histogram.percentile(99) <= 991 + 991 / 64);
+    CHECK(histogram.percentile(99.95) == 5000000);
+    CHECK(histogram.percentile(100) == 5000000);
+    histogram.record(LatencyHistogram::MAX_VALUE + 1);
+    CHECK(histogram.max() == LatencyHistogram::MAX_VALUE);
+
+    std::ostringstream percentiles;
+    histogram.write_percentiles(percentiles);
+    CHECK(percentiles.str().find("Total count = 1002") != std::string::npos);
+    histogram.reset();
+    CHECK(histogram.count() == 0);
+
+    CHECK(undo_latency_key(Role::Spy) == LatencyKey::UndoSpy);
+    CHECK(undo_latency_key(Role::Merchant) == LatencyKey::UndoOther);
+    CHECK(std::string(to_string(LatencyKey::UndoGeneral)) == "undo[General]");
+
+    Game game;
+    PlayerArena arena;
+    arena.create(game, Role::Player, "A");
+    arena.create(game, Role::Governor, "B");
+    reset_latency_histograms();
+    arena[0].tax();
+    arena[1].undo(arena[0]);
+    CHECK_THROWS(arena[1].bribe()); // Not enough coins: the failed call is timed too.
+
+    std::ostringstream snapshot;
+    write_latency_snapshot(snapshot);
+    if (!latency_recording_enabled())
+    {
+        CHECK(latency_histogram(LatencyKey::Tax).count() == 0);
+        return;
+    }
+    CHECK(latency_histogram(LatencyKey::Tax).count() == 1);
+    CHECK(latency_histogram(LatencyKey::UndoGovernor).count() == 1);
+    CHECK(latency_histogram(LatencyKey::Bribe).count() == 1);
+    CHECK(latency_histogram(LatencyKey::Gather).count() == 0);
+    CHECK(snapshot.str().find("undo[Governor]") != std::string::npos);
+    CHECK(snapshot.str().find("gather") == std::string::npos);
+}